@@ -0,0 +1,62 @@
+/*
+ * AnalogSensor.cpp
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR_IMPLEMENTATION
+  #define _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR_IMPLEMENTATION
+
+  #include <Arduino.h>
+
+  #include "../infrastructure/AnalogSensor.h"
+
+  template<int WINDOW>
+  AnalogSensor<WINDOW>::AnalogSensor(Coordinator &coordinator, const SensorType type, const int pin, const unsigned long period,
+      const unsigned long reportInterval): Sensor(type, SENSOR_POLLED, pin, period), coordinator(coordinator), reportInterval(reportInterval) {
+    lastReport = millis();
+  }
+
+  template<int WINDOW>
+  WindowedAggregate<long, WINDOW> &AnalogSensor<WINDOW>::getAggregate() {
+    return aggregate;
+  }
+
+  template<int WINDOW>
+  void AnalogSensor<WINDOW>::sample(unsigned long now) {
+    const CrossingResult crossing = aggregate.add(read());
+
+    if(crossing != CROSSING_NONE) {
+      String data = (crossing == CROSSING_RISE) ? "X:+" : "X:-";
+
+      data += String((long) aggregate.summarize().ema);
+
+      coordinator.sendUpdate(getId(), data);
+    }
+
+    if((now - lastReport) < reportInterval) {
+      return;
+    }
+
+    const WindowSummary<long> summary = aggregate.summarize();
+    String data = "S:";
+
+    data += String(summary.min);
+    data += ',';
+    data += String(summary.max);
+    data += ',';
+    data += String((long) summary.mean);
+    data += ',';
+    data += String((long) summary.ema);
+
+    lastReport = now;
+
+    // Summaries are telemetry, so they must not hold up threshold crossings or other sensors' events.
+    coordinator.sendUpdate(getId(), data, NULL, LANE_BULK);
+  }
+
+  template<int WINDOW>
+  long AnalogSensor<WINDOW>::read() {
+    return analogRead(getPin());
+  }
+#endif /* _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR_IMPLEMENTATION */
@@ -0,0 +1,70 @@
+/*
+ * AnalogSensor.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR
+  #define _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR
+
+  #include "Coordinator.h"
+  #include "Sensor.h"
+  #include "WindowedAggregate.h"
+
+  /**
+   * AnalogSensor is a polled Sensor for analog inputs, such as ambient light or temperature.  Rather than reporting each sample,
+   * samples are aggregated over a window of the last WINDOW samples and the AnalogSensor only reports
+   *  - a summary of the window every reporting interval, with the data `S:MIN,MAX,MEAN,EMA`, and
+   *  - threshold crossings as soon as they occur, with the data `X:+EMA` for a rise or `X:-EMA` for a fall.
+   * This keeps network traffic constant no matter how often the input is sampled, while the RAM used by each sensor is fixed at
+   * compile time by WINDOW.
+   *
+   * Subclasses can override `read()` to convert the raw reading into a meaningful unit.
+   */
+  template<int WINDOW>
+  class AnalogSensor: public Sensor {
+    public:
+      /**
+       * Creates a new AnalogSensor.
+       *
+       * @param coordinator (Coordinator &) - the Coordinator used to send reports to the Master node
+       * @param type (const SensorType) - the type of the sensor
+       * @param pin (const int) - the analog pin to which the sensor is attached
+       * @param period (const unsigned long) - the number of milliseconds between samples
+       * @param reportInterval (const unsigned long) - the number of milliseconds between summary reports
+       */
+      AnalogSensor(Coordinator &coordinator, const SensorType type, const int pin, const unsigned long period, const unsigned long reportInterval);
+
+      /**
+       * Returns the aggregate of this sensor's samples.  This can be used to configure the thresholds for crossing reports.
+       *
+       * @return (WindowedAggregate<long, WINDOW> &) the aggregate of this sensor's samples
+       */
+      WindowedAggregate<long, WINDOW> &getAggregate();
+
+      /**
+       * Samples the input, reporting a threshold crossing or the summary of the window if necessary.
+       *
+       * @param now (unsigned long) - the current time, in milliseconds
+       */
+      void sample(unsigned long now);
+
+    protected:
+      /**
+       * Reads the current value of the input.
+       *
+       * @return (long) the current value of the input.  Default: the raw value returned by analogRead()
+       */
+      virtual long read();
+
+    private:
+      Coordinator &coordinator;
+      WindowedAggregate<long, WINDOW> aggregate;
+
+      const unsigned long reportInterval;
+      unsigned long lastReport;
+  };
+
+  #include "../infrastructure/AnalogSensor.cpp"
+
+#endif /* _C1MOORE_INFRASTRUCTURE_ANALOGSENSOR */
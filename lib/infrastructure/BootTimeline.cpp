@@ -0,0 +1,39 @@
+/*
+ * BootTimeline.cpp
+ *
+ *      Author: c1moore
+ */
+#include <Arduino.h>
+
+#include "BootTimeline.h"
+
+static unsigned long bootEventTimes[BOOT_EVENT_COUNT] = { 0 };
+
+void recordBootEvent(const BootEvent event) {
+  if(bootEventTimes[event] != 0) {
+    return;
+  }
+
+  // 0 means the milestone has not been reached, so a milestone reached in the first millisecond is recorded as 1.
+  const unsigned long now = millis();
+
+  bootEventTimes[event] = (now == 0) ? 1 : now;
+}
+
+unsigned long getBootEventTime(const BootEvent event) {
+  return bootEventTimes[event];
+}
+
+String formatBootTimeline() {
+  String timeline;
+
+  for(int event = 0; event < BOOT_EVENT_COUNT; event++) {
+    if(event > 0) {
+      timeline += ',';
+    }
+
+    timeline += String(bootEventTimes[event]);
+  }
+
+  return timeline;
+}
@@ -0,0 +1,49 @@
+/*
+ * BootTimeline.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_BOOTTIMELINE
+  #define _C1MOORE_INFRASTRUCTURE_BOOTTIMELINE
+
+  #include <Arduino.h>
+
+  /**
+   * BootEvent enumerates the milestones of bringing the device up, in the order they are expected to occur.
+   */
+  enum BootEvent {
+    BOOT_SCHEDULER_START,   // The Scheduler took control; sensors and local logic are running.
+    BOOT_WIFI_CONNECTED,    // The device joined the network.
+    BOOT_MASTER_CONNECTED,  // The connection to the Master node was opened.
+    BOOT_FIRST_ACK,         // The Master node answered a request for the first time.
+    BOOT_EVENT_COUNT
+  };
+
+  /**
+   * Records the time the milestone was reached.  Only the first time each milestone is reached is recorded, so this can be
+   * called every time the milestone is reached again, such as after reconnecting.
+   *
+   * @param event (const BootEvent) - the milestone reached
+   */
+  void recordBootEvent(const BootEvent event);
+
+  /**
+   * Returns the time the milestone was reached.
+   *
+   * @param event (const BootEvent) - the milestone
+   *
+   * @return (unsigned long) the time, in milliseconds since the device started, the milestone was reached or 0 if it has not
+   *  been reached
+   */
+  unsigned long getBootEventTime(const BootEvent event);
+
+  /**
+   * Formats the boot timeline so it can be reported to the Master node.  The milestones are listed in order, separated by
+   * commas, with 0 for milestones that have not been reached.  For example: "12,1840,1905,1932".
+   *
+   * @return (String) the formatted boot timeline
+   */
+  String formatBootTimeline();
+
+#endif /* _C1MOORE_INFRASTRUCTURE_BOOTTIMELINE */
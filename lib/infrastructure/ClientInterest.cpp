@@ -0,0 +1,24 @@
+/*
+ * ClientInterest.cpp
+ *
+ *      Author: c1moore
+ */
+#include "ClientInterest.h"
+
+ClientInterest::ClientInterest(WiFiClient &client, const ClientEvent event): client(client), event(event) { }
+
+bool ClientInterest::poll() {
+  switch(event) {
+    case CLIENT_READABLE:
+      // A closed connection is reported as readable so the waiting process can find out the connection was closed.
+      return (client.available() > 0 || !client.connected());
+
+    case CLIENT_WRITABLE:
+      return (client.availableForWrite() > 0);
+
+    case CLIENT_CONNECTED:
+      return client.connected();
+  }
+
+  return false;
+}
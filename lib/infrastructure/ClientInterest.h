@@ -0,0 +1,49 @@
+/*
+ * ClientInterest.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_CLIENTINTEREST
+  #define _C1MOORE_INFRASTRUCTURE_CLIENTINTEREST
+
+  #include <ESP8266WiFi.h>
+
+  #include "../scheduler/Pollable.h"
+
+  /**
+   * ClientEvent enumerates the events of a WiFiClient a process can wait on.
+   */
+  enum ClientEvent {
+    CLIENT_READABLE,  // The client has received data that can be read or the connection has been closed.
+    CLIENT_WRITABLE,  // The client can accept more data to send.
+    CLIENT_CONNECTED  // The client has finished connecting.
+  };
+
+  /**
+   * ClientInterest registers interest in a WiFiClient event so a process can wait for the event using `Scheduler::await()`
+   * instead of repeatedly polling the client and sleeping.  For example, to wait up to 2 seconds for a response:
+   *
+   *    ClientInterest readable(client, CLIENT_READABLE);
+   *
+   *    if(scheduler.await(readable, 2000) == 0) {
+   *      // Parse the response.
+   *    }
+   */
+  class ClientInterest: public Pollable {
+    public:
+      ClientInterest(WiFiClient &client, const ClientEvent event);
+
+      /**
+       * Checks whether the event has occurred.
+       *
+       * @return (bool) true iff the event has occurred
+       */
+      bool poll();
+
+    private:
+      WiFiClient &client;
+      const ClientEvent event;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_CLIENTINTEREST */
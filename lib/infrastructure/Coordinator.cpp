@@ -5,62 +5,849 @@
  *      Author: c1moore
  */
 #include <Arduino.h>
+#include <EEPROM.h>
 #include <ESP8266WiFi.h>
 
 #include "../scheduler/Scheduler.h"
+#include "BootTimeline.h"
 #include "Coordinator.h"
+#include "DatagramTransport.h"
+#include "MasterClock.h"
+#include "MasterConnection.h"
+#include "MasterEndpoints.h"
+#include "OutboundQueue.h"
+#include "RadioScheduler.h"
 #include "PersistentDID.h"
+#include "PersistentLayout.h"
+#include "RegistrationCache.h"
+#include "RequestThrottle.h"
+#include "UpdateBatch.h"
+#include "DCP/DCPCompletion.h"
+#include "DCP/DCPMailbox.h"
 #include "DCP/DCPRequest.h"
 #include "DCP/DCPResponse.h"
 
 class Coordinator::Implementation {
   public:
+    /**
+     * RegistrationState tracks the registration of the sub devices with the Master node.
+     */
+    enum RegistrationState {
+      REGISTRATION_IDLE,          // No registration request is in flight.  The next run will send one once the Master node is reachable.
+      REGISTRATION_REVALIDATING,  // The cached session is being revalidated.
+      REGISTRATION_REGISTERING,   // The sub devices are being registered.
+      REGISTRATION_DONE           // The Master node accepted the registration.
+    };
+
     int did = 0;
+    String sessionId = "0";
+
+    RegistrationCache registrations;
+    RegistrationState registrationState = REGISTRATION_IDLE;
+    DCPCompletion registration;             // The handle of the registration request in flight.
+    bool registrationFailed = false;        // Whether the last registration request failed and should be retried later.
+    unsigned long registrationFailedAt = 0; // The time, in milliseconds, the last registration request failed.
+
+    MasterEndpoints endpoints;
+    MasterConnection connection;
+    DatagramTransport datagrams;
+    RadioScheduler *radio = NULL;
+    RequestThrottle throttle;
+
+    MasterClock clock;
+    DCPCompletion clockSync;              // The handle of the clock synchronization request in flight.
+    bool clockSyncPending = false;        // Whether a clock synchronization request was sent and has not been handled.
+    bool clockSyncStarted = false;        // Whether a clock synchronization request was ever sent.
+    unsigned long clockSyncSent = 0;      // The local time, in milliseconds, the last clock synchronization request was sent.
+    bool bootReported = false;
+    unsigned long unroutedCount = 0;  // The number of pushed messages addressed to a sub device without a mailbox.
+
+    OutboundQueue lanes[LANE_COUNT];  // The queue of each OutboundLane.  Only the normal lane spills to EEPROM.
+    UpdateBatch batch;                // Reused by every flush to avoid reallocating its records.
 
-    Implementation() {}
+    BatchStats batchStats = { 0, 0, 0, 0, 0, 0, 0 };
+    LaneStats laneStats[LANE_COUNT] = {};
+    unsigned long batchWindow[LANE_COUNT] = { 0, COALESCE_WINDOW, BULK_WINDOW };
+    unsigned int batchBudget[LANE_COUNT] = { BATCH_BYTE_BUDGET, BATCH_BYTE_BUDGET, BULK_CHUNK_SIZE };
+
+    Implementation(Scheduler &scheduler): registrations(REGISTRATION_ADDRESS), connection(endpoints), datagrams(endpoints),
+        lanes{ { 0, 0 }, { OUTBOUND_SPILL_ADDRESS, OUTBOUND_SPILL_SIZE }, { 0, 0 } }, scheduler(scheduler) {}
     ~Implementation() {}
 
+    /**
+     * Builds the resource used to access the state of a sub device.
+     *
+     * @param subDeviceId (uint16_t) - the unique ID of the sub device
+     *
+     * @return (String) the resource for the sub device
+     */
+    String resource(uint16_t subDeviceId) const {
+      return String("/update/") + String((unsigned int) subDeviceId);
+    }
+
+    /**
+     * Checks whether any request is waiting for a response.
+     *
+     * @return (bool) true iff a request is waiting for a response
+     */
+    bool busy() const {
+      return (inFlightCount > 0 || datagrams.getOutstanding() > 0);
+    }
+
+    /**
+     * Writes the request on the persistent connection without waiting for the response.  If the radio is sleeping, it is turned
+     * on early; callers that can wait for the next burst should check `radioAwake()` first.  The response is matched to the
+     * request by its SESSION_TIMESTAMP when `receive()` reads it.  If the request cannot be sent, `completion` is completed
+     * immediately with RESPONSE_TIMEOUT.
+     *
+     * @param request (DCPRequest &) - the request to send
+     * @param completion (DCPCompletion *) - the handle to complete once the response arrives or NULL
+     * @param lane (const int) _optional_ - the OutboundLane whose updates the request carries, which must be acknowledged or
+     *  released once it is answered.  Default: -1, the request carries no queued updates
+     * @param records (const int) _optional_ - the number of updates the request carries.  Default: 0
+     *
+     * @return (int) 0 if the request was sent; -1 if the connection is not open; -2 if too many requests are in flight; -3 if
+     *  the request could not be written; -5 if the throttle held the request back
+     */
+    int send(DCPRequest &request, DCPCompletion *completion, const int lane = -1, const int records = 0) {
+      if(completion != NULL) {
+        completion->reset();
+      }
+
+      if(inFlightCount >= MAX_IN_FLIGHT) {
+        fail(completion, 0);
+
+        return -2;
+      }
+
+      if(!throttle.take()) {
+        fail(completion, 0);
+
+        return -5;
+      }
+
+      if(!radioAwake()) {
+        radio->breakthrough();
+      }
+
+      WiFiClient *client = connection.acquire();
+
+      if(client == NULL) {
+        fail(completion, 0);
+
+        return -1;
+      }
+
+      if(!request.write(*client)) {
+        disconnect();
+        fail(completion, 0);
+
+        return -3;
+      }
+
+      InFlightRequest &entry = inFlight[inFlightCount++];
+
+      entry.timestamp = request.getTimestamp();
+      entry.sent = millis();
+      entry.completion = completion;
+      entry.lane = lane;
+      entry.records = records;
+      entry.bytes = request.getBody().length();
+
+      if(lane == LANE_BULK) {
+        bulkInFlight++;
+      }
+
+      return 0;
+    }
+
+    /**
+     * Checks whether the queued updates of a lane should be sent: the oldest has waited for the lane's coalescing window or
+     * they have reached its byte budget.
+     *
+     * @param lane (const int) - the OutboundLane
+     *
+     * @return (bool) true iff a batch should be sent
+     */
+    bool batchDue(const int lane) const {
+      const OutboundQueue &queue = lanes[lane];
+
+      return queue.waitingCount() > 0 && (queue.age() >= batchWindow[lane] || queue.waitingBytes() >= batchBudget[lane]);
+    }
+
+    /**
+     * Sends the oldest queued updates of a lane in a batch.  A batch with a single record is sent as a plain update so the
+     * Master does not have to unpack it.  The updates stay queued until the Master acknowledges them.  Nothing is sent until
+     * the sub devices are registered, since the Master could not attribute the updates.
+     *
+     * The last request slot is kept for the urgent lane and only BULK_IN_FLIGHT bulk requests are sent at once, so urgent
+     * updates are never stuck behind requests from the lower lanes.  For the same reason, urgent updates turn the radio on
+     * between bursts while the other lanes wait for the next one.
+     *
+     * Batches are kept within the request limit the Master node advertised, so a batch it rejected as too long is split across
+     * several requests when it is sent again.
+     *
+     * @param lane (const int) - the OutboundLane
+     *
+     * @return (int) 0 if a batch was sent; 1 if no update was waiting; -4 if the radio is off; a negative error code as described
+     *  by `send()` otherwise
+     */
+    int flush(const int lane) {
+      if(connection.getState() != CONNECTION_CONNECTED || registrationState != REGISTRATION_DONE) {
+        return -1;
+      }
+
+      if(inFlightCount >= (lane == LANE_URGENT ? MAX_IN_FLIGHT : MAX_IN_FLIGHT - 1)) {
+        return -2;
+      }
+
+      if(lane == LANE_BULK && bulkInFlight >= BULK_IN_FLIGHT) {
+        return -2;
+      }
+
+      if(lane != LANE_URGENT && !radioAwake()) {
+        return -4;
+      }
+
+      if(!throttle.ready()) {
+        return -5;
+      }
+
+      OutboundQueue &queue = lanes[lane];
+      unsigned int budget = batchBudget[lane];
+
+      if(throttle.getRequestLimit() > 0 && throttle.getRequestLimit() < budget) {
+        budget = throttle.getRequestLimit();
+      }
+
+      const unsigned long delay = queue.age();
+      const int taken = queue.take(batch, budget);
+      const int records = batch.count();
+
+      if(records == 0) {
+        return 1;
+      }
+
+      const bool single = (records == 1);
+
+      DCPRequest request(POST, single ? resource(batch.getSubDeviceId(0)) : String("/updates"), sessionId);
+      request.setMessage(single ? batch.getData(0) : batch.encode());
+
+      const unsigned int bytes = batch.bytes();
+
+      batch.clear();
+
+      const int status = send(request, NULL, lane, records);
+
+      queue.dispatched(status == 0 ? request.getTimestamp() : 0);
+
+      // A batch that could not be sent stays queued, so it is only counted once it is actually sent.
+      if(status != 0) {
+        return status;
+      }
+
+      batchStats.batches++;
+      batchStats.records += records;
+      batchStats.merged += taken - records;
+      batchStats.bytes += bytes;
+      batchStats.totalDelay += delay;
+
+      if((unsigned int) records > batchStats.maxRecords) {
+        batchStats.maxRecords = records;
+      }
+
+      if(delay > batchStats.maxDelay) {
+        batchStats.maxDelay = delay;
+      }
+
+      LaneStats &stats = laneStats[lane];
+
+      stats.requests++;
+      stats.records += records;
+      stats.totalWait += delay;
+
+      if(delay > stats.maxWait) {
+        stats.maxWait = delay;
+      }
+
+      return 0;
+    }
+
+    /**
+     * Checks whether the radio is on.
+     *
+     * @return (bool) true iff the radio is on, which it always is without a RadioScheduler
+     */
+    bool radioAwake() const {
+      return (radio == NULL || radio->isAwake());
+    }
+
+    /**
+     * Registers the sub devices with the Master node once it is reachable.  If the configuration has not changed since the
+     * last restart, the cached session is revalidated instead; the sub devices are only registered again if the Master node
+     * refuses it.
+     */
+    void maintainRegistration() {
+      switch(registrationState) {
+        case REGISTRATION_IDLE:
+          if(connection.getState() != CONNECTION_CONNECTED || !radioAwake()) {
+            return;
+          }
+
+          if(registrationFailed && millis() - registrationFailedAt < REGISTRATION_RETRY) {
+            return;
+          }
+
+          if(!throttle.ready()) {
+            return;
+          }
 
+          if(registrations.matches()) {
+            revalidate();
+          } else {
+            reregister();
+          }
+          break;
+
+        case REGISTRATION_REVALIDATING:
+        case REGISTRATION_REGISTERING:
+          if(registration.isComplete()) {
+            registered(registration.getResponse());
+          }
+          break;
+
+        case REGISTRATION_DONE:
+          break;
+      }
+    }
+
+    /**
+     * Asks the Master node to confirm the cached session is still valid for the current configuration.
+     */
+    void revalidate() {
+      DCPRequest request(POST, "/session", sessionId);
+      request.setMessage(String((unsigned long) registrations.getConfigHash(), HEX));
+
+      registrationState = REGISTRATION_REVALIDATING;
+
+      // If the request cannot be sent, the handle is completed immediately and handled by the next run.
+      send(request, &registration);
+    }
+
+    /**
+     * Registers every sub device with the Master node in a single request.
+     */
+    void reregister() {
+      DCPRequest request(POST, "/register", sessionId);
+      request.setMessage(String((unsigned long) registrations.getConfigHash(), HEX) + "\n" + registrations.encode());
+
+      registrationState = REGISTRATION_REGISTERING;
+
+      send(request, &registration);
+    }
+
+    /**
+     * Handles the response to a registration request.
+     *
+     * @param response (const DCPResponse &) - the response
+     */
+    void registered(const DCPResponse &response) {
+      if(retryable(response.statusCode)) {
+        registrationState = REGISTRATION_IDLE;
+        registrationFailed = true;
+        registrationFailedAt = millis();
+
+        return;
+      }
+
+      registrationFailed = false;
+
+      if(registrationState == REGISTRATION_REVALIDATING) {
+        if(response.statusCode == SUCCESS_NOCONTENT) {
+          registrationState = REGISTRATION_DONE;
+        } else {
+          // The Master node no longer knows the session or has a different configuration for this device.
+          reregister();
+        }
+
+        return;
+      }
+
+      if(response.statusCode == SUCCESS && response.data.length() > 0) {
+        const int assignedId = response.deviceId.toInt();
+
+        if(assignedId > 0 && assignedId <= 0xff && assignedId != did) {
+          did = assignedId;
+
+          writeDeviceId(did, DEVICE_ID_ADDRESS);
+          EEPROM.commit();
+        }
+
+        sessionId = response.data;
+        registrations.store(sessionId);
+      }
+
+      // A Master node that refuses the registration outright will not accept it later either, so updates are not held back.
+      registrationState = REGISTRATION_DONE;
+    }
+
+    /**
+     * Exchanges timestamps with the Master node to synchronize with its clock (see MasterClock).  Exchanges are frequent until
+     * CLOCK_SAMPLES samples have been taken and every CLOCK_SYNC_INTERVAL milliseconds after that, so the estimate follows the
+     * drift of the clocks.  The request carries the current estimate, as `OFFSET:RTT`, so the Master node can translate the
+     * SESSION_TIMESTAMPs of this device to its own clock; the Master node answers with `T2:T3`, the times it received the
+     * request and sent the response.
+     */
+    void maintainClock() {
+      if(clockSyncPending) {
+        if(clockSync.isComplete()) {
+          clockSyncPending = false;
+
+          synchronized(clockSync.getResponse(), clockSync.getLatency());
+        }
+
+        return;
+      }
+
+      const unsigned long interval = (clock.getStats().samples < CLOCK_SAMPLES) ? CLOCK_SYNC_FAST_INTERVAL : CLOCK_SYNC_INTERVAL;
+
+      if(clockSyncStarted && millis() - clockSyncSent < interval) {
+        return;
+      }
+
+      // The Master node attributes the estimate to the session, so wait for the registration.
+      if(connection.getState() != CONNECTION_CONNECTED || registrationState != REGISTRATION_DONE || !radioAwake() || !throttle.ready()) {
+        return;
+      }
+
+      DCPRequest request(POST, "/time", sessionId);
+
+      if(clock.isSynchronized()) {
+        request.setMessage(String(clock.getOffset()) + ":" + String(clock.getRtt()));
+      }
+
+      clockSyncStarted = true;
+      clockSyncPending = true;
+      clockSyncSent = millis();
+
+      // If the request cannot be sent, the handle is completed immediately and handled by the next run.
+      send(request, &clockSync);
+    }
+
+    /**
+     * Handles the response to a clock synchronization request.
+     *
+     * @param response (const DCPResponse &) - the response
+     * @param latency (const unsigned long) - the round trip time, in milliseconds, of the request
+     */
+    void synchronized(const DCPResponse &response, const unsigned long latency) {
+      if(response.statusCode != SUCCESS) {
+        return;
+      }
+
+      // The timestamps can exceed a long, so they cannot be parsed with `String::toInt()`.
+      const char *field = response.data.c_str();
+      char *end;
+
+      const unsigned long received = strtoul(field, &end, 10);
+
+      if(end == field || *end != ':') {
+        clock.reject();
+
+        return;
+      }
+
+      field = end + 1;
+
+      const unsigned long responded = strtoul(field, &end, 10);
+
+      if(end == field) {
+        clock.reject();
+
+        return;
+      }
+
+      clock.sample(clockSyncSent, received, responded, clockSyncSent + latency);
+    }
+
+    /**
+     * Wakes the actions whose Master time has arrived.
+     */
+    void dispatchActions() {
+      if(actionCount == 0 || !clock.isSynchronized()) {
+        return;
+      }
+
+      const unsigned long now = clock.now();
+
+      for(int index = 0; index < actionCount; index++) {
+        if((long) (now - actions[index].masterTime) < 0) {
+          continue;
+        }
+
+        const int pid = actions[index].pid;
+
+        // Waking the action can switch to it, so it is removed first.
+        actions[index--] = actions[--actionCount];
+
+        scheduler.ready(pid);
+      }
+    }
+
+    /**
+     * Adds an action to run at a Master time.
+     *
+     * @param masterTime (const unsigned long) - the Master time the action should run
+     * @param action (Runnable &) - the process to schedule
+     *
+     * @return (int) 0 if the action will run; -1 if the clock is not synchronized; -2 if no more actions can wait
+     */
+    int scheduleAt(const unsigned long masterTime, Runnable &action) {
+      if(!clock.isSynchronized()) {
+        return -1;
+      }
+
+      if(actionCount >= MAX_SCHEDULED_ACTIONS) {
+        return -2;
+      }
+
+      const int pid = actionPid(action);
+
+      if(pid < 0) {
+        return -2;
+      }
+
+      actions[actionCount].masterTime = masterTime;
+      actions[actionCount].pid = pid;
+      actionCount++;
+
+      return 0;
+    }
+
+    /**
+     * Finds the process of an action, adding the action to the Scheduler the first time it is used.  Each action keeps its
+     * process, so an action that is scheduled again while it is still waiting to run, or running, is not added twice.
+     *
+     * @param action (Runnable &) - the action
+     *
+     * @return (int) the PID of the action or a negative value if it could not be added
+     */
+    int actionPid(Runnable &action) {
+      for(int index = 0; index < actionProcessCount; index++) {
+        if(actionProcesses[index].action == &action) {
+          return actionProcesses[index].pid;
+        }
+      }
+
+      if(actionProcessCount >= MAX_SCHEDULED_ACTIONS) {
+        return -1;
+      }
+
+      const int pid = scheduler.scheduleSuspended(action, SCHEDULED_ACTION_PRIORITY);
+
+      if(pid >= 0) {
+        actionProcesses[actionProcessCount].action = &action;
+        actionProcesses[actionProcessCount].pid = pid;
+        actionProcessCount++;
+      }
+
+      return pid;
+    }
+
+    /**
+     * Reads every response that has arrived and completes the matching requests.  Responses may arrive in any order.
+     */
+    void receive() {
+      WiFiClient *client = connection.getClient();
+
+      for(int responses = 0; client != NULL && responses < MAX_IN_FLIGHT && client->available() > 0; responses++) {
+        DCPResponse response(*client);
+
+        if(response.statusCode == RESPONSE_TIMEOUT || response.statusCode == INVALID_RESPONSE) {
+          // Either the Master went away mid-response or the stream is no longer aligned on a response boundary.  Neither can be
+          // recovered on this connection.
+          disconnect();
+
+          return;
+        }
+
+        if(response.sessionTimestamp == 0) {
+          connection.heard();
+
+          route(response);
+
+          continue;
+        }
+
+        recordBootEvent(BOOT_FIRST_ACK);
+
+        const int index = find(response.sessionTimestamp);
+
+        // Responses to requests that were already failed are dropped, but what they say about the Master node still counts.
+        if(index < 0) {
+          connection.heard();
+          throttle.observe(response, 0);
+
+          continue;
+        }
+
+        connection.received(millis() - inFlight[index].sent);
+        throttle.observe(response, inFlight[index].bytes);
+
+        complete(index, response);
+      }
+    }
+
+    /**
+     * Subscribes a mailbox to the messages the Master node pushes to a sub device.
+     *
+     * @param subDeviceId (uint16_t) - the unique ID of the sub device
+     * @param mailbox (DCPMailbox &) - the mailbox that will receive the messages
+     *
+     * @return (int) 0 if the mailbox was subscribed; -1 if MAX_SUBSCRIPTIONS sub devices are already subscribed
+     */
+    int subscribe(uint16_t subDeviceId, DCPMailbox &mailbox) {
+      for(int index = 0; index < subscriptionCount; index++) {
+        if(subscriptions[index].subDeviceId == subDeviceId) {
+          subscriptions[index].mailbox = &mailbox;
+
+          return 0;
+        }
+      }
+
+      if(subscriptionCount >= MAX_SUBSCRIPTIONS) {
+        return -1;
+      }
+
+      subscriptions[subscriptionCount].subDeviceId = subDeviceId;
+      subscriptions[subscriptionCount].mailbox = &mailbox;
+      subscriptionCount++;
+
+      return 0;
+    }
+
+    /**
+     * Delivers a pushed message to the mailbox of the sub device it is addressed to.  Messages for sub devices without a
+     * mailbox are dropped.
+     *
+     * @param message (const DCPResponse &) - the pushed message
+     */
+    void route(const DCPResponse &message) {
+      const uint16_t subDeviceId = message.subDeviceId.toInt();
+
+      for(int index = 0; index < subscriptionCount; index++) {
+        if(subscriptions[index].subDeviceId == subDeviceId) {
+          subscriptions[index].mailbox->deliver(message);
+
+          return;
+        }
+      }
+
+      unroutedCount++;
+    }
+
+    /**
+     * Fails every request in flight if the connection has been lost or reestablished since they were sent, or if the oldest
+     * one has gone unanswered for HEALTH_TIMEOUT milliseconds.
+     */
+    void expire() {
+      const ConnectionStats &stats = connection.getStats();
+
+      if(connection.getState() != CONNECTION_CONNECTED || stats.connects != generation) {
+        generation = stats.connects;
+
+        failAll();
+
+        return;
+      }
+
+      if(inFlightCount > 0 && millis() - inFlight[0].sent >= HEALTH_TIMEOUT) {
+        disconnect();
+      }
+    }
 
   private:
-    static Scheduler &scheduler;
+    /**
+     * InFlightRequest tracks a request that has been sent but not answered.
+     */
+    struct InFlightRequest {
+      unsigned long timestamp;    // The SESSION_TIMESTAMP of the request.
+      unsigned long sent;         // The time, in milliseconds, the request was sent.
+      DCPCompletion *completion;  // The handle to complete once the response arrives or NULL.
+      int lane;                   // The OutboundLane whose updates the request carries or -1 if it carries none.
+      int records;                // The number of updates the request carries.
+      unsigned int bytes;         // The size, in bytes, of the body of the request.
+    };
+
+    Scheduler &scheduler;
+
+    /**
+     * Subscription maps a sub device to the mailbox that receives the messages pushed to it.
+     */
+    struct Subscription {
+      uint16_t subDeviceId;
+      DCPMailbox *mailbox;
+    };
+
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    int subscriptionCount = 0;
 
-    const char *server = "devices.c1moore.codes";
-    const int port = 80;
+    /**
+     * ScheduledAction is an action waiting for its Master time.
+     */
+    struct ScheduledAction {
+      unsigned long masterTime;
+      int pid;                  // The process of the action.
+    };
 
-    WiFiClient client;
+    ScheduledAction actions[MAX_SCHEDULED_ACTIONS];
+    int actionCount = 0;
 
     /**
+     * ActionProcess is the process an action was added to the Scheduler as.
+     */
+    struct ActionProcess {
+      Runnable *action;
+      int pid;
+    };
+
+    ActionProcess actionProcesses[MAX_SCHEDULED_ACTIONS];
+    int actionProcessCount = 0;
+
+    InFlightRequest inFlight[MAX_IN_FLIGHT];  // Requests in flight, oldest first.
+    int inFlightCount = 0;
+    int bulkInFlight = 0;                     // The number of requests in flight carrying bulk updates.
+    unsigned long generation = 0;             // The connection the requests in flight were sent on, identified by its connect count.
+
+    /**
+     * Finds the request in flight with the given SESSION_TIMESTAMP.
+     *
+     * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request
      *
+     * @return (int) the index of the request or -1 if no such request is in flight
      */
-    WiFiClient getConnectedClient() {
-      if(!client.connected()) {
-        client.stop();
+    int find(const unsigned long timestamp) const {
+      for(int index = 0; index < inFlightCount; index++) {
+        if(inFlight[index].timestamp == timestamp) {
+          return index;
+        }
+      }
 
-        while(!client.connect(server, port)) {
-          // @TODO This looks a lot like threading to me... Might want to consider making this somewhat thread safe and possibly using a mutex around
-          // this method.
-          Implementation::scheduler.yield();
+      return -1;
+    }
+
+    /**
+     * Completes the request in flight at `index` with `response` and removes it from the requests in flight.
+     *
+     * @param index (const int) - the index of the request
+     * @param response (const DCPResponse &) - the response to the request
+     */
+    void complete(const int index, const DCPResponse &response) {
+      DCPCompletion *completion = inFlight[index].completion;
+      const unsigned long timestamp = inFlight[index].timestamp;
+      const unsigned long latency = millis() - inFlight[index].sent;
+      const int lane = inFlight[index].lane;
+      const int records = inFlight[index].records;
+
+      // Keep the remaining requests oldest first.
+      for(int next = index + 1; next < inFlightCount; next++) {
+        inFlight[next - 1] = inFlight[next];
+      }
+
+      inFlightCount--;
+
+      if(lane == LANE_BULK) {
+        bulkInFlight--;
+      }
+
+      if(lane >= 0) {
+        // A batch that is too long is split by the next flushes.  A single update that is too long would never be accepted.
+        if(retryable(response.statusCode) || (response.statusCode == REQUEST_TOO_LONG && records > 1)) {
+          lanes[lane].release(timestamp);
+        } else {
+          lanes[lane].acknowledge(timestamp, response, latency);
         }
       }
 
-      return client;
+      if(completion != NULL) {
+        completion->complete(response, latency);
+      }
+    }
+
+    /**
+     * Checks whether a request that failed with the given status may succeed if it is sent again.  Other failures, such as
+     * BAD_REQUEST, would fail again, so their updates are acknowledged to keep them from blocking the queue.
+     *
+     * @param statusCode (const DCPStatus) - the status of the response
+     *
+     * @return (bool) true iff the request should be sent again
+     */
+    static bool retryable(const DCPStatus statusCode) {
+      switch(statusCode) {
+        case REQUEST_TIMEOUT:
+        case SERVER_ERROR:
+        case SERVER_DOWN:
+        case RESPONSE_TIMEOUT:
+        case INVALID_RESPONSE:
+          return true;
+
+        default:
+          return false;
+      }
+    }
+
+    /**
+     * Completes `completion`, if any, with RESPONSE_TIMEOUT.
+     *
+     * @param completion (DCPCompletion *) - the handle to complete or NULL
+     * @param latency (const unsigned long) - the time, in milliseconds, since the request was sent
+     */
+    void fail(DCPCompletion *completion, const unsigned long latency) {
+      if(completion != NULL) {
+        completion->complete(DCPResponse(RESPONSE_TIMEOUT), latency);
+      }
+    }
+
+    /**
+     * Fails every request in flight with RESPONSE_TIMEOUT.
+     */
+    void failAll() {
+      // Completing a request can schedule a callback that sends a new request on the new connection, so only fail the ones
+      // that are already in flight.
+      for(int remaining = inFlightCount; remaining > 0 && inFlightCount > 0; remaining--) {
+        complete(0, DCPResponse(RESPONSE_TIMEOUT));
+      }
+    }
+
+    /**
+     * Drops the connection and fails every request in flight, since their responses can no longer arrive.
+     */
+    void disconnect() {
+      connection.drop();
+
+      failAll();
     }
 };
 
-Scheduler &Coordinator::Implementation::scheduler = Scheduler::getInstance();
+Coordinator::Coordinator(Scheduler &scheduler) {
+  implementation = new Implementation(scheduler);
 
-Coordinator::Coordinator() {
-  implementation = new Implementation();
+  // Replay whatever could not be delivered before the last restart.
+  for(int lane = 0; lane < LANE_COUNT; lane++) {
+    implementation->lanes[lane].begin();
+  }
 
-  int did = readDeviceId(0);
+  int did = readDeviceId(DEVICE_ID_ADDRESS);
 
   if(did) {
     implementation->did = did;
-
-    return;
+    implementation->sessionId = String(did);
   }
 
+  // Reuse the session from before the restart until the Master node says otherwise.
+  if(implementation->registrations.begin() && implementation->registrations.getSessionId().length() > 0) {
+    implementation->sessionId = implementation->registrations.getSessionId();
+  }
 
 }
 
@@ -69,9 +856,201 @@ Coordinator::~Coordinator() {
 }
 
 int Coordinator::registerSensor(SensorType type) {
-  return 0;
+  return implementation->registrations.assign(SUBDEVICE_SENSOR, type);
+}
+
+int Coordinator::registerOutput(OutputType type) {
+  return implementation->registrations.assign(SUBDEVICE_OUTPUT, type);
+}
+
+bool Coordinator::isRegistered() const {
+  return (implementation->registrationState == Implementation::REGISTRATION_DONE);
 }
 
 int Coordinator::run() {
+  MasterConnection &connection = implementation->connection;
+
+  if(implementation->endpoints.count() == 0) {
+    implementation->endpoints.add(MASTER_HOST, MASTER_PORT, DATAGRAM_PORT);
+  }
+
+  // Actions are dispatched first since they are the only work here that has to happen at a particular time.
+  implementation->dispatchActions();
+
+  if(implementation->radio != NULL) {
+    // Requests waiting for a response keep the radio on until they are answered or expire.
+    implementation->radio->update(implementation->busy());
+  }
+
+  connection.update();
+  implementation->datagrams.update();
+
+  implementation->receive();
+  implementation->expire();
+  implementation->maintainRegistration();
+  implementation->maintainClock();
+
+  for(int lane = 0; lane < LANE_COUNT; lane++) {
+    implementation->lanes[lane].maintain();
+  }
+
+  // Higher lanes are always drained first.  After an outage, each queue is replayed a batch at a time for as long as requests
+  // can be sent; bulk transfers go out a chunk per request, so a new urgent update only waits for the chunk being sent.
+  int batches = 0;
+
+  for(int lane = 0; lane < LANE_COUNT; lane++) {
+    while(batches < MAX_IN_FLIGHT && implementation->batchDue(lane) && implementation->flush(lane) == 0) {
+      batches++;
+    }
+  }
+
+  // Let the Master know how long it took this device to come up.  This is only reported once the Master has answered since
+  // that is the last milestone.
+  if(!implementation->bootReported && getBootEventTime(BOOT_FIRST_ACK) != 0 && implementation->radioAwake()) {
+    DCPRequest boot(POST, "/boot", implementation->sessionId);
+    boot.setMessage(formatBootTimeline());
+
+    implementation->bootReported = (implementation->send(boot, NULL) == 0);
+  }
+
+  // While the Master node is down, it is left alone entirely.
+  if(connection.keepAliveDue() && implementation->radioAwake() && !implementation->throttle.isSuspended()) {
+    DCPRequest keepAlive(GET, "/keepalive", implementation->sessionId);
+
+    if(implementation->send(keepAlive, NULL) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+bool Coordinator::sync() {
+  bool written = false;
+
+  for(int lane = 0; lane < LANE_COUNT; lane++) {
+    written = implementation->lanes[lane].sync() || written;
+  }
+
+  return written;
+}
+
+int Coordinator::sendUpdate(uint16_t subDeviceId, String data, DCPCompletion *completion, const OutboundLane lane) {
+  if(completion != NULL) {
+    completion->reset();
+  }
+
+  if(implementation->lanes[lane].push(subDeviceId, data, completion) < 0) {
+    return -1;
+  }
+
+  if(implementation->batchDue(lane)) {
+    implementation->flush(lane);
+  }
+
   return 0;
 }
+
+int Coordinator::sendEvent(uint16_t subDeviceId, String data, DCPCompletion *completion) {
+  if(data.length() <= DATAGRAM_MAX_PAYLOAD && implementation->datagrams.ready() && implementation->throttle.ready()) {
+    if(!implementation->radioAwake()) {
+      implementation->radio->breakthrough();
+    }
+
+    DCPRequest event(POST, implementation->resource(subDeviceId), implementation->sessionId);
+    event.setMessage(data);
+
+    // The token is only taken once the datagram is out; an event that falls back to the reliable path pays for that request
+    // instead.
+    if(implementation->datagrams.send(event, completion) == 0) {
+      implementation->throttle.take();
+
+      return 0;
+    }
+  }
+
+  // Large updates, and events that cannot be sent as a datagram right now, take the reliable path.
+  return sendUpdate(subDeviceId, data, completion, LANE_URGENT);
+}
+
+int Coordinator::requestUpdate(uint16_t subDeviceId, String data, DCPCompletion *completion) {
+  // GET requests carry their data in the resource, after the question mark.
+  DCPRequest request(GET, implementation->resource(subDeviceId) + "?" + data, implementation->sessionId);
+
+  return implementation->send(request, completion);
+}
+
+int Coordinator::requestUpdate(uint16_t subDeviceId, DCPCompletion *completion) {
+  DCPRequest request(GET, implementation->resource(subDeviceId), implementation->sessionId);
+
+  return implementation->send(request, completion);
+}
+
+void Coordinator::setBatching(const unsigned long window, const unsigned int byteBudget, const OutboundLane lane) {
+  implementation->batchWindow[lane] = window;
+  implementation->batchBudget[lane] = byteBudget;
+}
+
+void Coordinator::setOverflowPolicy(const OverflowPolicy policy, const OutboundLane lane) {
+  implementation->lanes[lane].setPolicy(policy);
+}
+
+const QueueStats &Coordinator::getQueueStats(const OutboundLane lane) const {
+  return implementation->lanes[lane].getStats();
+}
+
+int Coordinator::getLaneDepth(const OutboundLane lane) const {
+  return implementation->lanes[lane].count();
+}
+
+const LaneStats &Coordinator::getLaneStats(const OutboundLane lane) const {
+  return implementation->laneStats[lane];
+}
+
+const BatchStats &Coordinator::getBatchStats() const {
+  return implementation->batchStats;
+}
+
+int Coordinator::subscribe(uint16_t subDeviceId, DCPMailbox &mailbox) {
+  return implementation->subscribe(subDeviceId, mailbox);
+}
+
+unsigned long Coordinator::getUnroutedCount() const {
+  return implementation->unroutedCount;
+}
+
+int Coordinator::scheduleAt(const unsigned long masterTime, Runnable &action) {
+  return implementation->scheduleAt(masterTime, action);
+}
+
+const MasterClock &Coordinator::getClock() const {
+  return implementation->clock;
+}
+
+int Coordinator::addMaster(const char *host, const uint16_t port, const uint16_t datagramPort) {
+  return implementation->endpoints.add(host, port, datagramPort);
+}
+
+const MasterEndpoints &Coordinator::getEndpoints() const {
+  return implementation->endpoints;
+}
+
+void Coordinator::setRateLimit(const unsigned int rate, const unsigned int burst) {
+  implementation->throttle.setRate(rate, burst);
+}
+
+const RequestThrottle &Coordinator::getThrottle() const {
+  return implementation->throttle;
+}
+
+void Coordinator::setRadioScheduler(RadioScheduler *radio) {
+  implementation->radio = radio;
+}
+
+const MasterConnection &Coordinator::getConnection() const {
+  return implementation->connection;
+}
+
+const DatagramTransport &Coordinator::getDatagramTransport() const {
+  return implementation->datagrams;
+}
@@ -11,63 +11,371 @@
   #include <stdint.h>
 
   #include "../scheduler/Runnable.h"
+  #include "../scheduler/Scheduler.h"
+  #include "DCP/DCPCompletion.h"
+  #include "DCP/DCPMailbox.h"
   #include "DCP/DCPRequest.h"
   #include "DCP/DCPResponse.h"
+  #include "DatagramTransport.h"
+  #include "MasterClock.h"
+  #include "MasterConnection.h"
+  #include "MasterEndpoints.h"
+  #include "OutboundQueue.h"
+  #include "RadioScheduler.h"
+  #include "RequestThrottle.h"
+  #include "RegistrationCache.h"
   #include "SensorType.h"
+  #include "UpdateBatch.h"
   #include "OutputType.h"
 
+  // The Master node used if none is added with `Coordinator::addMaster()`.
+  #ifndef MASTER_HOST
+    #define MASTER_HOST "devices.c1moore.codes"
+  #endif
+
+  #ifndef MASTER_PORT
+    #define MASTER_PORT 80
+  #endif
+
+  // The maximum number of requests that can be waiting for a response at once.
+  #ifndef MAX_IN_FLIGHT
+    #define MAX_IN_FLIGHT 8
+  #endif
+
+  // The maximum number of sub devices that can receive messages pushed by the Master node.
+  #ifndef MAX_SUBSCRIPTIONS
+    #define MAX_SUBSCRIPTIONS 16
+  #endif
+
+  // The time, in milliseconds, to wait before trying to register with the Master node again after a failed attempt.
+  #ifndef REGISTRATION_RETRY
+    #define REGISTRATION_RETRY 5000
+  #endif
+
+  // The default time, in milliseconds, updates are held back so updates from other sub devices can be sent with them.
+  #ifndef COALESCE_WINDOW
+    #define COALESCE_WINDOW 20
+  #endif
+
+  // The default size, in bytes, at which a batch of updates is sent without waiting for the rest of the window.
+  #ifndef BATCH_BYTE_BUDGET
+    #define BATCH_BYTE_BUDGET 512
+  #endif
+
+  // The default time, in milliseconds, bulk updates are held back so telemetry is sent in as few requests as possible.
+  #ifndef BULK_WINDOW
+    #define BULK_WINDOW 1000
+  #endif
+
+  // The default size, in bytes, of a bulk request.  Bulk transfers are split into requests no larger than this so updates from
+  // higher lanes can be sent between them.
+  #ifndef BULK_CHUNK_SIZE
+    #define BULK_CHUNK_SIZE 256
+  #endif
+
+  // The maximum number of bulk requests waiting for a response at once.
+  #ifndef BULK_IN_FLIGHT
+    #define BULK_IN_FLIGHT 1
+  #endif
+
+  // The time, in milliseconds, between exchanges with the Master node to synchronize with its clock.
+  #ifndef CLOCK_SYNC_INTERVAL
+    #define CLOCK_SYNC_INTERVAL 60000
+  #endif
+
+  // The time, in milliseconds, between exchanges until CLOCK_SAMPLES samples have been taken.
+  #ifndef CLOCK_SYNC_FAST_INTERVAL
+    #define CLOCK_SYNC_FAST_INTERVAL 2000
+  #endif
+
+  // The maximum number of actions waiting for their Master time at once.  This is also the maximum number of different actions
+  // that can be scheduled.
+  #ifndef MAX_SCHEDULED_ACTIONS
+    #define MAX_SCHEDULED_ACTIONS 8
+  #endif
+
+  // The priority of the process an action runs as once its Master time arrives.
+  #ifndef SCHEDULED_ACTION_PRIORITY
+    #define SCHEDULED_ACTION_PRIORITY 15
+  #endif
+
   /**
    * Coordinator is responsible for communicating with the Master node.  The Coordinator is not responsible for parsing data or trying to determining how to respond
    * to the Master node outside of meta communication.
    */
   class Coordinator: public Runnable {
     public:
-      Coordinator();
+      /**
+       * Creates a new Coordinator.  `EEPROM.begin()` must be called first with at least EEPROM_SIZE bytes (see PersistentLayout.h).
+       *
+       * @param scheduler (Scheduler &) _optional_ - the Scheduler that will execute this Coordinator.  Default: the default
+       *  Scheduler instance
+       */
+      Coordinator(Scheduler &scheduler = Scheduler::getInstance());
       ~Coordinator();
 
       /**
        * Registers a new Sensor with the Master node.  This process will assign a unique ID to the sensor.
        *
+       * The ID is assigned immediately and is the same across restarts as long as the sensor is registered (see RegistrationCache).  Every sub device is
+       * registered with the Master node at once, in a single request, once `run()` can reach it.  If the configuration has not changed since the last
+       * restart, that request only revalidates the cached session:
+       *
+       *    POST /session          CONFIG_HASH                   -> SUCCESS_NOCONTENT if the session and configuration are still valid
+       *    POST /register         CONFIG_HASH\nKIND:TYPE:ID...  -> SUCCESS with the new SESSION_ID as the body
+       *
+       * `/register` is only sent if the revalidation is refused or nothing was cached.  Queued updates are held until either succeeds.
+       *
        * @param type (SensorType) - the SensorType of the Sensor to register
        *
-       * @return (int) the unique ID for the sensor
+       * @return (int) the unique ID for the sensor or -1 if MAX_REGISTRATIONS sub devices are already registered
        */
       int registerSensor(SensorType type);
 
       /**
-       * Registers a new output device with the Master node.  This process will assign a unique ID to the output device.
+       * Registers a new output device with the Master node.  This process will assign a unique ID to the output device.  See `registerSensor()`.
        *
        * @param type (OutputType) - the type of output device to register
        *
-       * @return (int) the unique ID for the output device
+       * @return (int) the unique ID for the output device or -1 if MAX_REGISTRATIONS sub devices are already registered
        */
       int registerOutput(OutputType type);
 
       /**
-       * Executes the main loop for this Coordinator.  During the main loop, the Coordinator will communicate with the Master node as necessary.
+       * Checks whether the sub devices have been registered with the Master node, either by revalidating the cached registration or by registering them
+       * again.
+       *
+       * @return (bool) true iff the registration is done
+       */
+      bool isRegistered() const;
+
+      /**
+       * Executes the main loop for this Coordinator.  During the main loop, the Coordinator will communicate with the Master node as necessary.  This includes
+       * (re)establishing the persistent connection to the Master node, probing it with keep-alives while it is idle, completing requests whose responses
+       * have arrived, and delivering the messages the Master node pushed to the sub devices.
        *
        * @return (int) 0 if the the loop was successful; an error code otherwise
        */
       int run();
 
       /**
-       * Sends the provided data to the Master node for processing.
+       * Writes the updates spilled to EEPROM during an outage to flash, once SPILL_SYNC_INTERVAL has passed since they were last written.  A flash write keeps
+       * the MCU for several milliseconds, so this is meant to be executed as idle work (see `Scheduler::registerIdleTask()`) instead of in the middle of
+       * sending.  `run()` still writes updates that have waited twice SPILL_SYNC_INTERVAL, so they are written even if the device is never idle.
+       *
+       * @return (bool) true iff the spilled updates were written
+       */
+      bool sync();
+
+      /**
+       * Sends the provided data to the Master node for processing.  This method returns as soon as the update is queued and the response is delivered through
+       * `completion` once it arrives.
+       *
+       * Updates are queued until the Master node acknowledges them, so they survive the Master node being unreachable (see OutboundQueue).  They are sent in
+       * batches (see `setBatching()`): the update is held for up to the coalescing window and sent in a single request with the updates of other sub devices.
+       *
+       * Each OutboundLane has its own queue.  Lanes are always sent in order, urgent first, and one request slot is kept free for the urgent lane, so an urgent
+       * update never waits for more than the bulk request already being sent.  Only the normal lane spills to EEPROM; urgent updates are stale by the time the
+       * Master node is back and bulk updates are not worth the flash wear.
        *
        * @param subDeviceId (uint16_t) - the unique ID assigned to the sub device sending the request
        * @param data (String) - the data to send to the Master node
+       * @param completion (DCPCompletion *) _optional_ - the handle to complete with the response once the Master node acknowledges the update.  If the update
+       *  is dropped or spilled to EEPROM, the handle is completed with RESPONSE_TIMEOUT.  Default: NULL, the response is discarded
+       * @param lane (const OutboundLane) _optional_ - the lane to queue the update in.  Default: LANE_NORMAL
+       *
+       * @return (int) 0 if the update was queued; -1 if it was dropped because the queue is full
+       */
+      int sendUpdate(uint16_t subDeviceId, String data, DCPCompletion *completion = NULL, const OutboundLane lane = LANE_NORMAL);
+
+      /**
+       * Sends a small, latency-critical update, such as a motion event, to the Master node.  The event is sent immediately in a datagram (see
+       * DatagramTransport) instead of waiting for a batch or behind larger requests on the persistent connection, and the response is delivered through
+       * `completion` once it arrives.  If the datagram goes unanswered after DATAGRAM_RETRIES retransmissions, `completion` is completed with RESPONSE_TIMEOUT.
+       *
+       * Events larger than DATAGRAM_MAX_PAYLOAD bytes, or sent while no datagram can be sent, are queued in the urgent lane instead (see `sendUpdate()`).
+       *
+       * @param subDeviceId (uint16_t) - the unique ID assigned to the sub device sending the event
+       * @param data (String) - the data to send to the Master node
+       * @param completion (DCPCompletion *) _optional_ - the handle to complete with the response.  Default: NULL
        *
-       * @return (DCPResponse &) the response sent by the Master node
+       * @return (int) 0 if the event was sent or queued; -1 if it was dropped because the queue is full
        */
-      DCPResponse &sendUpdate(uint16_t subDeviceId, String data);
+      int sendEvent(uint16_t subDeviceId, String data, DCPCompletion *completion = NULL);
 
       /**
-       * Sends a request to the Master node requesting it to send an update for the specified sub device.
+       * Sends a request to the Master node requesting it to send an update for the specified sub device.  The request is pipelined: this method returns as soon
+       * as the request is written and the response is delivered through `completion` once it arrives.  Requests are not queued; if the Master node is
+       * unreachable, `completion` is completed immediately with RESPONSE_TIMEOUT.
        *
        * @param subDeviceId (uint16_t) - the unique ID of the sub device requesting an update
        * @param data (String) _optional_ - any additional data to send to the Master node
+       * @param completion (DCPCompletion *) _optional_ - the handle to complete with the response.  Default: NULL
+       *
+       * @return (int) 0 if the request was sent; -1 if the connection to the Master node is not open; -2 if MAX_IN_FLIGHT requests are already waiting for
+       *  a response; -3 if the request could not be written; -5 if the rate limit was reached or the Master node is down (see `setRateLimit()`)
+       */
+      int requestUpdate(uint16_t subDeviceId, String data, DCPCompletion *completion = NULL);
+      int requestUpdate(uint16_t subDeviceId, DCPCompletion *completion = NULL);
+
+      /**
+       * Subscribes a mailbox to the messages the Master node pushes to a sub device, such as commands for an output device.  This replaces polling the Master
+       * node with `requestUpdate()`: pushed messages arrive as soon as the Master node sends them and the connection carries only keep-alives while idle.
+       * Subscribing the same sub device again replaces its mailbox.
+       *
+       * @param subDeviceId (uint16_t) - the unique ID of the sub device
+       * @param mailbox (DCPMailbox &) - the mailbox that will receive the messages
+       *
+       * @return (int) 0 if the mailbox was subscribed; -1 if MAX_SUBSCRIPTIONS sub devices are already subscribed
+       */
+      int subscribe(uint16_t subDeviceId, DCPMailbox &mailbox);
+
+      /**
+       * Returns the number of pushed messages that were dropped because they were addressed to a sub device without a mailbox.
+       *
+       * @return (unsigned long) the number of dropped messages
+       */
+      unsigned long getUnroutedCount() const;
+
+      /**
+       * Configures how the updates of a lane are batched.  A batch is sent once its oldest update has waited `window` milliseconds, once it reaches `byteBudget`
+       * bytes or once MAX_BATCH_RECORDS sub devices have updates in it, whichever comes first.  By default, urgent updates are not held back, normal updates
+       * are held for COALESCE_WINDOW and bulk updates for BULK_WINDOW in requests of at most BULK_CHUNK_SIZE bytes.
+       *
+       * @param window (const unsigned long) - the time, in milliseconds, an update may be held back.  0 disables batching.
+       * @param byteBudget (const unsigned int) - the size, in bytes, at which a batch is sent immediately
+       * @param lane (const OutboundLane) _optional_ - the lane to configure.  Default: LANE_NORMAL
+       */
+      void setBatching(const unsigned long window, const unsigned int byteBudget, const OutboundLane lane = LANE_NORMAL);
+
+      /**
+       * Returns the batching statistics.  The average batch size and the average time an update was held back show the tradeoff made by the batching
+       * configuration.
+       *
+       * @return (const BatchStats &) the batching statistics
+       */
+      const BatchStats &getBatchStats() const;
+
+      /**
+       * Configures what happens to new updates when the queue of a lane is full, which happens when the Master node has been unreachable for a while.
+       *
+       * @param policy (const OverflowPolicy) - the new policy
+       * @param lane (const OutboundLane) _optional_ - the lane to configure.  Default: LANE_NORMAL
+       */
+      void setOverflowPolicy(const OverflowPolicy policy, const OutboundLane lane = LANE_NORMAL);
+
+      /**
+       * Returns the statistics of the queue of a lane, including its deepest point.
+       *
+       * @param lane (const OutboundLane) _optional_ - the lane.  Default: LANE_NORMAL
+       *
+       * @return (const QueueStats &) the queue statistics
+       */
+      const QueueStats &getQueueStats(const OutboundLane lane = LANE_NORMAL) const;
+
+      /**
+       * Returns the number of updates in the queue of a lane, including updates in flight.
+       *
+       * @param lane (const OutboundLane) - the lane
+       *
+       * @return (int) the depth of the queue
+       */
+      int getLaneDepth(const OutboundLane lane) const;
+
+      /**
+       * Returns how long the updates of a lane waited to be sent.
+       *
+       * @param lane (const OutboundLane) - the lane
+       *
+       * @return (const LaneStats &) the wait-time statistics of the lane
+       */
+      const LaneStats &getLaneStats(const OutboundLane lane) const;
+
+      /**
+       * Runs `action` at a time given by the Master node's clock, such as when the Master node tells several devices to switch their lights at the same instant.
+       * Master times are converted with the offset estimated by the regular clock synchronization with the Master node (see MasterClock), so the action runs
+       * at the same instant on every device, give or take their clock errors, however long the command took to reach each of them.
+       *
+       * The first time an action is scheduled, it is added to the Scheduler with SCHEDULED_ACTION_PRIORITY using `Scheduler::scheduleSuspended()`.  It is
+       * woken by the first `run()` at or after `masterTime`, so it is also late by up to the time between runs.  An action whose time has already passed is
+       * woken by the next `run()`.  Each action keeps its process, so an action that is still running when it is woken again runs once more
+       * afterwards rather than being started twice.
+       *
+       * @param masterTime (const unsigned long) - the time, in milliseconds on the Master node's clock, the action should run
+       * @param action (Runnable &) - the process to schedule
+       *
+       * @return (int) 0 if the action will run; -1 if the clock has not been synchronized with the Master node yet; -2 if MAX_SCHEDULED_ACTIONS actions are
+       *  already waiting or MAX_SCHEDULED_ACTIONS different actions have already been scheduled
+       */
+      int scheduleAt(const unsigned long masterTime, Runnable &action);
+
+      /**
+       * Returns the estimate of the Master node's clock, which can be used to translate times between this device and the Master node.
+       *
+       * @return (const MasterClock &) the estimate of the Master node's clock
+       */
+      const MasterClock &getClock() const;
+
+      /**
+       * Adds a Master node this device can talk to.  Master nodes are tried in the order they were added until their round trip times are known; after that,
+       * the fastest healthy one is used and the Coordinator fails over to another when it stops responding (see MasterEndpoints).  Master nodes should be added
+       * before the first `run()`; if none was added by then, MASTER_HOST is used.
+       *
+       * @param host (const char *) - the hostname or IP address of the Master node, which must outlive the Coordinator
+       * @param port (const uint16_t) _optional_ - the port of the Master node.  Default: MASTER_PORT
+       * @param datagramPort (const uint16_t) _optional_ - the port the Master node receives datagrams on.  Default: DATAGRAM_PORT
+       *
+       * @return (int) the index of the Master node or -1 if MAX_MASTER_ENDPOINTS Master nodes were already added
+       */
+      int addMaster(const char *host, const uint16_t port = MASTER_PORT, const uint16_t datagramPort = DATAGRAM_PORT);
+
+      /**
+       * Returns the Master nodes this device can talk to, which can be used to inspect their round trip times and health.
+       *
+       * @return (const MasterEndpoints &) the Master nodes
+       */
+      const MasterEndpoints &getEndpoints() const;
+
+      /**
+       * Limits how fast this device sends requests to the Master node, so a fleet of devices replaying their queues does not overwhelm a Master node that is
+       * recovering.  Requests held back by the limit stay queued (see RequestThrottle).  The Coordinator also honors what the Master node says about its load:
+       * after SERVER_DOWN, nothing is sent until the advertised recovery time, and after REQUEST_TOO_LONG or REQUEST_TIMEOUT, batches are split to fit the
+       * advertised request limit.
+       *
+       * @param rate (const unsigned int) - the number of requests per second allowed on average
+       * @param burst (const unsigned int) - the number of requests allowed back to back
+       */
+      void setRateLimit(const unsigned int rate, const unsigned int burst);
+
+      /**
+       * Returns the throttle that limits the requests sent to the Master node, which can be used to inspect its state and statistics.
+       *
+       * @return (const RequestThrottle &) the throttle
+       */
+      const RequestThrottle &getThrottle() const;
+
+      /**
+       * Aligns the traffic to the Master node into the bursts of `radio`, so the radio can sleep in between.  While the radio sleeps, only urgent updates,
+       * events and direct requests such as `requestUpdate()` are sent, turning the radio on early; queued updates from the other lanes and keep-alives wait
+       * for the next burst.  Pushed messages and responses are read during bursts.
+       *
+       * @param radio (RadioScheduler *) - the scheduler that decides when the radio is on or NULL to leave the radio on, which is the default
+       */
+      void setRadioScheduler(RadioScheduler *radio);
+
+      /**
+       * Returns the persistent connection to the Master node, which can be used to inspect its state and statistics.
+       *
+       * @return (const MasterConnection &) the connection to the Master node
+       */
+      const MasterConnection &getConnection() const;
+
+      /**
+       * Returns the transport used to send events, which can be used to inspect its statistics.
+       *
+       * @return (const DatagramTransport &) the datagram transport
        */
-      DCPResponse &requestUpdate(uint16_t subDeviceId, String data);
-      DCPResponse &requestUpdate(uint16_t subDeviceId);
+      const DatagramTransport &getDatagramTransport() const;
 
     private:
       class Implementation;
@@ -0,0 +1,90 @@
+/*
+ * DCPCompletion.cpp
+ *
+ *      Author: c1moore
+ */
+#include "DCPCompletion.h"
+
+DCPCompletion::DCPCompletion(): callback(NULL), scheduler(NULL), callbackPid(-1), next(NULL), response(RESPONSE_TIMEOUT), latency(0),
+    completed(false) {}
+
+DCPCompletion::DCPCompletion(Runnable &callback, Scheduler &scheduler): callback(&callback), scheduler(&scheduler), callbackPid(-1), next(NULL),
+    response(RESPONSE_TIMEOUT), latency(0), completed(false) {}
+
+bool DCPCompletion::poll() {
+  return completed;
+}
+
+bool DCPCompletion::isComplete() const {
+  return completed;
+}
+
+const DCPResponse &DCPCompletion::getResponse() const {
+  return response;
+}
+
+unsigned long DCPCompletion::getLatency() const {
+  return latency;
+}
+
+void DCPCompletion::reset() {
+  response = DCPResponse(RESPONSE_TIMEOUT);
+  latency = 0;
+  completed = false;
+}
+
+void DCPCompletion::complete(const DCPResponse &response, const unsigned long latency) {
+  DCPCompletion *completion = this;
+
+  // Unlink every handle before completing it since a callback may reuse its handle for another request.
+  while(completion != NULL) {
+    DCPCompletion *next = completion->next;
+    completion->next = NULL;
+
+    completion->response = response;
+    completion->latency = latency;
+    completion->completed = true;
+
+    if(completion->callback != NULL) {
+      completion->wake();
+    }
+
+    completion = next;
+  }
+}
+
+void DCPCompletion::wake() {
+  // The callback is only added to the Scheduler the first time it is needed.  From then on, the same process is woken for
+  // every response, so completing requests never uses up PIDs.
+  if(callbackPid < 0) {
+    callbackPid = scheduler->scheduleSuspended(*callback);
+
+    if(callbackPid < 0) {
+      return;
+    }
+  }
+
+  scheduler->ready(callbackPid);
+}
+
+void DCPCompletion::link(DCPCompletion *other) {
+  if(other == NULL) {
+    return;
+  }
+
+  DCPCompletion *last = this;
+
+  while(true) {
+    if(last == other) {
+      return;
+    }
+
+    if(last->next == NULL) {
+      break;
+    }
+
+    last = last->next;
+  }
+
+  last->next = other;
+}
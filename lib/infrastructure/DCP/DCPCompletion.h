@@ -0,0 +1,117 @@
+/*
+ * DCPCompletion.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_COMPLETION
+  #define _C1MOORE_INFRASTRUCTURE_DCP_COMPLETION
+
+  #include "../../scheduler/Pollable.h"
+  #include "../../scheduler/Runnable.h"
+  #include "../../scheduler/Scheduler.h"
+  #include "DCPResponse.h"
+
+  /**
+   * DCPCompletion is a handle to the response of a DCP request that is still in flight.  Requests are pipelined, so the
+   * response arrives some time after the request was sent, possibly after responses to later requests.  There are two ways to
+   * find out the response has arrived:
+   *  - wait for it with `Scheduler::await()`, since DCPCompletion is Pollable
+   *  - provide a callback, which is woken once the response arrives
+   *
+   * The handle is owned by the caller and must outlive the request.  Once complete, it can be `reset()` and used again.  For
+   * example:
+   *
+   *    DCPCompletion completion;
+   *
+   *    coordinator.sendUpdate(sensorId, data, &completion);
+   *
+   *    if(scheduler.await(completion) == 0 && completion.getResponse().statusCode == SUCCESS) {
+   *      // ...
+   *    }
+   */
+  class DCPCompletion: public Pollable {
+    public:
+      /**
+       * Creates a DCPCompletion without a callback.
+       */
+      DCPCompletion();
+
+      /**
+       * Creates a DCPCompletion that executes `callback` once the response arrives.  The callback is added to the Scheduler
+       * using `Scheduler::scheduleSuspended()` the first time a response arrives and is woken for every response after that.
+       *
+       * @param callback (Runnable &) - the process to execute once the response arrives
+       * @param scheduler (Scheduler &) _optional_ - the Scheduler that will execute the callback.  Default: the Scheduler
+       *  returned by `Scheduler::current()`, so a handle created by a process is completed on the Scheduler executing it
+       */
+      DCPCompletion(Runnable &callback, Scheduler &scheduler = Scheduler::current());
+
+      /**
+       * Checks whether the response has arrived.
+       *
+       * @return (bool) true iff the response has arrived
+       */
+      bool poll();
+
+      /**
+       * Checks whether the response has arrived.
+       *
+       * @return (bool) true iff the response has arrived
+       */
+      bool isComplete() const;
+
+      /**
+       * Returns the response.  Until the request completes, the status will be RESPONSE_TIMEOUT.
+       *
+       * @return (const DCPResponse &) the response to the request
+       */
+      const DCPResponse &getResponse() const;
+
+      /**
+       * Returns the time, in milliseconds, between sending the request and receiving the response.
+       *
+       * @return (unsigned long) the round trip time of the request or 0 if it has not completed
+       */
+      unsigned long getLatency() const;
+
+      /**
+       * Prepares this DCPCompletion to be used for another request.
+       */
+      void reset();
+
+      /**
+       * Completes the request with the given response and wakes the callback, if any.  This is called by the Coordinator
+       * when the response arrives or the request fails.
+       *
+       * @param response (const DCPResponse &) - the response to the request
+       * @param latency (const unsigned long) - the time, in milliseconds, between sending the request and completing it
+       */
+      void complete(const DCPResponse &response, const unsigned long latency);
+
+      /**
+       * Links another DCPCompletion that will be completed with the same response as this one.  This lets a single request, such
+       * as a batch of updates, complete the handles of every update it carries.  Linking a handle that is already linked has no
+       * effect.
+       *
+       * @param other (DCPCompletion *) - the handle to complete along with this one
+       */
+      void link(DCPCompletion *other);
+
+    private:
+      /**
+       * Wakes the callback, adding it to the Scheduler first if this is the first response.
+       */
+      void wake();
+
+      Runnable *callback;
+      Scheduler *scheduler;
+      int callbackPid;      // The PID of the callback or a negative value if it has not been added to the Scheduler yet.
+      DCPCompletion *next;  // The next handle to complete with the same response.
+
+      DCPResponse response;
+      unsigned long latency;
+      bool completed;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_COMPLETION */
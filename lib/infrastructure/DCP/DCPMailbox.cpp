@@ -0,0 +1,54 @@
+/*
+ * DCPMailbox.cpp
+ *
+ *      Author: c1moore
+ */
+#include "DCPMailbox.h"
+
+DCPMailbox::DCPMailbox(): scheduler(NULL), handlerPid(-1), head(0), size(0), dropped(0) {}
+
+DCPMailbox::DCPMailbox(Runnable &handler, Scheduler &scheduler): scheduler(&scheduler), head(0), size(0), dropped(0) {
+  handlerPid = scheduler.scheduleSuspended(handler);
+}
+
+bool DCPMailbox::poll() {
+  return size > 0;
+}
+
+bool DCPMailbox::receive(DCPResponse &message) {
+  if(size == 0) {
+    return false;
+  }
+
+  message = messages[head];
+  messages[head] = DCPResponse();
+
+  head = (head + 1) % MAILBOX_CAPACITY;
+  size--;
+
+  return true;
+}
+
+int DCPMailbox::count() const {
+  return size;
+}
+
+unsigned long DCPMailbox::getDropped() const {
+  return dropped;
+}
+
+void DCPMailbox::deliver(const DCPResponse &message) {
+  if(size == MAILBOX_CAPACITY) {
+    head = (head + 1) % MAILBOX_CAPACITY;
+    size--;
+    dropped++;
+  }
+
+  messages[(head + size) % MAILBOX_CAPACITY] = message;
+  size++;
+
+  // Messages that arrive while the handler is executing wake it again once it finishes, so none are left waiting.
+  if(handlerPid >= 0) {
+    scheduler->ready(handlerPid);
+  }
+}
@@ -0,0 +1,96 @@
+/*
+ * DCPMailbox.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_MAILBOX
+  #define _C1MOORE_INFRASTRUCTURE_DCP_MAILBOX
+
+  #include "../../scheduler/Pollable.h"
+  #include "../../scheduler/Runnable.h"
+  #include "../../scheduler/Scheduler.h"
+  #include "DCPResponse.h"
+
+  // The number of pushed messages a DCPMailbox holds before the oldest is dropped.
+  #ifndef MAILBOX_CAPACITY
+    #define MAILBOX_CAPACITY 4
+  #endif
+
+  /**
+   * A DCPMailbox receives the messages the Master node pushes to a sub device, such as a command to turn an output on.  Pushed
+   * messages arrive on the persistent connection without being requested, as soon as the Master node decides to send them, so
+   * a sub device does not have to poll the Master node with `requestUpdate()`.
+   *
+   * There are two ways to find out a message has arrived:
+   *  - wait for it with `Scheduler::await()`, since DCPMailbox is Pollable
+   *  - provide a handler, which is woken every time a message arrives
+   *
+   * If messages arrive faster than they are received, the oldest are dropped; for commands, the latest is the one that matters.
+   */
+  class DCPMailbox: public Pollable {
+    public:
+      /**
+       * Creates a DCPMailbox without a handler.
+       */
+      DCPMailbox();
+
+      /**
+       * Creates a DCPMailbox that wakes `handler` every time a message arrives.  The handler is added to the Scheduler once,
+       * using `Scheduler::scheduleSuspended()`, so it should receive every waiting message each time it executes.
+       *
+       * @param handler (Runnable &) - the process to wake when a message arrives
+       * @param scheduler (Scheduler &) _optional_ - the Scheduler that will execute the handler.  Default: the Scheduler returned
+       *  by `Scheduler::current()`
+       */
+      DCPMailbox(Runnable &handler, Scheduler &scheduler = Scheduler::current());
+
+      /**
+       * Checks whether a message is waiting.
+       *
+       * @return (bool) true iff a message is waiting
+       */
+      bool poll();
+
+      /**
+       * Removes the oldest waiting message.
+       *
+       * @param message (DCPResponse &) - set to the message
+       *
+       * @return (bool) true iff a message was waiting
+       */
+      bool receive(DCPResponse &message);
+
+      /**
+       * Returns the number of waiting messages.
+       *
+       * @return (int) the number of waiting messages
+       */
+      int count() const;
+
+      /**
+       * Returns the number of messages dropped because the mailbox was full.
+       *
+       * @return (unsigned long) the number of dropped messages
+       */
+      unsigned long getDropped() const;
+
+      /**
+       * Adds a message to the mailbox and wakes the handler, if any.  This is called by the Coordinator when a message is
+       * pushed to the sub device.
+       *
+       * @param message (const DCPResponse &) - the pushed message
+       */
+      void deliver(const DCPResponse &message);
+
+    private:
+      Scheduler *scheduler;
+      int handlerPid; // The PID of the handler or a negative value if there is none.
+
+      DCPResponse messages[MAILBOX_CAPACITY];
+      int head;
+      int size;
+      unsigned long dropped;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_MAILBOX */
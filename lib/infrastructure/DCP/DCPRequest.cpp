@@ -6,9 +6,12 @@
  */
 #include "Arduino.h"
 #include "DCPRequest.h"
+#include "StreamTransport.h"
 
 const String DCPMethodName[] = { "GET", "POST" };
 
+static unsigned long lastTimestamp = 0;  // The SESSION_TIMESTAMP of the most recently sent request.
+
 class DCPRequest::Implementation {
   public:
     const DCPMethod method;
@@ -17,11 +20,63 @@ class DCPRequest::Implementation {
 
     String data = "";
     bool sent = false;
+    unsigned long timestamp = 0;
 
     Implementation(const DCPMethod method, const String resource, const String sessionId): method(method), resource(resource), sessionId(sessionId) { }
 
     Implementation(const Implementation &original): method(original.method), resource(original.resource), sessionId(original.sessionId) {
       data = original.data;
+      sent = original.sent;
+      timestamp = original.timestamp;
+    }
+
+    /**
+     * Assigns the request a new SESSION_TIMESTAMP.  Responses are matched to requests by SESSION_TIMESTAMP, so two requests sent
+     * in the same millisecond cannot share one.  This also keeps the timestamp from being 0, which is reserved for messages
+     * pushed by the Master node.
+     */
+    void stamp() {
+      unsigned long now = millis();
+
+      if((long) (now - lastTimestamp) <= 0) {
+        now = lastTimestamp + 1;
+      }
+
+      lastTimestamp = now;
+      timestamp = now;
+    }
+
+    /**
+     * Writes the request in the DCP format.  The body is written from where it is rather than being copied behind the header.
+     *
+     * @param transport (DCPTransport &) - the transport to write the request to
+     *
+     * @return (bool) true iff the full request was written
+     */
+    bool writeTo(DCPTransport &transport) const {
+      // First Line: `METHOD RESOURCE\n`
+      String message = DCPMethodName[method];
+      message += ' ';
+      message += resource;
+      message += '\n';
+
+      // Second Line: `SESSION_ID:SESSION_TIMESTAMP\n`
+      message += sessionId;
+      message += ':';
+      message += String(timestamp);
+      message += '\n';
+
+      // Third Line: `CONTENT_LENGTH\n`
+      message += String(data.length());
+      message += '\n';
+
+      // Fourth Line: `DATA`
+      const DCPSegment segments[] = {
+        { (const uint8_t *) message.c_str(), message.length() },
+        { (const uint8_t *) data.c_str(), data.length() }
+      };
+
+      return (transport.write(segments, 2) == message.length() + data.length());
     }
 };
 
@@ -30,7 +85,11 @@ DCPRequest::DCPRequest(const DCPMethod method, const String resource, const Stri
 }
 
 DCPRequest::DCPRequest(const DCPRequest &originalRequest) {
-  implementation = new Implementation(originalRequest.implementation);
+  implementation = new Implementation(*originalRequest.implementation);
+}
+
+DCPRequest::~DCPRequest() {
+  delete implementation;
 }
 
 const DCPMethod DCPRequest::getMethod() const {
@@ -57,29 +116,52 @@ void DCPRequest::setMessage(String message) {
   implementation->data = message;
 }
 
-DCPResponse &DCPRequest::send(WiFiClient &client) {
-  // First Line: `METHOD RESOURCE\n`
-  const String methodName = DCPMethodName[implementation->method];
+unsigned long DCPRequest::getTimestamp() const {
+  return implementation->timestamp;
+}
 
-  client.write(methodName.c_str(), methodName.length());
-  client.write(' ');
-  client.write(implementation->resource.c_str(), implementation->resource.length());
-  client.write('\n');
+bool DCPRequest::write(DCPTransport &transport) {
+  implementation->stamp();
+  implementation->sent = true;
 
-  // Second Line: `SESSION_ID: SESSION_TIMESTAMP\n`
-  client.write(implementation->sessionId.c_str(), implementation->sessionId.length());
-  client.write(": ", 2);
-  client.write(millis());
+  return implementation->writeTo(transport);
+}
 
-  // Third Line: `CONTENT_LENGTH`
-  client.write(implementation->data.length());
+DCPResponse DCPRequest::send(DCPTransport &transport) {
+  if(!write(transport)) {
+    return DCPResponse(RESPONSE_TIMEOUT);
+  }
 
-  // Fourth Line: `DATA`
-  client.write(implementation->data.c_str(), implementation->data.length());
+  return DCPResponse(transport);
+}
 
-  implementation->sent = true;
+#ifdef ARDUINO
+  bool DCPRequest::write(WiFiClient &client) {
+    WiFiClientTransport transport(client);
 
-  client.flush();
+    return write(transport);
+  }
 
-  return DCPResponse(client);
-}
+  bool DCPRequest::write(WiFiUDP &socket, const IPAddress &address, const uint16_t port) {
+    if(!implementation->sent) {
+      implementation->stamp();
+    }
+
+    implementation->sent = true;
+
+    if(!socket.beginPacket(address, port)) {
+      return false;
+    }
+
+    StreamTransport transport(socket);
+    const bool written = implementation->writeTo(transport);
+
+    return (socket.endPacket() && written);
+  }
+
+  DCPResponse DCPRequest::send(WiFiClient &client) {
+    WiFiClientTransport transport(client);
+
+    return send(transport);
+  }
+#endif
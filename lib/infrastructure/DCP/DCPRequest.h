@@ -9,8 +9,14 @@
   #define _C1MOORE_INFRASTRUCTURE_DCP_REQUEST
 
   #include "Arduino.h"
-  #include "ESP8266WiFi.h"
+
+  #ifdef ARDUINO
+    #include "ESP8266WiFi.h"
+    #include "WiFiUdp.h"
+  #endif
+
   #include "DCPResponse.h"
+  #include "DCPTransport.h"
 
   /**
    * DCP requests use one of two methods for sending data.  These methods are both semantically and functionally meaningful and resemble HTTP/1.0 request methods.  DCPMethod
@@ -36,15 +42,23 @@
    * The METHOD is one of the 2 DCPMethods (GET, POST).  RESOURCE is similar to an HTTP path and details what resource is being accessed.
    *
    * SESSION_ID is the session ID assigned to the device when the device registered with the Master the last time it started.  SESSION_TIMESTAMP is the number of milliseconds
-   * since the device started.  SESSION_ID and SESSION_TIMESTAMP together form a unique code that allows a device to multiplex requests if necessary.
+   * since the device started.  SESSION_ID and SESSION_TIMESTAMP together form a unique code that allows a device to multiplex requests if necessary.  To keep the code unique,
+   * a request sent in the same millisecond as the previous one is given the next SESSION_TIMESTAMP instead.
    *
    * The CONTENT_LENGTH gives the number of bytes in the body of the request, identified by DATA.  DATA is any additional data required by the server to complete the request.
    * DATA is the only field that is optional.
+   *
+   * A request can also be sent as a single UDP datagram.  Datagrams can be lost, so a datagram is sent again, with the same SESSION_TIMESTAMP, until the response
+   * arrives.  The Master node must answer a repeated SESSION_ID:SESSION_TIMESTAMP with its earlier response instead of processing the request again.
+   *
+   * Requests are written to a DCPTransport, so the same request can be sent over the WiFi connection to the Master node or, on a host, over a loopback or a
+   * POSIX socket.  The WiFi overloads are only available when building for an Arduino.
    */
   class DCPRequest {
     public:
       DCPRequest(const DCPMethod method, const String resource, const String sessionId);
       DCPRequest(const DCPRequest &originalRequest);
+      ~DCPRequest();
 
       /**
        * Returns the DCPMethod used for this request.
@@ -89,14 +103,63 @@
       void setMessage(String message);
 
       /**
-       * Sends this request to the Master node.  It is important to check if the request has already been sent and only resend requests if absolutely necessary.
-       * The Master node will treat duplicates as a new message as the SESSION_TIMESTAMP is generated at the time the request is sent, not the time it is created.
+       * Returns the SESSION_TIMESTAMP this request was last sent with.
+       *
+       * @return (unsigned long) the SESSION_TIMESTAMP of this request or 0 if the request has not been sent
+       */
+      unsigned long getTimestamp() const;
+
+      /**
+       * Writes this request to the Master node without waiting for the response.  It is important to check if the request has already been sent and only resend
+       * requests if absolutely necessary.  The Master node will treat duplicates as a new message as the SESSION_TIMESTAMP is generated at the time the request is
+       * sent, not the time it is created.
+       *
+       * @param transport (DCPTransport &) - the transport connected to the Master node
+       *
+       * @return (bool) true iff the full request was written to the transport
+       */
+      bool write(DCPTransport &transport);
+
+      /**
+       * Sends this request to the Master node and waits for the response.  See `write()` for caveats on resending requests.
+       *
+       * @param transport (DCPTransport &) - the transport connected to the Master node
+       *
+       * @return (DCPResponse) the DCPResponse from the Master node
+       */
+      DCPResponse send(DCPTransport &transport);
+
+    #ifdef ARDUINO
+      /**
+       * Writes this request to the Master node over a WiFiClient (see `write(DCPTransport &)`).
+       *
+       * @param client (WiFiClient &) - the WiFiClient that can be used to send the request
+       *
+       * @return (bool) true iff the full request was written to the client
+       */
+      bool write(WiFiClient &client);
+
+      /**
+       * Writes this request to the Master node as a single datagram without waiting for the response.  Unlike `write(WiFiClient &)`, a request that has already
+       * been sent keeps its SESSION_TIMESTAMP, so writing it again retransmits it and the Master node can recognize the duplicate.
+       *
+       * @param socket (WiFiUDP &) - the socket used to send the datagram
+       * @param address (const IPAddress &) - the address of the Master node
+       * @param port (const uint16_t) - the port the Master node receives datagrams on
+       *
+       * @return (bool) true iff the datagram was sent
+       */
+      bool write(WiFiUDP &socket, const IPAddress &address, const uint16_t port);
+
+      /**
+       * Sends this request to the Master node and waits for the response.  See `write()` for caveats on resending requests.
        *
        * @param client (WiFiClient &) - the WiFiClient that can be used to send the request
        *
-       * @return (DCPResponse &) a reference to the DCPResponse from the Master node
+       * @return (DCPResponse) the DCPResponse from the Master node
        */
-      DCPResponse &send(WiFiClient &client);
+      DCPResponse send(WiFiClient &client);
+    #endif
 
     private:
       class Implementation;
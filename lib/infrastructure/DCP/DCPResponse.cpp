@@ -5,7 +5,8 @@
  *      Author: c1moore
  */
 #include "DCPResponse.h"
-#include "Scheduler.h"
+#include "StreamTransport.h"
+#include "../../scheduler/Scheduler.h"
 
 #define DEVICEID_LENGTH         16
 #define SUBDEVICEID_LENGTH      8
@@ -14,15 +15,60 @@
 
 class DCPResponse::Implementation {
   public:
-    static const int MAX_ATTEMPTS = 20;
-    static const int DELAY = 100;
+    static const unsigned long TIMEOUT = 2000;
 
-    static Scheduler &scheduler = Scheduler::getInstance();
+    Implementation(DCPResponse &response, DCPTransport &transport): response(response), transport(transport) {
+      readable = transport.getReadable();
+      start = millis();
+    }
+
+    /**
+     * Returns the next byte of the response without reading it.
+     *
+     * @return (int) the next byte or -1 if none has arrived
+     */
+    int peekByte() {
+      if(windowLength == 0) {
+        release();
+
+        windowLength = transport.peek(&window);
+      }
+
+      return (windowLength > 0) ? window[0] : -1;
+    }
+
+    /**
+     * Reads the next byte of the response.  The byte is consumed from the transport once the bytes exposed with it have all
+     * been read or parsing ends, so a transport that exposes its buffer is consumed once rather than byte by byte.
+     *
+     * @return (int) the byte or -1 if none has arrived
+     */
+    int readByte() {
+      const int byte = peekByte();
+
+      if(byte >= 0) {
+        window++;
+        windowLength--;
+        unconsumed++;
+      }
 
-    Implementation(DCPResponse &response, WiFiClient &client): response(response), client(client) { }
+      return byte;
+    }
+
+    /**
+     * Consumes the bytes read from the transport so far.  This must be called before the transport is used again.
+     */
+    void release() {
+      if(unconsumed > 0) {
+        transport.consume(unconsumed);
+      }
+
+      unconsumed = 0;
+      windowLength = 0;
+    }
 
     /**
-     * Parses the device ID from the current position in the response, as tracked by the WiFiClient.  When parsing a DCPResponse, this method should be called first.  If
+     * Parses the device ID from the current position in the response, as tracked by the transport.  When parsing a DCPResponse, this method should be called first.  If
      * the response has not yet been received or not enough data has been received yet, this method will wait for additional data from the server until either
      *  - enough bytes have been received to fully parse the device ID
      *  - a predefined timeout shared amongst all the parsing methods to be reached
@@ -39,17 +85,17 @@ class DCPResponse::Implementation {
           return false;
         }
 
-        char nextChar = client.peek();
+        char nextChar = peekByte();
 
         if(nextChar == ':' || nextChar == '\n') {
           break;
         }
 
-        deviceId[charIndex++] = client.read();
+        deviceId[charIndex++] = readByte();
       }
 
-      if(client.peek() == ':') {
-        client.read();
+      if(peekByte() == ':') {
+        readByte();
       }
 
       return true;
@@ -74,14 +120,14 @@ class DCPResponse::Implementation {
           return false;
         }
 
-        if(client.peek() == '\n') {
+        if(peekByte() == '\n') {
           break;
         }
 
-        subDeviceId[charIndex++] = client.read();
+        subDeviceId[charIndex++] = readByte();
       }
 
-      if(client.read() != '\n') {
+      if(readByte() != '\n') {
         handleInvalidResponse();
 
         return false;
@@ -107,14 +153,14 @@ class DCPResponse::Implementation {
           return false;
         }
 
-        if(client.peek() == ':') {
+        if(peekByte() == ':') {
           break;
         }
 
-        subDeviceId[charIndex++] = client.read();
+        sessionId[charIndex++] = readByte();
       }
 
-      if(client.read() != ':') {
+      if(readByte() != ':') {
         handleInvalidResponse();
 
         return false;
@@ -136,7 +182,7 @@ class DCPResponse::Implementation {
     unsigned long parseSessionTimestamp() {
       static const int MAX_LONG_DIGITS = 10;
 
-      char digits[] = new char[MAX_LONG_DIGITS];
+      char digits[MAX_LONG_DIGITS];
       int digitIndex = 0;
 
       while(digitIndex < MAX_LONG_DIGITS) {
@@ -144,11 +190,11 @@ class DCPResponse::Implementation {
           return 0;
         }
 
-        if(client.peek() == '\n') {
+        if(peekByte() == '\n') {
           break;
         }
 
-        char nextDigit = client.read();
+        char nextDigit = readByte();
 
         if(nextDigit < '0' || nextDigit > '9') {
           handleInvalidResponse();
@@ -159,7 +205,7 @@ class DCPResponse::Implementation {
         digits[digitIndex++] = nextDigit;
       }
 
-      if(client.read() != '\n') {
+      if(readByte() != '\n') {
         handleInvalidResponse();
 
         return 0;
@@ -168,8 +214,8 @@ class DCPResponse::Implementation {
       // Convert the char[] to a long.
       unsigned long timestamp = 0L;
 
-      while(--digitIndex >= 0) {
-        unsigned long tempValue = (timestamp * 10) + (unsigned long) (digits[digitIndex] - '0');
+      for(int index = 0; index < digitIndex; index++) {
+        unsigned long tempValue = (timestamp * 10) + (unsigned long) (digits[index] - '0');
 
         if(tempValue < timestamp) {
           // Overflow detected.  Not bullet-proof, though.
@@ -193,26 +239,38 @@ class DCPResponse::Implementation {
      */
     DCPStatus parseStatus() {
       if(!waitForByte()) {
-        handleResponseTimeout();
-
         return response.statusCode;
       }
 
-      int statusCode = (client.read() - '0') * 10;
+      int statusCode = (readByte() - '0') * 10;
       if(statusCode > 50 || statusCode < 0) {
         handleInvalidResponse();
 
         return response.statusCode;
       }
 
-      int subStatusDigit = client.read() - '0';
+      if(!waitForByte()) {
+        return response.statusCode;
+      }
+
+      int subStatusDigit = readByte() - '0';
       if(subStatusDigit < 0 || subStatusDigit > 9) {
         handleInvalidResponse();
 
         return response.statusCode;
       }
 
-      return (statusCode + subStatusDigit);
+      if(!waitForByte()) {
+        return response.statusCode;
+      }
+
+      if(readByte() != '\n') {
+        handleInvalidResponse();
+
+        return response.statusCode;
+      }
+
+      return (DCPStatus) (statusCode + subStatusDigit);
     }
 
     /**
@@ -226,7 +284,7 @@ class DCPResponse::Implementation {
     unsigned int parseContentLength() {
       static const int MAX_INT_DIGITS = 10;
 
-      char digits[] = new char[MAX_INT_DIGITS];
+      char digits[MAX_INT_DIGITS];
       int digitIndex = 0;
 
       while(digitIndex < MAX_INT_DIGITS) {
@@ -234,11 +292,11 @@ class DCPResponse::Implementation {
           return 0;
         }
 
-        if(client.peek() == '\n') {
+        if(peekByte() == '\n') {
           break;
         }
 
-        char nextDigit = client.read();
+        char nextDigit = readByte();
 
         if(nextDigit < '0' || nextDigit > '9') {
           handleInvalidResponse();
@@ -249,7 +307,7 @@ class DCPResponse::Implementation {
         digits[digitIndex++] = nextDigit;
       }
 
-      if(client.read() != '\n') {
+      if(readByte() != '\n') {
         handleInvalidResponse();
 
         return 0;
@@ -258,8 +316,8 @@ class DCPResponse::Implementation {
       // Convert the char[] to a long.
       unsigned int contentLength = 0;
 
-      while(--digitIndex >= 0) {
-        unsigned int tempValue = (contentLength * 10) + (unsigned int) (digits[digitIndex] - '0');
+      for(int index = 0; index < digitIndex; index++) {
+        unsigned int tempValue = (contentLength * 10) + (unsigned int) (digits[index] - '0');
 
         if(tempValue < contentLength) {
           // Overflow detected.  Not bullet-proof, though.
@@ -280,59 +338,156 @@ class DCPResponse::Implementation {
      *  - a predefined timeout shared amongst all the parsing methods to be reached
      *
      * @param body (char *) - a char buffer with a capacity of CONTENT_LENGTH bytes that will hold the parsed body
+     * @param contentLength (const unsigned int) - the CONTENT_LENGTH of the response
      *
      * @return (bool) true iff the body was successfully parsed
      */
-    bool parseBody(char *body) {
-      int charIndex = 0;
+    bool parseBody(char *body, const unsigned int contentLength) {
+      unsigned int charIndex = 0;
 
-      while(charIndex < response.contentLength) {
+      while(charIndex < contentLength) {
         if(!waitForByte()) {
           return false;
         }
 
-        subDeviceId[charIndex++] = client.read();
+        // Copy as much of the body as the transport exposes at once.
+        size_t length = contentLength - charIndex;
+
+        if(length > windowLength) {
+          length = windowLength;
+        }
+
+        memcpy(body + charIndex, window, length);
+
+        charIndex += length;
+        window += length;
+        windowLength -= length;
+        unconsumed += length;
       }
 
       return true;
     }
 
-  private:
-    DCPResponse &response;
-    WiFiClient &client;
+    /**
+     * Parses the full response, populating the DCPResponse.  If any field cannot be parsed, the DCPResponse is left with the
+     * RESPONSE_TIMEOUT or INVALID_RESPONSE status and default values for every other field.
+     *
+     * @return (bool) true iff the response was successfully parsed
+     */
+    bool parse() {
+      char deviceId[DEVICEID_LENGTH + 1] = { 0 };
+      if(!parseDeviceId(deviceId)) {
+        return false;
+      }
+
+      char subDeviceId[SUBDEVICEID_LENGTH + 1] = { 0 };
+      if(!parseSubDeviceId(subDeviceId)) {
+        return false;
+      }
+
+      char sessionId[SESSIONID_LENGTH + 1] = { 0 };
+      if(!parseSessionId(sessionId)) {
+        return false;
+      }
+
+      const unsigned long sessionTimestamp = parseSessionTimestamp();
+      if(response.statusCode != SUCCESS) {
+        return false;
+      }
+
+      const DCPStatus statusCode = parseStatus();
+      if(response.statusCode != SUCCESS) {
+        return false;
+      }
+
+      // Only 24 and 50 are guaranteed to omit the body.  5X statuses sent by the Master, such as SERVER_DOWN, can describe the
+      // problem in the body.
+      unsigned int contentLength = 0;
+      String data = "";
+
+      if(statusCode != SUCCESS_NOCONTENT && statusCode != SERVER_ERROR) {
+        contentLength = parseContentLength();
+        if(response.statusCode != SUCCESS) {
+          return false;
+        }
+
+        if(contentLength != 0) {
+          char *body = new char[contentLength + 1];
+          body[contentLength] = 0;
+
+          const bool parsed = parseBody(body, contentLength);
 
-    int attempts = 0;
+          if(parsed) {
+            data = String(body);
+          }
+
+          delete[] body;
+
+          if(!parsed) {
+            return false;
+          }
+        }
+      }
+
+      response.deviceId = String(deviceId);
+      response.subDeviceId = String(subDeviceId);
+      response.sessionId = String(sessionId);
+      response.sessionTimestamp = sessionTimestamp;
+      response.statusCode = statusCode;
+      response.contentLength = contentLength;
+      response.data = data;
+
+      return true;
+    }
 
     /**
-     * Waits for 1 byte of data from the Master node.
+     * Waits for 1 byte of data from the Master node.  Rather than polling the transport, the current process waits for the
+     * transport to become readable, allowing other processes to execute in the meantime.  A datagram cannot become readable
+     * later, so running out of bytes in one means the response is invalid.
      *
      * @return (bool) true if a byte was successfully received; false if a timeout was reached before the byte was received
      */
     bool waitForByte() {
-      while(client.peek() == 0) {
-        if(attempts > Implementation::MAX_ATTEMPTS) {
-          handleResponseTimeout();
+      if(peekByte() >= 0) {
+        return true;
+      }
 
-          return false;
-        }
+      if(readable == NULL) {
+        handleInvalidResponse();
+
+        return false;
+      }
 
-        attempts++;
+      const unsigned long elapsed = millis() - start;
 
-        Implementation::scheduler.sleep(Implementation::DELAY);
+      if(elapsed >= Implementation::TIMEOUT || Scheduler::current().await(*readable, Implementation::TIMEOUT - elapsed) != 0 || peekByte() < 0) {
+        handleResponseTimeout();
+
+        return false;
       }
 
       return true;
     }
 
+    DCPResponse &response;
+    DCPTransport &transport;
+
+    Pollable *readable;       // Used to wait for the transport to become readable or NULL if the response is in a datagram.
+    unsigned long start;      // The time, in milliseconds, parsing started.  The TIMEOUT is shared amongst all the parsing methods.
+
+    const uint8_t *window = NULL;   // The bytes last exposed by the transport that have not been read.
+    size_t windowLength = 0;
+    size_t unconsumed = 0;          // The number of bytes read that have not been consumed from the transport yet.
+
     /**
      * Handles a response timeout, setting all fields of the DCPResponse to a default value for the RESPONSE_TIMEOUT error.  Even fields previously parsed will be set to the
      * default value for the field.
      */
-    void handleResponseTimeout() const {
+    void handleResponseTimeout() {
       response.deviceId = "";
       response.subDeviceId = "";
       response.sessionId = "";
-      response.sessionTimestamp = "";
+      response.sessionTimestamp = 0;
 
       response.statusCode = RESPONSE_TIMEOUT;
 
@@ -344,11 +499,11 @@ class DCPResponse::Implementation {
      * Handles an invalid response received from the Master node.  This method sets all fields of the DCPResponse to a default value for the INVALID_RESPONSE error.  For security
      * purposes, all fields are set to the default value even if some fields have been successfully parsed.
      */
-    void handleInvalidResponse() const {
+    void handleInvalidResponse() {
       response.deviceId = "";
       response.subDeviceId = "";
       response.sessionId = "";
-      response.sessionTimestamp = "";
+      response.sessionTimestamp = 0;
 
       response.statusCode = INVALID_RESPONSE;
 
@@ -357,67 +512,35 @@ class DCPResponse::Implementation {
     }
 };
 
-DCPResponse::DCPResponse(WiFiClient &client) {
-  implementation = new Implementation(&this, client);
-
-  if(!implementation->waitForByte()) {
-    return;
-  }
+DCPResponse::DCPResponse(DCPTransport &transport): DCPResponse(SUCCESS) {
+  read(transport);
+}
 
-  // Now for the tricky part due to the nature of WiFiClient.  WiFiClient doesn't block until the requested size is received, so we'll read this char by char.
-  // We _could_ use something like Flex/Bison, but this seems like overkill for this situation.
-  int charIndex;
+#ifdef ARDUINO
+  DCPResponse::DCPResponse(WiFiClient &client): DCPResponse(SUCCESS) {
+    WiFiClientTransport transport(client);
 
-  // Parse the deviceId
-  char deviceId[DEVICEID_LENGTH + 1] = { 0 };
-  if(!implementation->parseDeviceId(deviceId)) {
-    return;
+    read(transport);
   }
 
-  // Parse the subDeviceId
-  char subDeviceId[SUBDEVICEID_LENGTH + 1] = { 0 };
-  if(!implementation->parseSubDeviceId(subDeviceId)) {
-    return;
-  }
+  DCPResponse::DCPResponse(WiFiUDP &socket): DCPResponse(SUCCESS) {
+    StreamTransport transport(socket);
 
-  // Parse the sessionId.
-  char sessionId[SESSIONID_LENGTH + 1] = { 0 };
-  if(!implementation->parseSessionId(sessionId)) {
-    return;
-  }
-
-  // Parse the sessionTimestamp
-  sessionTimestamp = implementation->parseSessionTimestamp();
-  if(statusCode == INVALID_RESPONSE) {
-    return;
+    read(transport);
   }
+#endif
 
-  // Parse the statusCode
-  statusCode = implementation->parseStatus();
-
-  // If the statusCode suggests there is further data, parse the content.
-  if(statusCode != SUCCESS_NOCONTENT || statusCode != SERVER_ERROR || statusCode != RESPONSE_TIMEOUT || statusCode != INVALID_RESPONSE) {
-    contentLength = implementation->parseContentLength();
-
-    if(contentLength != 0) {
-      char data[] = new char[contentLength];
-
-      if(!implementation->parseBody(data)) {
-        return;
-      }
-
-      this->data = String(data);
-    }
-  }
-
-  this->deviceId = String(deviceId);
-  this->subDeviceId = String(subDeviceId);
-  this->sessionId = String(sessionId);
+DCPResponse::DCPResponse(const DCPStatus statusCode): sessionTimestamp(0), statusCode(statusCode), contentLength(0) {
+  implementation = NULL;
 }
 
 DCPResponse::DCPResponse(const DCPResponse &originalResponse) {
-  implementation = nullptr;
+  implementation = NULL;
+
+  *this = originalResponse;
+}
 
+DCPResponse &DCPResponse::operator=(const DCPResponse &originalResponse) {
   deviceId = originalResponse.deviceId;
   subDeviceId = originalResponse.subDeviceId;
   sessionId = originalResponse.sessionId;
@@ -427,10 +550,24 @@ DCPResponse::DCPResponse(const DCPResponse &originalResponse) {
 
   contentLength = originalResponse.contentLength;
   data = originalResponse.data;
+
+  return *this;
+}
+
+void DCPResponse::read(DCPTransport &transport) {
+  implementation = new Implementation(*this, transport);
+
+  // Now for the tricky part due to the nature of the transports.  They don't block until the requested size is received, so we'll read this char by char.
+  // We _could_ use something like Flex/Bison, but this seems like overkill for this situation.
+  implementation->parse();
+  implementation->release();
+
+  delete implementation;
+  implementation = NULL;
 }
 
 DCPResponse::~DCPResponse() {
-  if(implementation == nullptr) {
+  if(implementation == NULL) {
     return;
   }
 
@@ -9,7 +9,13 @@
   #define _C1MOORE_INFRASTRUCTURE_DCP_RESPONSE
 
   #include "Arduino.h"
-  #include "ESP8266WiFi.h"
+
+  #ifdef ARDUINO
+    #include "ESP8266WiFi.h"
+    #include "WiFiUdp.h"
+  #endif
+
+  #include "DCPTransport.h"
 
   /**
    * DCP responses include a numeric status.  In addition to providing information on how the request was handled, the status can affect the structure of the response.  For
@@ -42,7 +48,9 @@
    * DEVICE_ID corresponds the the unique ID of the device that sent the request, as provided by the Master node.  SUDEVICE_ID is optional.  If provided, it corresponds to the unique
    * ID of the input or output device connected to the device to which the message corresponds.
    *
-   * The SESSION_ID and SESSION_TIMESTAMP have the same value was the request.  These values can be used for multiplexing, if necessary.
+   * The SESSION_ID and SESSION_TIMESTAMP have the same value was the request.  These values can be used for multiplexing, if necessary.  The Master node can also push
+   * a message to a sub device without being asked, using the same structure with a SESSION_TIMESTAMP of 0.  Requests never use 0, so pushed messages cannot be
+   * mistaken for responses.
    *
    * The STATUS_CODE is one of the DCPStatus codes and corresponds to the status of the request/response.
    *
@@ -51,28 +59,65 @@
    */
   class DCPResponse {
     public:
-      const String deviceId;
-      const String subDeviceId;
-      const String sessionId;
-      const unsigned long sessionTimestamp;
+      String deviceId;
+      String subDeviceId;
+      String sessionId;
+      unsigned long sessionTimestamp;
+
+      DCPStatus statusCode;
 
-      const DCPStatus statusCode;
+      unsigned int contentLength;
+      String data;
 
-      const unsigned int contentLength;
-      const String data;
+      /**
+       * Parses a DCPResponse from the transport.  The current process waits for the response to arrive, allowing other processes
+       * to execute in the meantime.  If the response does not arrive in time or cannot be parsed, the status will be
+       * RESPONSE_TIMEOUT or INVALID_RESPONSE, respectively.  Only the bytes of the response are consumed from the transport.
+       *
+       * @param transport (DCPTransport &) - the transport connected to the Master node
+       */
+      DCPResponse(DCPTransport &transport);
 
+    #ifdef ARDUINO
+      /**
+       * Parses a DCPResponse from the client (see `DCPResponse(DCPTransport &)`).
+       *
+       * @param client (WiFiClient &) - the client connected to the Master node
+       */
       DCPResponse(WiFiClient &client);
+
+      /**
+       * Parses a DCPResponse from the datagram most recently received by `socket`, as returned by `WiFiUDP::parsePacket()`.  A
+       * datagram holds the whole response, so this never waits; a datagram that ends early has the INVALID_RESPONSE status.
+       *
+       * @param socket (WiFiUDP &) - the socket that received the datagram
+       */
+      DCPResponse(WiFiUDP &socket);
+    #endif
+
+      /**
+       * Creates an empty DCPResponse with the given status.  This is used for responses generated by this device, such as
+       * RESPONSE_TIMEOUT when the Master node could not be reached.
+       *
+       * @param statusCode (const DCPStatus) _optional_ - the status of the response.  Default: SUCCESS_NOCONTENT
+       */
+      DCPResponse(const DCPStatus statusCode = SUCCESS_NOCONTENT);
       DCPResponse(const DCPResponse &originalResponse);
       ~DCPResponse();
 
+      DCPResponse &operator=(const DCPResponse &originalResponse);
+
     private:
       class Implementation;
 
       Implementation *implementation;
 
-      DCPResponse(): statusCode(INVALID_RESPONSE), contentLength(0), sessionTimestamp(0) {
-        implementation = NULL;
-      }
+      /**
+       * Parses the response from the transport into this DCPResponse.
+       *
+       * @param transport (DCPTransport &) - the transport connected to the Master node
+       */
+      void read(DCPTransport &transport);
   };
 
 #endif /* _C1MOORE_INFRASTRUCTURE_DCP_RESPONSE */
@@ -0,0 +1,84 @@
+/*
+ * DCPTransport.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_TRANSPORT
+  #define _C1MOORE_INFRASTRUCTURE_DCP_TRANSPORT
+
+  #include <stddef.h>
+  #include <stdint.h>
+
+  #include "../../scheduler/Pollable.h"
+
+  /**
+   * DCPSegment is one piece of a message written with `DCPTransport::write()`.
+   */
+  struct DCPSegment {
+    const uint8_t *data;
+    size_t length;
+  };
+
+  /**
+   * DCPTransport carries DCP messages between this device and the Master node, so DCPRequest and DCPResponse do not depend on
+   * how the bytes travel.  Adapters exist for
+   *  - a WiFiClient or any other Stream (see StreamTransport)
+   *  - an in-memory loopback, used to run the request/response path on a host without a network (see LoopbackTransport)
+   *  - a POSIX socket, used when simulating devices on a host (see SocketTransport)
+   *
+   * Writes are scatter/gather: a message is written as a list of segments, so a request body is written from where it already
+   * is instead of being copied behind its header first.  Reads are peek/consume: `peek()` exposes the bytes that can be read
+   * without copying them, where the adapter can, and `consume()` discards them once they have been parsed.  Nothing is read
+   * past what is consumed, so several messages can be parsed from the same connection one after the other even if each is
+   * parsed through a different adapter.
+   */
+  class DCPTransport {
+    public:
+      DCPTransport() {}
+      virtual ~DCPTransport() {};
+
+      /**
+       * Writes the segments, in order, as one message.  Adapters write the message in as few packets as they can.
+       *
+       * @param segments (const DCPSegment *) - the segments of the message
+       * @param count (const int) - the number of segments
+       *
+       * @return (size_t) the number of bytes written, which is less than the length of the message if the write failed
+       */
+      virtual size_t write(const DCPSegment *segments, const int count) = 0;
+
+      /**
+       * Returns the number of bytes that can be read without waiting.
+       *
+       * @return (size_t) the number of bytes that can be read
+       */
+      virtual size_t available() = 0;
+
+      /**
+       * Exposes the next bytes that can be read without consuming them.  The bytes stay valid until the next call to `consume()`
+       * or `write()`.  An adapter may expose fewer bytes than `available()`, but exposes at least 1 if any is available.
+       *
+       * @param data (const uint8_t **) - set to the first byte
+       *
+       * @return (size_t) the number of bytes exposed or 0 if none can be read
+       */
+      virtual size_t peek(const uint8_t **data) = 0;
+
+      /**
+       * Discards bytes that were exposed by `peek()`.
+       *
+       * @param length (const size_t) - the number of bytes to discard, which must not exceed the number last exposed
+       */
+      virtual void consume(const size_t length) = 0;
+
+      /**
+       * Returns a condition that holds once more bytes can be read, so a process can wait for them using `Scheduler::await()`.
+       *
+       * @return (Pollable *) the condition or NULL if no more bytes will arrive while a message is parsed, such as when the whole
+       *  message arrived in one datagram
+       */
+      virtual Pollable *getReadable() = 0;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_TRANSPORT */
@@ -0,0 +1,87 @@
+/*
+ * LoopbackTransport.cpp
+ *
+ *      Author: c1moore
+ */
+#include <string.h>
+
+#include "LoopbackTransport.h"
+
+LoopbackTransport::LoopbackTransport(const size_t capacity): capacity(capacity), head(0), tail(0), peer(this) {
+  inbox = new uint8_t[capacity];
+}
+
+LoopbackTransport::~LoopbackTransport() {
+  if(peer != this) {
+    peer->peer = peer;
+  }
+
+  delete[] inbox;
+}
+
+void LoopbackTransport::pair(LoopbackTransport &peer) {
+  this->peer = &peer;
+  peer.peer = this;
+}
+
+void LoopbackTransport::clear() {
+  head = 0;
+  tail = 0;
+}
+
+size_t LoopbackTransport::write(const DCPSegment *segments, const int count) {
+  size_t written = 0;
+
+  for(int index = 0; index < count; index++) {
+    const size_t delivered = peer->deliver(segments[index].data, segments[index].length);
+
+    written += delivered;
+
+    if(delivered < segments[index].length) {
+      break;
+    }
+  }
+
+  return written;
+}
+
+size_t LoopbackTransport::available() {
+  return tail - head;
+}
+
+size_t LoopbackTransport::peek(const uint8_t **data) {
+  *data = inbox + head;
+
+  return tail - head;
+}
+
+void LoopbackTransport::consume(const size_t length) {
+  head += length;
+
+  if(head >= tail) {
+    clear();
+  }
+}
+
+Pollable *LoopbackTransport::getReadable() {
+  return NULL;
+}
+
+size_t LoopbackTransport::deliver(const uint8_t *data, size_t length) {
+  // Move the unread bytes to the front only when the new ones do not fit behind them.
+  if(tail + length > capacity && head > 0) {
+    memmove(inbox, inbox + head, tail - head);
+
+    tail -= head;
+    head = 0;
+  }
+
+  if(tail + length > capacity) {
+    length = capacity - tail;
+  }
+
+  memcpy(inbox + tail, data, length);
+  tail += length;
+
+  return length;
+}
@@ -0,0 +1,80 @@
+/*
+ * LoopbackTransport.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_LOOPBACKTRANSPORT
+  #define _C1MOORE_INFRASTRUCTURE_DCP_LOOPBACKTRANSPORT
+
+  #include "DCPTransport.h"
+
+  // The default number of bytes a LoopbackTransport can hold before they are read.
+  #ifndef LOOPBACK_CAPACITY
+    #define LOOPBACK_CAPACITY 1024
+  #endif
+
+  /**
+   * LoopbackTransport is an in-memory DCPTransport.  It exists so the request/response path can be exercised and timed on a host
+   * at memory speed, without a network or a Master node.
+   *
+   * Each LoopbackTransport has an inbox that its `peek()` reads from directly, without copying.  By itself, what is written to a
+   * LoopbackTransport is written to its own inbox.  Two LoopbackTransports can be paired with `pair()` to stand for the two ends
+   * of a connection, so what one end writes is read by the other: a stand-in for the Master node reads the request from its end
+   * and writes the response for the device to parse.
+   *
+   * The bytes of a message must all be written before it is parsed, since `getReadable()` is NULL: there is nothing to wait
+   * for.  A write that does not fit in the inbox is cut short, as a full socket buffer would.  A LoopbackTransport owns its
+   * inbox, so it cannot be copied.
+   */
+  class LoopbackTransport: public DCPTransport {
+    public:
+      /**
+       * Creates a new LoopbackTransport with an empty inbox.
+       *
+       * @param capacity (const size_t) _optional_ - the number of bytes the inbox can hold.  Default: LOOPBACK_CAPACITY
+       */
+      LoopbackTransport(const size_t capacity = LOOPBACK_CAPACITY);
+      ~LoopbackTransport();
+
+      LoopbackTransport(LoopbackTransport const &transport) = delete;
+      void operator=(LoopbackTransport const &transport) = delete;
+
+      /**
+       * Pairs this LoopbackTransport with `peer`, so what each writes is read by the other.
+       *
+       * @param peer (LoopbackTransport &) - the other end
+       */
+      void pair(LoopbackTransport &peer);
+
+      /**
+       * Empties the inbox.
+       */
+      void clear();
+
+      size_t write(const DCPSegment *segments, const int count);
+      size_t available();
+      size_t peek(const uint8_t **data);
+      void consume(const size_t length);
+      Pollable *getReadable();
+
+    private:
+      /**
+       * Appends bytes to the inbox.
+       *
+       * @param data (const uint8_t *) - the bytes
+       * @param length (size_t) - the number of bytes
+       *
+       * @return (size_t) the number of bytes that fit
+       */
+      size_t deliver(const uint8_t *data, size_t length);
+
+      uint8_t *inbox;
+      const size_t capacity;
+      size_t head;    // The index of the first byte that has not been read.
+      size_t tail;    // The index after the last byte written.
+
+      LoopbackTransport *peer;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_LOOPBACKTRANSPORT */
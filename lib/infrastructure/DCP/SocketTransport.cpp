@@ -0,0 +1,81 @@
+/*
+ * SocketTransport.cpp
+ *
+ *      Author: c1moore
+ */
+#ifndef ARDUINO
+  #include <sys/ioctl.h>
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+
+  #include "SocketTransport.h"
+
+  // The most segments written at once.  DCP messages have a header and a body.
+  #define SOCKET_MAX_SEGMENTS 8
+
+  SocketTransport::SocketTransport(const int fd): fd(fd), readable(fd, SOCKET_READABLE) { }
+
+  size_t SocketTransport::write(const DCPSegment *segments, const int count) {
+    struct iovec vectors[SOCKET_MAX_SEGMENTS];
+    size_t written = 0;
+
+    for(int first = 0; first < count; first += SOCKET_MAX_SEGMENTS) {
+      int vectorCount = 0;
+      size_t expected = 0;
+
+      for(int index = first; index < count && vectorCount < SOCKET_MAX_SEGMENTS; index++) {
+        vectors[vectorCount].iov_base = (void *) segments[index].data;
+        vectors[vectorCount].iov_len = segments[index].length;
+
+        expected += segments[index].length;
+        vectorCount++;
+      }
+
+      const ssize_t result = ::writev(fd, vectors, vectorCount);
+
+      if(result <= 0) {
+        break;
+      }
+
+      written += result;
+
+      // A short write means the socket buffer is full; the caller decides whether to drop the connection.
+      if((size_t) result < expected) {
+        break;
+      }
+    }
+
+    return written;
+  }
+
+  size_t SocketTransport::available() {
+    int bytes = 0;
+
+    if(::ioctl(fd, FIONREAD, &bytes) < 0 || bytes < 0) {
+      return 0;
+    }
+
+    return bytes;
+  }
+
+  size_t SocketTransport::peek(const uint8_t **data) {
+    const ssize_t result = ::recv(fd, peeked, SOCKET_PEEK_BUFFER, MSG_PEEK | MSG_DONTWAIT);
+
+    if(result <= 0) {
+      return 0;
+    }
+
+    *data = peeked;
+
+    return result;
+  }
+
+  void SocketTransport::consume(const size_t length) {
+    // The bytes were already peeked, so they are in the socket buffer and this does not block.
+    ::recv(fd, peeked, length, MSG_DONTWAIT);
+  }
+
+  Pollable *SocketTransport::getReadable() {
+    return &readable;
+  }
+#endif
@@ -0,0 +1,51 @@
+/*
+ * SocketTransport.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_SOCKETTRANSPORT
+  #define _C1MOORE_INFRASTRUCTURE_DCP_SOCKETTRANSPORT
+
+  #ifndef ARDUINO
+    #include "../SocketInterest.h"
+    #include "DCPTransport.h"
+
+    // The number of bytes `SocketTransport::peek()` exposes at most.
+    #ifndef SOCKET_PEEK_BUFFER
+      #define SOCKET_PEEK_BUFFER 256
+    #endif
+
+    /**
+     * SocketTransport adapts a connected POSIX stream socket to a DCPTransport, so a simulated device can talk to a Master node, or
+     * to a stand-in for one, over a real connection.  Segments are written with a single writev(2).  `peek()` copies up to
+     * SOCKET_PEEK_BUFFER bytes with MSG_PEEK, so nothing is taken from the socket until it is consumed.  Parsing waits for the
+     * socket to become readable (see SocketInterest).
+     *
+     * This is only available when building for a host (i.e. ARDUINO is not defined).  The socket is not closed by the
+     * SocketTransport.
+     */
+    class SocketTransport: public DCPTransport {
+      public:
+        /**
+         * Creates a new SocketTransport.
+         *
+         * @param fd (const int) - the connected socket
+         */
+        SocketTransport(const int fd);
+
+        size_t write(const DCPSegment *segments, const int count);
+        size_t available();
+        size_t peek(const uint8_t **data);
+        void consume(const size_t length);
+        Pollable *getReadable();
+
+      private:
+        const int fd;
+        SocketInterest readable;
+
+        uint8_t peeked[SOCKET_PEEK_BUFFER];
+    };
+  #endif
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_SOCKETTRANSPORT */
@@ -0,0 +1,76 @@
+/*
+ * StreamTransport.cpp
+ *
+ *      Author: c1moore
+ */
+#ifdef ARDUINO
+  #include "StreamTransport.h"
+
+  StreamTransport::StreamTransport(Stream &stream, Pollable *readable): stream(stream), readable(readable), next(0) { }
+
+  size_t StreamTransport::write(const DCPSegment *segments, const int count) {
+    uint8_t gathered[STREAM_GATHER_BUFFER];
+    size_t used = 0;
+    size_t written = 0;
+
+    for(int index = 0; index < count; index++) {
+      const DCPSegment &segment = segments[index];
+
+      if(used + segment.length <= STREAM_GATHER_BUFFER) {
+        memcpy(gathered + used, segment.data, segment.length);
+        used += segment.length;
+
+        continue;
+      }
+
+      if(used > 0) {
+        written += stream.write(gathered, used);
+        used = 0;
+      }
+
+      if(segment.length >= STREAM_GATHER_BUFFER) {
+        written += stream.write(segment.data, segment.length);
+      } else {
+        memcpy(gathered, segment.data, segment.length);
+        used = segment.length;
+      }
+    }
+
+    if(used > 0) {
+      written += stream.write(gathered, used);
+    }
+
+    return written;
+  }
+
+  size_t StreamTransport::available() {
+    const int bytes = stream.available();
+
+    return (bytes > 0) ? bytes : 0;
+  }
+
+  size_t StreamTransport::peek(const uint8_t **data) {
+    const int byte = stream.peek();
+
+    if(byte < 0) {
+      return 0;
+    }
+
+    next = byte;
+    *data = &next;
+
+    return 1;
+  }
+
+  void StreamTransport::consume(const size_t length) {
+    for(size_t index = 0; index < length; index++) {
+      stream.read();
+    }
+  }
+
+  Pollable *StreamTransport::getReadable() {
+    return readable;
+  }
+
+  WiFiClientTransport::WiFiClientTransport(WiFiClient &client): StreamTransport(client, &readable), readable(client, CLIENT_READABLE) { }
+#endif
@@ -0,0 +1,67 @@
+/*
+ * StreamTransport.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DCP_STREAMTRANSPORT
+  #define _C1MOORE_INFRASTRUCTURE_DCP_STREAMTRANSPORT
+
+  #ifdef ARDUINO
+    #include <Arduino.h>
+    #include <ESP8266WiFi.h>
+
+    #include "../ClientInterest.h"
+    #include "DCPTransport.h"
+
+    // The size, in bytes, of the buffer small segments are gathered in before they are written to the stream.  Segments at least
+    // this long are written directly.
+    #ifndef STREAM_GATHER_BUFFER
+      #define STREAM_GATHER_BUFFER 128
+    #endif
+
+    /**
+     * StreamTransport adapts a Stream, such as a WiFiUDP socket holding a received datagram, to a DCPTransport.  Small segments are
+     * gathered into one write, so a request and its short body leave in a single packet.
+     *
+     * A Stream does not expose its buffer, so `peek()` exposes a single byte and `consume()` reads it.  Nothing is read ahead,
+     * which keeps the stream aligned on the next message once the StreamTransport is discarded.
+     */
+    class StreamTransport: public DCPTransport {
+      public:
+        /**
+         * Creates a new StreamTransport.
+         *
+         * @param stream (Stream &) - the stream to adapt
+         * @param readable (Pollable *) _optional_ - the condition that holds once the stream can be read or NULL if no more bytes
+         *  will arrive, such as for a datagram.  Default: NULL
+         */
+        StreamTransport(Stream &stream, Pollable *readable = NULL);
+
+        size_t write(const DCPSegment *segments, const int count);
+        size_t available();
+        size_t peek(const uint8_t **data);
+        void consume(const size_t length);
+        Pollable *getReadable();
+
+      private:
+        Stream &stream;
+        Pollable *readable;
+
+        uint8_t next;   // The byte last exposed by `peek()`.
+    };
+
+    /**
+     * WiFiClientTransport adapts the persistent connection to the Master node to a DCPTransport.  Parsing waits for the client to
+     * become readable (see ClientInterest).
+     */
+    class WiFiClientTransport: public StreamTransport {
+      public:
+        WiFiClientTransport(WiFiClient &client);
+
+      private:
+        ClientInterest readable;
+    };
+  #endif
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DCP_STREAMTRANSPORT */
@@ -0,0 +1,327 @@
+/*
+ * DatagramTransport.cpp
+ *
+ *      Author: c1moore
+ */
+#include "DatagramTransport.h"
+#include "DCP/DCPResponse.h"
+
+class DatagramTransport::Implementation {
+  public:
+    // The minimum time, in milliseconds, between attempts to look up the Master node.
+    static const unsigned long RESOLVE_INTERVAL = 5000;
+
+    /**
+     * PendingDatagram tracks a request that has been sent but not answered.
+     */
+    struct PendingDatagram {
+      DCPRequest *request;        // A copy of the request, kept to retransmit it.
+      DCPCompletion *completion;  // The handle to complete once the response arrives or NULL.
+      unsigned long firstSent;    // The time, in milliseconds, the request was first sent.
+      unsigned long lastSent;     // The time, in milliseconds, the request was last sent.
+      unsigned long timeout;      // The time, in milliseconds, to wait after `lastSent` before sending the request again.
+      int retries;                // The number of times the request has been sent again.
+    };
+
+    MasterEndpoints &endpoints;
+
+    WiFiUDP socket;
+    bool open = false;
+
+    int target = -1;            // The index of the endpoint requests are sent to or -1 if it is not known yet.
+    IPAddress address;
+    uint16_t port = 0;
+    unsigned long lastResolve = 0;
+    bool resolved = false;
+
+    PendingDatagram pending[DATAGRAMS_IN_FLIGHT];  // Requests waiting for a response, oldest first.
+    int pendingCount = 0;
+
+    unsigned long history[DATAGRAM_HISTORY] = { 0 };  // The SESSION_TIMESTAMPs of the most recently answered requests.
+    int historyNext = 0;
+
+    DatagramStats stats = { 0, 0, 0, 0, 0, 0, 0 };
+
+    Implementation(MasterEndpoints &endpoints): endpoints(endpoints) {}
+
+    ~Implementation() {
+      for(int index = 0; index < pendingCount; index++) {
+        delete pending[index].request;
+      }
+    }
+
+    /**
+     * Opens the socket.
+     */
+    void begin() {
+      open = (socket.begin(DATAGRAM_PORT) != 0);
+    }
+
+    /**
+     * Follows the endpoint the persistent connection uses, so datagrams go to the same Master node, and looks up its address.
+     * Failed lookups are not retried more than once every RESOLVE_INTERVAL milliseconds since each one blocks.
+     */
+    void retarget() {
+      int index = endpoints.getCurrent();
+
+      if(index < 0) {
+        index = endpoints.select();
+      }
+
+      if(index < 0 || (index == target && resolved)) {
+        return;
+      }
+
+      if(index == target && millis() - lastResolve < RESOLVE_INTERVAL) {
+        return;
+      }
+
+      target = index;
+      lastResolve = millis();
+      resolved = endpoints.resolve(index, address);
+      port = endpoints.getDatagramPort(index);
+    }
+
+    /**
+     * Closes the socket and fails every request waiting for a response.  The Master node will be looked up again when the
+     * socket is reopened, since the device may have joined a different network.
+     */
+    void close() {
+      if(open) {
+        socket.stop();
+      }
+
+      open = false;
+      target = -1;
+      resolved = false;
+
+      for(int remaining = pendingCount; remaining > 0 && pendingCount > 0; remaining--) {
+        complete(0, DCPResponse(RESPONSE_TIMEOUT));
+      }
+    }
+
+    /**
+     * Reads the responses that have arrived and completes their requests.
+     */
+    void receive() {
+      for(int datagrams = 0; datagrams < 2 * DATAGRAMS_IN_FLIGHT && socket.parsePacket() > 0; datagrams++) {
+        if((uint32_t) socket.remoteIP() != (uint32_t) address) {
+          stats.invalid++;
+
+          continue;
+        }
+
+        DCPResponse response(socket);
+
+        if(response.statusCode == INVALID_RESPONSE || response.sessionTimestamp == 0) {
+          stats.invalid++;
+
+          continue;
+        }
+
+        const int index = find(response.sessionTimestamp);
+
+        if(index >= 0) {
+          stats.answered++;
+
+          // Only requests answered on the first attempt are timed; otherwise, there is no telling which copy was answered.
+          if(pending[index].retries == 0) {
+            endpoints.succeeded(target, millis() - pending[index].firstSent);
+          }
+
+          complete(index, response);
+        } else if(answered(response.sessionTimestamp)) {
+          stats.duplicates++;
+        } else {
+          stats.invalid++;
+        }
+      }
+    }
+
+    /**
+     * Sends again every request whose response is overdue, and completes the ones that have run out of retransmissions with
+     * RESPONSE_TIMEOUT.
+     */
+    void retransmit() {
+      const unsigned long now = millis();
+
+      for(int index = 0; index < pendingCount; index++) {
+        PendingDatagram &entry = pending[index];
+
+        if(now - entry.lastSent < entry.timeout) {
+          continue;
+        }
+
+        if(entry.retries >= DATAGRAM_RETRIES) {
+          stats.expired++;
+
+          // Completing the request removes it, so the next request is now at this index.
+          complete(index--, DCPResponse(RESPONSE_TIMEOUT));
+
+          continue;
+        }
+
+        entry.request->write(socket, address, port);
+        entry.lastSent = now;
+        entry.timeout *= 2;
+        entry.retries++;
+
+        stats.retransmits++;
+      }
+    }
+
+    /**
+     * Finds the request waiting for a response with the given SESSION_TIMESTAMP.
+     *
+     * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request
+     *
+     * @return (int) the index of the request or -1 if no such request is waiting
+     */
+    int find(const unsigned long timestamp) const {
+      for(int index = 0; index < pendingCount; index++) {
+        if(pending[index].request->getTimestamp() == timestamp) {
+          return index;
+        }
+      }
+
+      return -1;
+    }
+
+    /**
+     * Checks whether the request with the given SESSION_TIMESTAMP was answered recently.
+     *
+     * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request
+     *
+     * @return (bool) true iff the request is one of the last DATAGRAM_HISTORY requests answered
+     */
+    bool answered(const unsigned long timestamp) const {
+      for(int index = 0; index < DATAGRAM_HISTORY; index++) {
+        if(history[index] == timestamp) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    /**
+     * Completes the request at `index` with `response` and stops waiting for it.
+     *
+     * @param index (const int) - the index of the request
+     * @param response (const DCPResponse &) - the response to the request
+     */
+    void complete(const int index, const DCPResponse &response) {
+      DCPCompletion *completion = pending[index].completion;
+      const unsigned long latency = millis() - pending[index].firstSent;
+
+      history[historyNext] = pending[index].request->getTimestamp();
+      historyNext = (historyNext + 1) % DATAGRAM_HISTORY;
+
+      delete pending[index].request;
+
+      // Keep the remaining requests oldest first.
+      for(int next = index + 1; next < pendingCount; next++) {
+        pending[next - 1] = pending[next];
+      }
+
+      pendingCount--;
+
+      if(response.statusCode != RESPONSE_TIMEOUT) {
+        stats.lastLatency = latency;
+      }
+
+      // The request is removed first since the completion can schedule a process that sends another request.
+      if(completion != NULL) {
+        completion->complete(response, latency);
+      }
+    }
+};
+
+DatagramTransport::DatagramTransport(MasterEndpoints &endpoints) {
+  implementation = new Implementation(endpoints);
+}
+
+DatagramTransport::~DatagramTransport() {
+  if(implementation->open) {
+    implementation->socket.stop();
+  }
+
+  delete implementation;
+}
+
+void DatagramTransport::update() {
+  // There is no point trying to reach the Master node until the device is on the network.
+  if(WiFi.status() != WL_CONNECTED) {
+    if(implementation->open || implementation->resolved) {
+      implementation->close();
+    }
+
+    return;
+  }
+
+  if(!implementation->open) {
+    implementation->begin();
+
+    return;
+  }
+
+  implementation->retarget();
+
+  if(!implementation->resolved) {
+    return;
+  }
+
+  implementation->receive();
+  implementation->retransmit();
+}
+
+bool DatagramTransport::ready() const {
+  return (implementation->open && implementation->resolved && implementation->pendingCount < DATAGRAMS_IN_FLIGHT);
+}
+
+int DatagramTransport::send(const DCPRequest &request, DCPCompletion *completion) {
+  if(!implementation->open || !implementation->resolved) {
+    return -1;
+  }
+
+  if(implementation->pendingCount >= DATAGRAMS_IN_FLIGHT) {
+    return -2;
+  }
+
+  if(request.getBody().length() > DATAGRAM_MAX_PAYLOAD) {
+    return -3;
+  }
+
+  DCPRequest *copy = new DCPRequest(request);
+
+  if(!copy->write(implementation->socket, implementation->address, implementation->port)) {
+    delete copy;
+
+    return -4;
+  }
+
+  if(completion != NULL) {
+    completion->reset();
+  }
+
+  Implementation::PendingDatagram &entry = implementation->pending[implementation->pendingCount++];
+
+  entry.request = copy;
+  entry.completion = completion;
+  entry.firstSent = millis();
+  entry.lastSent = entry.firstSent;
+  entry.timeout = DATAGRAM_RETRANSMIT_TIMEOUT;
+  entry.retries = 0;
+
+  implementation->stats.sent++;
+
+  return 0;
+}
+
+int DatagramTransport::getOutstanding() const {
+  return implementation->pendingCount;
+}
+
+const DatagramStats &DatagramTransport::getStats() const {
+  return implementation->stats;
+}
@@ -0,0 +1,138 @@
+/*
+ * DatagramTransport.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_DATAGRAMTRANSPORT
+  #define _C1MOORE_INFRASTRUCTURE_DATAGRAMTRANSPORT
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+  #include <ESP8266WiFi.h>
+  #include <WiFiUdp.h>
+
+  #include "DCP/DCPCompletion.h"
+  #include "DCP/DCPRequest.h"
+  #include "MasterEndpoints.h"
+
+  // The default port the Master node receives DCP datagrams on.  Responses are received on this port.
+  #ifndef DATAGRAM_PORT
+    #define DATAGRAM_PORT 4210
+  #endif
+
+  // The largest body, in bytes, sent in a datagram.  Anything larger is sent on the persistent connection instead.
+  #ifndef DATAGRAM_MAX_PAYLOAD
+    #define DATAGRAM_MAX_PAYLOAD 256
+  #endif
+
+  // The maximum number of datagrams that can be waiting for a response at once.
+  #ifndef DATAGRAMS_IN_FLIGHT
+    #define DATAGRAMS_IN_FLIGHT 4
+  #endif
+
+  // The time, in milliseconds, to wait for the response before sending a datagram again.  The wait doubles with each attempt.
+  #ifndef DATAGRAM_RETRANSMIT_TIMEOUT
+    #define DATAGRAM_RETRANSMIT_TIMEOUT 150
+  #endif
+
+  // The number of times a datagram is sent again before the request is given up on.
+  #ifndef DATAGRAM_RETRIES
+    #define DATAGRAM_RETRIES 3
+  #endif
+
+  // The number of answered requests remembered so a second response to a retransmitted datagram is recognized as a duplicate.
+  #ifndef DATAGRAM_HISTORY
+    #define DATAGRAM_HISTORY 8
+  #endif
+
+  /**
+   * DatagramStats describes how reliably requests are delivered over the DatagramTransport.
+   */
+  struct DatagramStats {
+    unsigned long sent;           // The number of requests sent.
+    unsigned long retransmits;    // The number of datagrams sent again because the response did not arrive in time.
+    unsigned long answered;       // The number of requests answered by the Master node.
+    unsigned long expired;        // The number of requests given up on after DATAGRAM_RETRIES retransmissions.
+    unsigned long duplicates;     // The number of responses dropped because the request had already been answered.
+    unsigned long invalid;        // The number of datagrams dropped because they could not be parsed or were not expected.
+    unsigned long lastLatency;    // The time, in milliseconds, between sending the most recently answered request and its response.
+  };
+
+  /**
+   * DatagramTransport sends DCP requests to the Master node as UDP datagrams, one request per datagram.  Datagrams avoid the
+   * connection setup of TCP and are not held up behind a large request still being sent on the persistent connection, which
+   * makes them suited to small, latency-critical updates such as motion events.
+   *
+   * UDP does not guarantee delivery, so the response serves as the acknowledgement.  A request whose response has not arrived
+   * within DATAGRAM_RETRANSMIT_TIMEOUT milliseconds is sent again with the same SESSION_TIMESTAMP, doubling the wait each time,
+   * until DATAGRAM_RETRIES retransmissions have gone unanswered.  Duplicates are suppressed on both ends:
+   *  - the Master node recognizes a retransmitted request by its SESSION_ID:SESSION_TIMESTAMP and answers it without
+   *    processing it again (see DCPRequest)
+   *  - this device drops a second response to a request that has already been answered
+   *
+   * The Master node only pushes messages on the persistent connection (see MasterConnection).
+   *
+   * `update()` reads the responses, retransmits and expires requests, and should be called regularly by the owner, such as from
+   * `Coordinator::run()`.  Datagrams go to the endpoint the persistent connection is using, so both fail over together, and its
+   * address comes from the cache in MasterEndpoints rather than a lookup before each request.  Requests answered on the first
+   * attempt contribute to the round trip time of the endpoint.
+   */
+  class DatagramTransport {
+    public:
+      /**
+       * Creates a new DatagramTransport.  Nothing is sent until the device is on the network and `update()` is called.
+       *
+       * @param endpoints (MasterEndpoints &) - the Master nodes to send requests to
+       */
+      DatagramTransport(MasterEndpoints &endpoints);
+      ~DatagramTransport();
+
+      /**
+       * Opens the socket once the device is on the network, reads the responses that have arrived and completes their requests,
+       * retransmits requests whose responses are overdue, and completes requests that ran out of retransmissions with
+       * RESPONSE_TIMEOUT.
+       */
+      void update();
+
+      /**
+       * Checks whether requests can be sent.
+       *
+       * @return (bool) true iff the socket is open and fewer than DATAGRAMS_IN_FLIGHT requests are waiting for a response
+       */
+      bool ready() const;
+
+      /**
+       * Sends the request in a datagram.  The response is delivered through `completion` once it arrives.  If the request cannot
+       * be sent, `completion` is not completed so the caller can send the request another way.
+       *
+       * @param request (const DCPRequest &) - the request to send, which must not have been sent before
+       * @param completion (DCPCompletion *) - the handle to complete once the response arrives or NULL
+       *
+       * @return (int) 0 if the request was sent; -1 if the socket is not open; -2 if DATAGRAMS_IN_FLIGHT requests are already
+       *  waiting for a response; -3 if the body exceeds DATAGRAM_MAX_PAYLOAD; -4 if the datagram could not be sent
+       */
+      int send(const DCPRequest &request, DCPCompletion *completion);
+
+      /**
+       * Returns the number of requests waiting for a response.
+       *
+       * @return (int) the number of requests waiting for a response
+       */
+      int getOutstanding() const;
+
+      /**
+       * Returns the delivery statistics.
+       *
+       * @return (const DatagramStats &) the delivery statistics
+       */
+      const DatagramStats &getStats() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_DATAGRAMTRANSPORT */
@@ -0,0 +1,185 @@
+/*
+ * InputFilter.cpp
+ *
+ *      Author: c1moore
+ */
+#include "InputFilter.h"
+
+InputFilter::InputFilter() {
+  config = { 0, 0, 0, 0, 0 };
+
+  reset();
+}
+
+InputFilter::InputFilter(const FilterConfig &config) {
+  configure(config);
+  reset();
+}
+
+void InputFilter::configure(const FilterConfig &config) {
+  this->config = config;
+
+  if(this->config.majority > FILTER_MAX_MAJORITY) {
+    this->config.majority = FILTER_MAX_MAJORITY;
+  }
+}
+
+const FilterConfig &InputFilter::getConfig() const {
+  return config;
+}
+
+FilterResult InputFilter::input(uint32_t timestamp, bool level) {
+  // Debounce.  Only the latest level seen during the window matters; it is evaluated once the window expires.
+  if(hasEdge && config.debounce && (timestamp - lastEdge) < config.debounce) {
+    if(deferred) {
+      suppressedCount++;
+    }
+
+    deferred = true;
+    deferredLevel = level;
+
+    return FILTER_NONE;
+  }
+
+  // This edge is newer than any level held back by the debounce stage.
+  if(deferred) {
+    deferred = false;
+    suppressedCount++;
+  }
+
+  return accept(timestamp, level);
+}
+
+FilterResult InputFilter::update(uint32_t now) {
+  if(deferred && (now - lastEdge) >= config.debounce) {
+    deferred = false;
+
+    // The burst of edges ended on a level the other stages have not seen yet.
+    const FilterResult result = accept(lastEdge + config.debounce, deferredLevel);
+
+    if(result != FILTER_NONE) {
+      return result;
+    }
+  }
+
+  if(!pending) {
+    return FILTER_NONE;
+  }
+
+  return confirm(now);
+}
+
+bool InputFilter::getState() const {
+  return state;
+}
+
+uint32_t InputFilter::getSuppressedCount() const {
+  return suppressedCount;
+}
+
+/**
+ * Resets the state of the filter to OFF without any history.
+ */
+void InputFilter::reset() {
+  state = false;
+  pending = false;
+  pendingSince = 0;
+  lastEdge = 0;
+  lastActivation = 0;
+  history = 0;
+  hasEdge = false;
+  deferred = false;
+  deferredLevel = false;
+  suppressedCount = 0;
+}
+
+/**
+ * Feeds an edge or sample accepted by the debounce stage through the remaining stages.
+ *
+ * @param timestamp (uint32_t) - the time, in microseconds, of the edge or sample
+ * @param level (bool) - the level of the input after the edge or at the time of the sample
+ *
+ * @return (FilterResult) what, if anything, should be reported as a result of the edge or sample
+ */
+FilterResult InputFilter::accept(uint32_t timestamp, bool level) {
+  hasEdge = true;
+  lastEdge = timestamp;
+
+  // Majority-of-N
+  const bool sampledLevel = sample(level);
+
+  // Hysteresis
+  if(sampledLevel != state) {
+    if(!pending) {
+      pending = true;
+      pendingSince = timestamp;
+    }
+
+    FilterResult result = confirm(timestamp);
+
+    if(result == FILTER_NONE) {
+      suppressedCount++;
+    }
+
+    return result;
+  }
+
+  // The input returned to its filtered state before the transition was confirmed, so it was just noise.
+  pending = false;
+
+  // Retrigger suppression
+  if(state && level && (timestamp - lastActivation) >= config.retrigger) {
+    lastActivation = timestamp;
+
+    return FILTER_RETRIGGER;
+  }
+
+  suppressedCount++;
+
+  return FILTER_NONE;
+}
+
+/**
+ * Records level in the sample history and returns the majority level of the last `config.majority` samples.
+ *
+ * @param level (bool) - the most recent level of the input
+ *
+ * @return (bool) the majority level
+ */
+bool InputFilter::sample(bool level) {
+  history = (history << 1) | (level ? 1 : 0);
+
+  if(config.majority <= 1) {
+    return level;
+  }
+
+  const uint32_t window = history & ((1UL << config.majority) - 1);
+
+  return ((uint32_t) __builtin_popcount(window) * 2 > config.majority);
+}
+
+/**
+ * Confirms the pending transition if it has persisted for the minimum duration.
+ *
+ * @param now (uint32_t) - the current time, in microseconds
+ *
+ * @return (FilterResult) FILTER_ON or FILTER_OFF if the transition was confirmed; otherwise, FILTER_NONE
+ */
+FilterResult InputFilter::confirm(uint32_t now) {
+  const uint32_t minimum = state ? config.minOff : config.minOn;
+
+  if((now - pendingSince) < minimum) {
+    return FILTER_NONE;
+  }
+
+  pending = false;
+  state = !state;
+
+  if(state) {
+    lastActivation = now;
+
+    return FILTER_ON;
+  }
+
+  return FILTER_OFF;
+}
@@ -0,0 +1,126 @@
+/*
+ * InputFilter.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_INPUTFILTER
+  #define _C1MOORE_INFRASTRUCTURE_INPUTFILTER
+
+  #include <stdint.h>
+
+  // The largest number of samples that can be used for majority-of-N sampling.
+  #define FILTER_MAX_MAJORITY 31
+
+  /**
+   * FilterConfig configures how an InputFilter filters a digital input.  All durations are in microseconds and a value of 0
+   * disables the corresponding stage.
+   */
+  struct FilterConfig {
+    uint32_t debounce;  // Raw edges occurring within this long of the last accepted raw edge are held back until it has passed.
+    uint32_t minOn;     // The input must be ON for at least this long before the filter reports it as ON.
+    uint32_t minOff;    // The input must be OFF for at least this long before the filter reports it as OFF.
+    uint32_t retrigger; // While ON, the filter reports a retrigger at most once within this long.
+    uint8_t majority;   // The input's level is the majority of the last `majority` samples.  A value of 0 or 1 disables this stage.
+  };
+
+  /**
+   * FilterResult enumerates the results of feeding an InputFilter.
+   */
+  enum FilterResult {
+    FILTER_NONE,      // Nothing should be reported.  The input was filtered out or a transition is still being confirmed.
+    FILTER_ON,        // The filtered input transitioned from OFF to ON.
+    FILTER_OFF,       // The filtered input transitioned from ON to OFF.
+    FILTER_RETRIGGER  // The filtered input is still ON, but the input has been activated again (e.g. new motion was detected).
+  };
+
+  /**
+   * InputFilter removes noise from a digital input, such as a PIR sensor, before it is processed.  This reduces the number of
+   * redundant events a sensor has to handle and report to the Master node.  Each raw edge (or sample) passes through the
+   * following stages, each of which takes constant time:
+   *  1. Debounce - edges that occur too soon after the previous edge are held back.  Only the level of the latest one is kept,
+   *     and it is evaluated by `update()` once the debounce window expires, so the level a burst of edges settles on is never lost.
+   *  2. Majority-of-N - the input's level is the majority of the last N levels.
+   *  3. Hysteresis - a change in level is only reported once it has persisted for the minimum ON/OFF duration.
+   *  4. Retrigger suppression - while ON, repeated activations are only reported once per retrigger window.
+   *
+   * Since a transition may only be confirmed once enough time has passed, `update()` should be called periodically in addition to
+   * `input()` for each edge.
+   *
+   * Filters are independent of each other, so each input (e.g. each pin) should have its own InputFilter.  The configuration can
+   * be changed at any time.
+   */
+  class InputFilter {
+    public:
+      InputFilter();
+      InputFilter(const FilterConfig &config);
+
+      /**
+       * Replaces the configuration of this filter.  Any transition being confirmed will be confirmed using the new configuration.
+       *
+       * @param config (const FilterConfig &) - the new configuration
+       */
+      void configure(const FilterConfig &config);
+
+      /**
+       * Returns the current configuration of this filter.
+       *
+       * @return (const FilterConfig &) the current configuration
+       */
+      const FilterConfig &getConfig() const;
+
+      /**
+       * Feeds a raw edge or sample of the input through the filter.
+       *
+       * @param timestamp (uint32_t) - the time, in microseconds, of the edge or sample
+       * @param level (bool) - the level of the input after the edge or at the time of the sample
+       *
+       * @return (FilterResult) what, if anything, should be reported as a result of the edge or sample
+       */
+      FilterResult input(uint32_t timestamp, bool level);
+
+      /**
+       * Evaluates the level held back by the debounce stage once its window has expired and confirms a pending transition if it
+       * has persisted for long enough.
+       *
+       * @param now (uint32_t) - the current time, in microseconds
+       *
+       * @return (FilterResult) what, if anything, should be reported
+       */
+      FilterResult update(uint32_t now);
+
+      /**
+       * Returns the filtered state of the input.
+       *
+       * @return (bool) true iff the filtered input is ON
+       */
+      bool getState() const;
+
+      /**
+       * Returns the total number of edges or samples that were filtered out without being reported.
+       *
+       * @return (uint32_t) the total number of suppressed edges or samples
+       */
+      uint32_t getSuppressedCount() const;
+
+    private:
+      FilterConfig config;
+
+      bool state;                 // The filtered state of the input.
+      bool pending;               // true iff a transition to `!state` is being confirmed.
+      uint32_t pendingSince;      // The time the pending transition started.
+      uint32_t lastEdge;          // The time of the last raw edge accepted by the debounce stage.
+      uint32_t lastActivation;    // The time the input was last reported ON or retriggered.
+      uint32_t history;           // The last levels sampled, the most recent in the least significant bit.
+      bool hasEdge;               // true iff an edge has been accepted by the debounce stage.
+      bool deferred;              // true iff an edge was held back by the debounce stage and its level has not been evaluated.
+      bool deferredLevel;         // The level of the latest edge held back by the debounce stage.
+      uint32_t suppressedCount;   // The total number of edges or samples filtered out.
+
+      void reset();
+      FilterResult accept(uint32_t timestamp, bool level);
+      bool sample(bool level);
+      FilterResult confirm(uint32_t now);
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_INPUTFILTER */
@@ -0,0 +1,135 @@
+/*
+ * MasterClock.cpp
+ *
+ *      Author: c1moore
+ */
+#include "MasterClock.h"
+
+/**
+ * ClockSample is the result of one exchange with the Master node.
+ */
+struct ClockSample {
+  long offset;            // The Master time minus the local time, in milliseconds.
+  unsigned long rtt;      // The round trip time, in milliseconds, excluding the time the Master node took to respond.
+  unsigned long takenAt;  // The local time, in milliseconds, the response was received.
+};
+
+class MasterClock::Implementation {
+  public:
+    ClockSample samples[CLOCK_SAMPLES];
+    int sampleCount = 0;
+    int nextSample = 0;
+
+    ClockStats stats = { 0, 0 };
+
+    /**
+     * Calculates the most a sample can be wrong by now.
+     *
+     * @param sample (const ClockSample &) - the sample
+     *
+     * @return (unsigned long) the error bound, in milliseconds
+     */
+    static unsigned long error(const ClockSample &sample) {
+      const unsigned long age = millis() - sample.takenAt;
+
+      return sample.rtt / 2 + (age / 1000) * CLOCK_DRIFT_PPM / 1000;
+    }
+
+    /**
+     * Finds the sample with the smallest error bound.
+     *
+     * @return (const ClockSample *) the sample or NULL if there is none
+     */
+    const ClockSample *best() const {
+      const ClockSample *chosen = NULL;
+      unsigned long chosenError = 0;
+
+      for(int index = 0; index < sampleCount; index++) {
+        const unsigned long sampleError = error(samples[index]);
+
+        if(chosen == NULL || sampleError < chosenError) {
+          chosen = &samples[index];
+          chosenError = sampleError;
+        }
+      }
+
+      return chosen;
+    }
+};
+
+MasterClock::MasterClock() {
+  implementation = new Implementation();
+}
+
+MasterClock::~MasterClock() {
+  delete implementation;
+}
+
+bool MasterClock::sample(const unsigned long t1, const unsigned long t2, const unsigned long t3, const unsigned long t4) {
+  const long rtt = (long) (t4 - t1) - (long) (t3 - t2);
+
+  if(rtt < 0) {
+    reject();
+
+    return false;
+  }
+
+  ClockSample &sample = implementation->samples[implementation->nextSample];
+
+  // ((T2 - T1) + (T3 - T4)) / 2 is the same as (T2 - T1) - rtt / 2, but it does not overflow when the clocks are far apart.
+  sample.offset = (long) ((t2 - t1) - (unsigned long) rtt / 2);
+  sample.rtt = rtt;
+  sample.takenAt = t4;
+
+  implementation->nextSample = (implementation->nextSample + 1) % CLOCK_SAMPLES;
+
+  if(implementation->sampleCount < CLOCK_SAMPLES) {
+    implementation->sampleCount++;
+  }
+
+  implementation->stats.samples++;
+
+  return true;
+}
+
+void MasterClock::reject() {
+  implementation->stats.rejected++;
+}
+
+bool MasterClock::isSynchronized() const {
+  return (implementation->sampleCount > 0);
+}
+
+long MasterClock::getOffset() const {
+  const ClockSample *sample = implementation->best();
+
+  return (sample != NULL) ? sample->offset : 0;
+}
+
+unsigned long MasterClock::getRtt() const {
+  const ClockSample *sample = implementation->best();
+
+  return (sample != NULL) ? sample->rtt : 0;
+}
+
+unsigned long MasterClock::getError() const {
+  const ClockSample *sample = implementation->best();
+
+  return (sample != NULL) ? Implementation::error(*sample) : 0;
+}
+
+unsigned long MasterClock::toMasterTime(const unsigned long localTime) const {
+  return localTime + getOffset();
+}
+
+unsigned long MasterClock::toLocalTime(const unsigned long masterTime) const {
+  return masterTime - getOffset();
+}
+
+unsigned long MasterClock::now() const {
+  return toMasterTime(millis());
+}
+
+const ClockStats &MasterClock::getStats() const {
+  return implementation->stats;
+}
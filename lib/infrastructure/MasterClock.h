@@ -0,0 +1,134 @@
+/*
+ * MasterClock.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_MASTERCLOCK
+  #define _C1MOORE_INFRASTRUCTURE_MASTERCLOCK
+
+  #include <Arduino.h>
+
+  // The number of recent exchanges the offset is chosen from.
+  #ifndef CLOCK_SAMPLES
+    #define CLOCK_SAMPLES 8
+  #endif
+
+  // The most the clocks are assumed to drift apart, in parts per million.  This is the tolerance of the crystals of both
+  // devices; an old sample is trusted less than a new one by this much.
+  #ifndef CLOCK_DRIFT_PPM
+    #define CLOCK_DRIFT_PPM 100
+  #endif
+
+  /**
+   * ClockStats describes the exchanges used to synchronize with the Master node's clock.
+   */
+  struct ClockStats {
+    unsigned long samples;  // The number of exchanges used.
+    unsigned long rejected; // The number of exchanges that could not be used, such as ones with a malformed response.
+  };
+
+  /**
+   * MasterClock estimates the offset between this device's clock, `millis()`, and the Master node's clock, so times can be
+   * translated between the two.  Each sample is an exchange with the four timestamps NTP uses:
+   *    T1 - this device sent the request (local time)
+   *    T2 - the Master node received the request (Master time)
+   *    T3 - the Master node sent the response (Master time)
+   *    T4 - this device received the response (local time)
+   * The round trip time excludes the time the Master node spent on the request, (T4 - T1) - (T3 - T2), and the offset assumes
+   * the request and response took equally long, ((T2 - T1) + (T3 - T4)) / 2.  The offset is wrong by at most half the round
+   * trip time, so of the last CLOCK_SAMPLES samples, the one with the smallest error is used: half its round trip time plus
+   * what the clocks may have drifted since it was taken.  Samples delayed by a busy network or a request queued behind a large
+   * one are thus ignored as long as a faster one is recent enough.
+   *
+   * Times are in milliseconds and wrap around like `millis()`, so they must be compared by their difference.
+   */
+  class MasterClock {
+    public:
+      MasterClock();
+      ~MasterClock();
+
+      /**
+       * Adds a sample.  Samples with a negative round trip time are rejected.
+       *
+       * @param t1 (const unsigned long) - the local time the request was sent
+       * @param t2 (const unsigned long) - the Master time the request was received
+       * @param t3 (const unsigned long) - the Master time the response was sent
+       * @param t4 (const unsigned long) - the local time the response was received
+       *
+       * @return (bool) true iff the sample was used
+       */
+      bool sample(const unsigned long t1, const unsigned long t2, const unsigned long t3, const unsigned long t4);
+
+      /**
+       * Records an exchange that could not be used.
+       */
+      void reject();
+
+      /**
+       * Checks whether the offset is known.
+       *
+       * @return (bool) true iff at least one sample was used
+       */
+      bool isSynchronized() const;
+
+      /**
+       * Returns the estimated offset of the Master node's clock.
+       *
+       * @return (long) the Master time minus the local time, in milliseconds
+       */
+      long getOffset() const;
+
+      /**
+       * Returns the round trip time of the sample the offset was taken from.
+       *
+       * @return (unsigned long) the round trip time, in milliseconds
+       */
+      unsigned long getRtt() const;
+
+      /**
+       * Returns the most the estimated offset can be wrong by.
+       *
+       * @return (unsigned long) the error bound, in milliseconds
+       */
+      unsigned long getError() const;
+
+      /**
+       * Translates a local time to Master time.
+       *
+       * @param localTime (const unsigned long) - the local time, as returned by `millis()`
+       *
+       * @return (unsigned long) the Master time
+       */
+      unsigned long toMasterTime(const unsigned long localTime) const;
+
+      /**
+       * Translates a Master time to local time.
+       *
+       * @param masterTime (const unsigned long) - the Master time
+       *
+       * @return (unsigned long) the local time, comparable to `millis()`
+       */
+      unsigned long toLocalTime(const unsigned long masterTime) const;
+
+      /**
+       * Returns the current Master time.
+       *
+       * @return (unsigned long) the Master time now
+       */
+      unsigned long now() const;
+
+      /**
+       * Returns the synchronization statistics.
+       *
+       * @return (const ClockStats &) the synchronization statistics
+       */
+      const ClockStats &getStats() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_MASTERCLOCK */
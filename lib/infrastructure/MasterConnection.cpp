@@ -0,0 +1,281 @@
+/*
+ * MasterConnection.cpp
+ *
+ *      Author: c1moore
+ */
+#include "BootTimeline.h"
+#include "MasterConnection.h"
+
+class MasterConnection::Implementation {
+  public:
+    MasterEndpoints &endpoints;
+    int endpoint = -1;                  // The index of the endpoint of the current connection or attempt.
+
+    WiFiClient client;
+    ConnectionState state = CONNECTION_IDLE;
+    ConnectionStats stats = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    int failures = 0;                   // The number of consecutive failed connection attempts.
+    unsigned long backoffStart = 0;     // The time, in milliseconds, the current backoff started.
+    unsigned long backoffDelay = 0;     // The length, in milliseconds, of the current backoff.
+
+    unsigned long requestsOnConnection = 0; // The number of requests sent on the current connection.
+    unsigned long lastActivity = 0;     // The time, in milliseconds, data was last sent or received.
+    unsigned long lastReceived = 0;     // The time, in milliseconds, data was last received.
+    int outstanding = 0;                // The number of requests sent that have not been answered yet.
+    unsigned long lastFailback = 0;     // The time, in milliseconds, the connection last checked for a faster endpoint.
+
+    Implementation(MasterEndpoints &endpoints): endpoints(endpoints) {}
+
+    /**
+     * Makes one connection attempt to the preferred endpoint, bounded by CONNECTION_TIMEOUT.
+     */
+    void connect() {
+      const int previous = endpoint;
+
+      endpoint = endpoints.select();
+
+      if(endpoint < 0) {
+        return;
+      }
+
+      if(previous >= 0 && endpoint != previous) {
+        stats.failovers++;
+      }
+
+      stats.connectAttempts++;
+
+      client.setTimeout(CONNECTION_TIMEOUT);
+
+      const unsigned long start = millis();
+      IPAddress address;
+
+      if(!endpoints.resolve(endpoint, address) || !client.connect(address, endpoints.getPort(endpoint))) {
+        client.stop();
+        endpoints.failed(endpoint);
+
+        // Fail over to another endpoint right away; only back off once none is left to try.
+        const int next = endpoints.select();
+
+        if(next != endpoint && endpoints.isHealthy(next)) {
+          state = CONNECTION_IDLE;
+
+          return;
+        }
+
+        failures++;
+
+        backoff();
+
+        return;
+      }
+
+      const unsigned long now = millis();
+
+      // Requests are small and latency matters more than segment count.
+      client.setNoDelay(true);
+
+      stats.connects++;
+      stats.lastConnectLatency = now - start;
+      stats.totalConnectLatency += stats.lastConnectLatency;
+
+      // The handshake takes one round trip.
+      endpoints.succeeded(endpoint, stats.lastConnectLatency);
+      endpoints.use(endpoint);
+
+      failures = 0;
+      requestsOnConnection = 0;
+      lastActivity = now;
+      lastReceived = now;
+      lastFailback = now;
+      outstanding = 0;
+
+      state = CONNECTION_CONNECTED;
+
+      recordBootEvent(BOOT_MASTER_CONNECTED);
+    }
+
+    /**
+     * Enters the BACKOFF state.  The delay doubles with each consecutive failure, up to BACKOFF_MAX, and is jittered between
+     * half and all of that value so devices that lost the Master at the same time do not retry at the same time.
+     */
+    void backoff() {
+      unsigned long ceiling = BACKOFF_MAX;
+
+      if(failures < 16 && ((unsigned long) BACKOFF_BASE << failures) < BACKOFF_MAX) {
+        ceiling = (unsigned long) BACKOFF_BASE << failures;
+      }
+
+      backoffStart = millis();
+      backoffDelay = (ceiling / 2) + random(ceiling / 2 + 1);
+
+      state = CONNECTION_BACKOFF;
+    }
+
+    /**
+     * Closes the current connection and backs off.
+     *
+     * @param blame (const bool) - whether the Master node is at fault, which counts against its endpoint
+     */
+    void close(const bool blame) {
+      client.stop();
+      stats.drops++;
+
+      if(blame) {
+        endpoints.failed(endpoint);
+      }
+
+      // A lost connection is retried quickly; only repeated failures to reconnect lengthen the delay.
+      failures = 0;
+
+      backoff();
+    }
+
+    /**
+     * Checks whether the open connection is still usable.
+     *
+     * @return (bool) true iff the connection is open and the Master node is not overdue with a response
+     */
+    bool healthy() {
+      if(!client.connected()) {
+        return false;
+      }
+
+      if(client.available() > 0) {
+        return true;
+      }
+
+      return outstanding == 0 || (millis() - lastReceived < HEALTH_TIMEOUT);
+    }
+};
+
+MasterConnection::MasterConnection(MasterEndpoints &endpoints) {
+  implementation = new Implementation(endpoints);
+}
+
+MasterConnection::~MasterConnection() {
+  implementation->client.stop();
+
+  delete implementation;
+}
+
+void MasterConnection::update() {
+  // There is no point trying to reach the Master node until the device is on the network.
+  if(WiFi.status() != WL_CONNECTED) {
+    if(implementation->state == CONNECTION_CONNECTED) {
+      implementation->close(false);
+    }
+
+    return;
+  }
+
+  switch(implementation->state) {
+    case CONNECTION_IDLE:
+      implementation->connect();
+      break;
+
+    case CONNECTION_CONNECTED:
+      if(!implementation->healthy()) {
+        implementation->close(true);
+      } else if(implementation->outstanding == 0 && millis() - implementation->lastFailback >= ENDPOINT_FAILBACK_INTERVAL) {
+        implementation->lastFailback = millis();
+
+        // Move to a faster endpoint while nothing is waiting on this one.
+        if(implementation->endpoints.select(implementation->endpoint) != implementation->endpoint) {
+          implementation->client.stop();
+          implementation->state = CONNECTION_IDLE;
+        }
+      }
+      break;
+
+    case CONNECTION_BACKOFF:
+      if(millis() - implementation->backoffStart >= implementation->backoffDelay) {
+        implementation->connect();
+      }
+      break;
+  }
+}
+
+WiFiClient *MasterConnection::getClient() {
+  if(implementation->state != CONNECTION_CONNECTED) {
+    return NULL;
+  }
+
+  if(!implementation->client.connected()) {
+    implementation->close(true);
+
+    return NULL;
+  }
+
+  return &implementation->client;
+}
+
+WiFiClient *MasterConnection::acquire() {
+  if(getClient() == NULL) {
+    return NULL;
+  }
+
+  if(implementation->requestsOnConnection++ > 0) {
+    implementation->stats.reusedRequests++;
+  }
+
+  implementation->stats.requests++;
+
+  if(implementation->outstanding == 0) {
+    // The health check measures silence from the first unanswered request, not from the last response.
+    implementation->lastReceived = millis();
+  }
+
+  implementation->lastActivity = millis();
+  implementation->outstanding++;
+
+  return &implementation->client;
+}
+
+void MasterConnection::received(const unsigned long rtt) {
+  implementation->endpoints.succeeded(implementation->endpoint, rtt);
+
+  implementation->lastReceived = millis();
+  implementation->lastActivity = implementation->lastReceived;
+
+  if(implementation->outstanding > 0) {
+    implementation->outstanding--;
+  }
+}
+
+void MasterConnection::heard() {
+  implementation->lastActivity = millis();
+}
+
+void MasterConnection::drop() {
+  if(implementation->state != CONNECTION_CONNECTED) {
+    return;
+  }
+
+  implementation->close(true);
+}
+
+bool MasterConnection::keepAliveDue() const {
+  return (implementation->state == CONNECTION_CONNECTED && implementation->outstanding == 0 &&
+      millis() - implementation->lastActivity >= KEEPALIVE_INTERVAL);
+}
+
+int MasterConnection::getOutstanding() const {
+  return implementation->outstanding;
+}
+
+ConnectionState MasterConnection::getState() const {
+  return implementation->state;
+}
+
+const ConnectionStats &MasterConnection::getStats() const {
+  return implementation->stats;
+}
+
+float MasterConnection::getReuseRatio() const {
+  if(implementation->stats.requests == 0) {
+    return 0;
+  }
+
+  return (float) implementation->stats.reusedRequests / implementation->stats.requests;
+}
@@ -0,0 +1,191 @@
+/*
+ * MasterConnection.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_MASTERCONNECTION
+  #define _C1MOORE_INFRASTRUCTURE_MASTERCONNECTION
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+  #include <ESP8266WiFi.h>
+
+  #include "MasterEndpoints.h"
+
+  // The maximum time, in milliseconds, a single connection attempt may take.
+  #ifndef CONNECTION_TIMEOUT
+    #define CONNECTION_TIMEOUT 1000
+  #endif
+
+  // The delay, in milliseconds, before retrying after the first failed connection attempt.  Each consecutive failure doubles
+  // the delay up to BACKOFF_MAX.
+  #ifndef BACKOFF_BASE
+    #define BACKOFF_BASE 250
+  #endif
+
+  // The longest delay, in milliseconds, between connection attempts.
+  #ifndef BACKOFF_MAX
+    #define BACKOFF_MAX 60000
+  #endif
+
+  // How long, in milliseconds, the connection may be idle before a keep-alive should be sent.
+  #ifndef KEEPALIVE_INTERVAL
+    #define KEEPALIVE_INTERVAL 30000
+  #endif
+
+  // How long, in milliseconds, the Master may stay silent while a response is outstanding before the connection is considered
+  // half-open and dropped.
+  #ifndef HEALTH_TIMEOUT
+    #define HEALTH_TIMEOUT 5000
+  #endif
+
+  // How often, in milliseconds, an idle connection checks whether a faster Master endpoint has become available.
+  #ifndef ENDPOINT_FAILBACK_INTERVAL
+    #define ENDPOINT_FAILBACK_INTERVAL 60000
+  #endif
+
+  /**
+   * ConnectionState enumerates the states of a MasterConnection.
+   */
+  enum ConnectionState {
+    CONNECTION_IDLE,        // No connection is open and no attempt is pending.  The next update will make an attempt.
+    CONNECTION_CONNECTED,   // The connection is open and can be used to send requests.
+    CONNECTION_BACKOFF      // The last attempt failed.  The next attempt will be made after the backoff delay.
+  };
+
+  /**
+   * ConnectionStats summarizes how well a MasterConnection is being reused.
+   */
+  struct ConnectionStats {
+    unsigned long connectAttempts;      // The number of connection attempts made.
+    unsigned long connects;             // The number of connection attempts that succeeded.
+    unsigned long drops;                // The number of connections closed because they were lost or unhealthy.
+    unsigned long requests;             // The number of requests sent.
+    unsigned long reusedRequests;       // The number of requests sent on a connection that had already carried a request.
+    unsigned long lastConnectLatency;   // The time, in milliseconds, the most recent successful connection took to open.
+    unsigned long totalConnectLatency;  // The sum of the time, in milliseconds, every successful connection took to open.
+    unsigned long failovers;            // The number of times the connection moved to another Master endpoint.
+  };
+
+  /**
+   * MasterConnection keeps one long-lived connection to the Master node so requests do not pay for a TCP handshake each.
+   * The connection is managed by a small state machine:
+   *
+   *    IDLE ----> CONNECTED
+   *     |             |
+   *     v             |
+   *  BACKOFF <--------+ (connection lost or unhealthy)
+   *
+   * `update()` advances the state machine and should be called regularly by the owner, such as from `Coordinator::run()`.
+   * Requests never connect themselves; `acquire()` only hands out the client if the connection is already open, so a Master
+   * that is down cannot stall the callers.  Failed attempts are retried with jittered exponential backoff so a fleet of devices
+   * does not reconnect in lockstep when the Master comes back.
+   *
+   * Half-open connections, where the Master has gone away without closing the socket, are detected by the response deadline:
+   * if any request is outstanding and no response has been received for HEALTH_TIMEOUT milliseconds, the connection is dropped.  Idle
+   * connections should be probed with a keep-alive request when `keepAliveDue()` returns true.
+   *
+   * The Master node is picked from MasterEndpoints.  A failed attempt fails over to the next healthy endpoint immediately; the
+   * connection only backs off once every endpoint has failed.  Every ENDPOINT_FAILBACK_INTERVAL milliseconds, an idle connection
+   * moves to a faster endpoint if one has become healthy again.  Addresses come from the endpoints' DNS cache, so reconnecting
+   * costs a connect but not a lookup.
+   *
+   * The ESP8266 core does not expose an asynchronous connect: `WiFiClient::connect()` and the DNS lookup both wait inside the
+   * call.  An attempt therefore starts and finishes within a single `update()`, bounded by CONNECTION_TIMEOUT, and there is no
+   * state in which an attempt is still in progress.
+   */
+  class MasterConnection {
+    public:
+      /**
+       * Creates a new MasterConnection.  No connection is made until `update()` is called.
+       *
+       * @param endpoints (MasterEndpoints &) - the Master nodes to connect to
+       */
+      MasterConnection(MasterEndpoints &endpoints);
+      ~MasterConnection();
+
+      /**
+       * Advances the connection state machine.  This may make a connection attempt, bounded by CONNECTION_TIMEOUT, and drops
+       * the connection if it has been lost or appears half-open.  Nothing is attempted while the device is not on the network.
+       */
+      void update();
+
+      /**
+       * Returns the client if the connection is open so responses can be read from it.
+       *
+       * @return (WiFiClient *) the connected client or NULL if the connection is not open
+       */
+      WiFiClient *getClient();
+
+      /**
+       * Returns the client if the connection is open and records that a request is about to be sent on it.
+       *
+       * @return (WiFiClient *) the connected client or NULL if the connection is not open
+       */
+      WiFiClient *acquire();
+
+      /**
+       * Records that a response has been received from the Master node, satisfying the health check.
+       *
+       * @param rtt (const unsigned long) - the time, in milliseconds, between sending the request and receiving the response.
+       *  It is used to measure the Master endpoint.
+       */
+      void received(const unsigned long rtt);
+
+      /**
+       * Records that the Master node sent a message it was not asked for, which shows the connection is alive but does not
+       * answer an outstanding request.
+       */
+      void heard();
+
+      /**
+       * Closes the connection and backs off before reconnecting.  This should be called when the Master node sent something
+       * that could not be understood or did not respond in time, since the connection can no longer be trusted.
+       */
+      void drop();
+
+      /**
+       * Checks whether the connection has been idle long enough that it should be probed with a keep-alive request.
+       *
+       * @return (bool) true iff the connection is open and has been idle for KEEPALIVE_INTERVAL milliseconds
+       */
+      bool keepAliveDue() const;
+
+      /**
+       * Returns the number of requests sent on this connection that have not been answered.
+       *
+       * @return (int) the number of outstanding requests
+       */
+      int getOutstanding() const;
+
+      /**
+       * Returns the current state of the connection.
+       *
+       * @return (ConnectionState) the current state of the connection
+       */
+      ConnectionState getState() const;
+
+      /**
+       * Returns the connection statistics.
+       *
+       * @return (const ConnectionStats &) the connection statistics
+       */
+      const ConnectionStats &getStats() const;
+
+      /**
+       * Returns the fraction of requests that were sent on a connection that had already been used.  Values close to 1 mean
+       * the connection is rarely reestablished.
+       *
+       * @return (float) the reuse ratio, between 0 and 1
+       */
+      float getReuseRatio() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_MASTERCONNECTION */
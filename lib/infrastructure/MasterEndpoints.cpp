@@ -0,0 +1,211 @@
+/*
+ * MasterEndpoints.cpp
+ *
+ *      Author: c1moore
+ */
+#include "MasterEndpoints.h"
+
+/**
+ * Endpoint is a configured Master node and what has been learned about it.
+ */
+struct Endpoint {
+  const char *host;
+  uint16_t port;
+  uint16_t datagramPort;
+
+  IPAddress address;
+  bool literal;               // Whether the host is an IP address, which never has to be looked up.
+  bool resolved;              // Whether `address` holds the result of a lookup.
+  unsigned long resolvedAt;   // The time, in milliseconds, the host was last looked up.
+
+  int consecutiveFailures;
+  unsigned long failedAt;     // The time, in milliseconds, of the last failure.
+
+  EndpointStats stats;
+};
+
+class MasterEndpoints::Implementation {
+  public:
+    Endpoint endpoints[MAX_MASTER_ENDPOINTS];
+    int endpointCount = 0;
+    int current = -1;
+
+    /**
+     * Checks whether `candidate` should be preferred over `best`.
+     *
+     * @param candidate (const Endpoint &) - the endpoint being considered
+     * @param best (const Endpoint &) - the best endpoint so far
+     *
+     * @return (bool) true iff `candidate` is faster than `best`, treating unmeasured endpoints as the slowest
+     */
+    static bool faster(const Endpoint &candidate, const Endpoint &best) {
+      if(candidate.stats.smoothedRtt == 0) {
+        return false;
+      }
+
+      return (best.stats.smoothedRtt == 0 || candidate.stats.smoothedRtt < best.stats.smoothedRtt);
+    }
+};
+
+MasterEndpoints::MasterEndpoints() {
+  implementation = new Implementation();
+}
+
+MasterEndpoints::~MasterEndpoints() {
+  delete implementation;
+}
+
+int MasterEndpoints::add(const char *host, const uint16_t port, const uint16_t datagramPort) {
+  if(implementation->endpointCount >= MAX_MASTER_ENDPOINTS) {
+    return -1;
+  }
+
+  const int index = implementation->endpointCount++;
+  Endpoint &endpoint = implementation->endpoints[index];
+
+  endpoint.host = host;
+  endpoint.port = port;
+  endpoint.datagramPort = datagramPort;
+  endpoint.literal = endpoint.address.fromString(host);
+  endpoint.resolved = endpoint.literal;
+  endpoint.resolvedAt = 0;
+  endpoint.consecutiveFailures = 0;
+  endpoint.failedAt = 0;
+  endpoint.stats = { 0, 0, 100, 0, 0, 0 };
+
+  return index;
+}
+
+int MasterEndpoints::count() const {
+  return implementation->endpointCount;
+}
+
+int MasterEndpoints::select(const int current) const {
+  int best = -1;
+  int fallback = -1;
+
+  for(int index = 0; index < implementation->endpointCount; index++) {
+    const Endpoint &endpoint = implementation->endpoints[index];
+
+    if(!isHealthy(index)) {
+      // If every endpoint is unhealthy, the one that failed the longest time ago is the most likely to have recovered.
+      if(fallback < 0 || (long) (endpoint.failedAt - implementation->endpoints[fallback].failedAt) < 0) {
+        fallback = index;
+      }
+
+      continue;
+    }
+
+    if(best < 0 || Implementation::faster(endpoint, implementation->endpoints[best])) {
+      best = index;
+    }
+  }
+
+  if(best < 0) {
+    return fallback;
+  }
+
+  if(current >= 0 && current != best && isHealthy(current)) {
+    const unsigned long currentRtt = implementation->endpoints[current].stats.smoothedRtt;
+    const unsigned long bestRtt = implementation->endpoints[best].stats.smoothedRtt;
+
+    if(bestRtt == 0 || bestRtt * 100 >= currentRtt * ENDPOINT_FAILBACK_MARGIN) {
+      return current;
+    }
+  }
+
+  return best;
+}
+
+void MasterEndpoints::use(const int index) {
+  implementation->current = index;
+}
+
+int MasterEndpoints::getCurrent() const {
+  return implementation->current;
+}
+
+bool MasterEndpoints::resolve(const int index, IPAddress &address) {
+  Endpoint &endpoint = implementation->endpoints[index];
+
+  if(endpoint.resolved && (endpoint.literal || millis() - endpoint.resolvedAt < DNS_CACHE_TTL)) {
+    address = endpoint.address;
+
+    return true;
+  }
+
+  endpoint.stats.lookups++;
+
+  if(!WiFi.hostByName(endpoint.host, endpoint.address)) {
+    endpoint.resolved = false;
+
+    return false;
+  }
+
+  endpoint.resolved = true;
+  endpoint.resolvedAt = millis();
+
+  address = endpoint.address;
+
+  return true;
+}
+
+void MasterEndpoints::succeeded(const int index, const unsigned long rtt) {
+  Endpoint &endpoint = implementation->endpoints[index];
+  EndpointStats &stats = endpoint.stats;
+
+  stats.successes++;
+  stats.health += (100 - stats.health + 3) / 4;
+  endpoint.consecutiveFailures = 0;
+
+  // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, then SRTT = 7/8 SRTT + 1/8 R.
+  if(stats.smoothedRtt == 0) {
+    stats.smoothedRtt = (rtt > 0) ? rtt : 1;
+    stats.rttVariance = rtt / 2;
+
+    return;
+  }
+
+  const unsigned long deviation = (rtt > stats.smoothedRtt) ? rtt - stats.smoothedRtt : stats.smoothedRtt - rtt;
+
+  stats.rttVariance = (3 * stats.rttVariance + deviation) / 4;
+  stats.smoothedRtt = (7 * stats.smoothedRtt + rtt) / 8;
+
+  if(stats.smoothedRtt == 0) {
+    stats.smoothedRtt = 1;
+  }
+}
+
+void MasterEndpoints::failed(const int index) {
+  Endpoint &endpoint = implementation->endpoints[index];
+
+  endpoint.stats.failures++;
+  endpoint.stats.health /= 2;
+  endpoint.failedAt = millis();
+
+  if(++endpoint.consecutiveFailures >= ENDPOINT_RESOLVE_FAILURES && !endpoint.literal) {
+    endpoint.resolved = false;
+  }
+}
+
+bool MasterEndpoints::isHealthy(const int index) const {
+  const Endpoint &endpoint = implementation->endpoints[index];
+
+  return (endpoint.stats.health >= ENDPOINT_HEALTHY || millis() - endpoint.failedAt >= ENDPOINT_PROBATION);
+}
+
+const char *MasterEndpoints::getHost(const int index) const {
+  return implementation->endpoints[index].host;
+}
+
+uint16_t MasterEndpoints::getPort(const int index) const {
+  return implementation->endpoints[index].port;
+}
+
+uint16_t MasterEndpoints::getDatagramPort(const int index) const {
+  return implementation->endpoints[index].datagramPort;
+}
+
+const EndpointStats &MasterEndpoints::getStats(const int index) const {
+  return implementation->endpoints[index].stats;
+}
@@ -0,0 +1,172 @@
+/*
+ * MasterEndpoints.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_MASTERENDPOINTS
+  #define _C1MOORE_INFRASTRUCTURE_MASTERENDPOINTS
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+  #include <ESP8266WiFi.h>
+
+  // The maximum number of Master nodes that can be configured.
+  #ifndef MAX_MASTER_ENDPOINTS
+    #define MAX_MASTER_ENDPOINTS 4
+  #endif
+
+  // How long, in milliseconds, a resolved address is used before the hostname is looked up again.
+  #ifndef DNS_CACHE_TTL
+    #define DNS_CACHE_TTL 600000
+  #endif
+
+  // The number of consecutive failures after which the cached address of an endpoint is discarded, in case it moved.
+  #ifndef ENDPOINT_RESOLVE_FAILURES
+    #define ENDPOINT_RESOLVE_FAILURES 3
+  #endif
+
+  // The health score, out of 100, below which an endpoint is not used while a healthier one is available.
+  #ifndef ENDPOINT_HEALTHY
+    #define ENDPOINT_HEALTHY 50
+  #endif
+
+  // How long, in milliseconds, an unhealthy endpoint is avoided before it is given another chance.
+  #ifndef ENDPOINT_PROBATION
+    #define ENDPOINT_PROBATION 60000
+  #endif
+
+  // The percentage of the current endpoint's smoothed RTT another endpoint must beat before it is worth switching to.  This
+  // keeps the device from bouncing between endpoints that are about as fast.
+  #ifndef ENDPOINT_FAILBACK_MARGIN
+    #define ENDPOINT_FAILBACK_MARGIN 75
+  #endif
+
+  /**
+   * EndpointStats describes what is known about a Master endpoint.
+   */
+  struct EndpointStats {
+    unsigned long smoothedRtt;  // The smoothed round trip time, in milliseconds, or 0 if it has not been measured.
+    unsigned long rttVariance;  // The smoothed deviation, in milliseconds, of the round trip time.
+    int health;                 // The health score, from 0 (failing) to 100 (reliable).
+    unsigned long successes;    // The number of successful exchanges with the endpoint.
+    unsigned long failures;     // The number of failed exchanges with the endpoint.
+    unsigned long lookups;      // The number of times the hostname was looked up.
+  };
+
+  /**
+   * MasterEndpoints is the list of Master nodes this device can talk to, in order of preference, and what has been learned about
+   * each.  Every endpoint has
+   *  - a cached address, so reconnecting after the Master restarts only costs a connect and not a DNS lookup as well.  The ESP8266
+   *    core does not report the TTL of a DNS record, so addresses are kept for DNS_CACHE_TTL milliseconds, or until the endpoint
+   *    fails ENDPOINT_RESOLVE_FAILURES times in a row.  Hosts given as IP addresses are never looked up.
+   *  - a smoothed round trip time, updated with each sample the same way TCP smooths its RTT (RFC 6298).
+   *  - a health score that rises with each success and halves with each failure.
+   *
+   * `select()` picks the healthy endpoint with the lowest smoothed RTT, so the owner fails over when the current endpoint becomes
+   * unhealthy and fails back once a faster one has recovered.  The owner reports the endpoint it is using with `use()`.  An
+   * unhealthy endpoint is put on probation for ENDPOINT_PROBATION milliseconds, after which it is considered healthy again until
+   * it proves otherwise.  Endpoints that have not been measured yet rank behind measured ones, in the order they were added.
+   */
+  class MasterEndpoints {
+    public:
+      MasterEndpoints();
+      ~MasterEndpoints();
+
+      /**
+       * Adds a Master node.  Endpoints added first are preferred until their round trip times are known.
+       *
+       * @param host (const char *) - the hostname or IP address of the Master node, which must outlive the MasterEndpoints
+       * @param port (const uint16_t) - the port of the Master node's persistent connections
+       * @param datagramPort (const uint16_t) - the port the Master node receives datagrams on
+       *
+       * @return (int) the index of the endpoint or -1 if MAX_MASTER_ENDPOINTS endpoints are already configured
+       */
+      int add(const char *host, const uint16_t port, const uint16_t datagramPort);
+
+      /**
+       * Returns the number of endpoints.
+       *
+       * @return (int) the number of endpoints
+       */
+      int count() const;
+
+      /**
+       * Picks the endpoint that should be used.  The current endpoint is kept while it is healthy unless another healthy endpoint
+       * is faster by ENDPOINT_FAILBACK_MARGIN.  If every endpoint is unhealthy, the one that failed longest ago is picked.
+       *
+       * @param current (const int) _optional_ - the index of the endpoint in use.  Default: -1, none is in use
+       *
+       * @return (int) the index of the endpoint or -1 if no endpoint is configured
+       */
+      int select(const int current = -1) const;
+
+      /**
+       * Records which endpoint is in use, so every transport talks to the same Master node.
+       *
+       * @param index (const int) - the index of the endpoint
+       */
+      void use(const int index);
+
+      /**
+       * Returns the endpoint in use.
+       *
+       * @return (int) the index of the endpoint or -1 if none is in use yet
+       */
+      int getCurrent() const;
+
+      /**
+       * Returns the address of an endpoint, looking it up if it is not cached.  A lookup blocks until the DNS server answers.
+       *
+       * @param index (const int) - the index of the endpoint
+       * @param address (IPAddress &) - set to the address of the endpoint
+       *
+       * @return (bool) true iff the address is known
+       */
+      bool resolve(const int index, IPAddress &address);
+
+      /**
+       * Records a successful exchange with an endpoint.
+       *
+       * @param index (const int) - the index of the endpoint
+       * @param rtt (const unsigned long) - the round trip time, in milliseconds, of the exchange
+       */
+      void succeeded(const int index, const unsigned long rtt);
+
+      /**
+       * Records a failed exchange with an endpoint, such as a failed connection attempt or a connection that went silent.
+       *
+       * @param index (const int) - the index of the endpoint
+       */
+      void failed(const int index);
+
+      /**
+       * Checks whether an endpoint is healthy.
+       *
+       * @param index (const int) - the index of the endpoint
+       *
+       * @return (bool) true iff the endpoint is healthy or its probation is over
+       */
+      bool isHealthy(const int index) const;
+
+      const char *getHost(const int index) const;
+      uint16_t getPort(const int index) const;
+      uint16_t getDatagramPort(const int index) const;
+
+      /**
+       * Returns what is known about an endpoint.
+       *
+       * @param index (const int) - the index of the endpoint
+       *
+       * @return (const EndpointStats &) the statistics of the endpoint
+       */
+      const EndpointStats &getStats(const int index) const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_MASTERENDPOINTS */
@@ -0,0 +1,435 @@
+/*
+ * OutboundQueue.cpp
+ *
+ *      Author: c1moore
+ */
+#include "OutboundQueue.h"
+
+// The number of bytes a record adds to an encoded batch in addition to its data, at most.
+#define BATCH_RECORD_OVERHEAD 10
+
+/**
+ * QueuedUpdate is an update held in RAM.
+ */
+struct QueuedUpdate {
+  uint16_t subDeviceId;       // The unique ID of the sub device that sent the update.
+  String data;                // The data of the update.
+  DCPCompletion *completion;  // The handles to complete once the update is acknowledged.
+  unsigned long queuedAt;     // The time, in milliseconds, the update was queued.
+  unsigned long batch;        // The SESSION_TIMESTAMP of the request carrying the update, OUTBOUND_PENDING, or 0 if it is waiting.
+  bool acked;                 // true iff the Master node acknowledged the update.
+};
+
+class OutboundQueue::Implementation {
+  public:
+    QueuedUpdate records[OUTBOUND_RAM_RECORDS];
+    int head = 0;
+    int size = 0;
+
+    SpillRing spill;
+    OverflowPolicy policy;
+    QueueStats stats = { 0, 0, 0, 0, 0, 0, 0 };
+
+    unsigned long lastSync = 0;
+    DCPCompletion *failed = NULL; // Handles to complete with RESPONSE_TIMEOUT once the queue is consistent again.
+
+    Implementation(const int spillAddr, const int spillSize, const OverflowPolicy policy): spill(spillAddr, spillSize), policy(policy) {}
+
+    /**
+     * Returns the update at the specified position in RAM.
+     *
+     * @param index (const int) - the position of the update, 0 being the oldest
+     *
+     * @return (QueuedUpdate &) the update
+     */
+    QueuedUpdate &at(const int index) {
+      return records[(head + index) % OUTBOUND_RAM_RECORDS];
+    }
+
+    /**
+     * Checks whether an update is waiting to be sent.
+     *
+     * @param record (const QueuedUpdate &) - the update
+     *
+     * @return (bool) true iff the update is neither in flight nor acknowledged
+     */
+    static bool waiting(const QueuedUpdate &record) {
+      return record.batch == 0 && !record.acked;
+    }
+
+    /**
+     * Adds an update to the end of the updates in RAM.
+     *
+     * @return (bool) true iff there was room for the update
+     */
+    bool append(uint16_t subDeviceId, const String &data, DCPCompletion *completion, const unsigned long queuedAt) {
+      if(size >= OUTBOUND_RAM_RECORDS) {
+        return false;
+      }
+
+      QueuedUpdate &record = at(size++);
+
+      record.subDeviceId = subDeviceId;
+      record.data = data;
+      record.completion = completion;
+      record.queuedAt = queuedAt;
+      record.batch = 0;
+      record.acked = false;
+
+      return true;
+    }
+
+    /**
+     * Removes the update at the specified position in RAM, keeping the order of the others.
+     *
+     * @param index (const int) - the position of the update
+     */
+    void remove(const int index) {
+      for(int next = index + 1; next < size; next++) {
+        QueuedUpdate &previous = at(next - 1);
+        QueuedUpdate &current = at(next);
+
+        previous.subDeviceId = current.subDeviceId;
+        previous.data = current.data;
+        previous.completion = current.completion;
+        previous.queuedAt = current.queuedAt;
+        previous.batch = current.batch;
+        previous.acked = current.acked;
+      }
+
+      at(--size).data = String();
+    }
+
+    /**
+     * Removes acknowledged updates from the front of the queue.  Acknowledged updates behind one still in flight stay until it
+     * is settled.
+     */
+    void popAcknowledged() {
+      while(size > 0 && at(0).acked) {
+        at(0).data = String();
+
+        head = (head + 1) % OUTBOUND_RAM_RECORDS;
+        size--;
+      }
+    }
+
+    /**
+     * Finds the newest waiting update of a sub device in RAM.
+     *
+     * @param subDeviceId (uint16_t) - the unique ID of the sub device
+     *
+     * @return (int) the position of the update or -1 if the sub device has no waiting update in RAM
+     */
+    int findWaiting(uint16_t subDeviceId) {
+      for(int index = size - 1; index >= 0; index--) {
+        if(at(index).subDeviceId == subDeviceId && waiting(at(index))) {
+          return index;
+        }
+      }
+
+      return -1;
+    }
+
+    /**
+     * Drops the oldest update that is not in flight.  Spilled updates are newer than every update in RAM, but every update in
+     * RAM may be in flight, so the oldest spilled update is only dropped if none in RAM can be.  Dropping an update in RAM moves
+     * the oldest spilled update into its place, so the room is made where the next update is stored.
+     *
+     * @param fromSpill (const bool) - whether a spilled update may be dropped
+     *
+     * @return (bool) true iff an update was dropped
+     */
+    bool dropOldest(const bool fromSpill) {
+      for(int index = 0; index < size; index++) {
+        if(waiting(at(index))) {
+          fail(at(index).completion);
+          remove(index);
+          refill();
+
+          stats.dropped++;
+
+          return true;
+        }
+      }
+
+      if(fromSpill && spill.count() > 0) {
+        spill.pop();
+
+        stats.dropped++;
+
+        return true;
+      }
+
+      return false;
+    }
+
+    /**
+     * Stores an update, spilling it or applying the OverflowPolicy as needed.
+     *
+     * @return (int) 0 if the update was stored; -1 if it was dropped
+     */
+    int store(uint16_t subDeviceId, const String &data, DCPCompletion *completion) {
+      // An update too long to spill can only wait in RAM.  Once updates have been spilled, it cannot be queued without going
+      // ahead of them, and dropping spilled updates never makes room in RAM.
+      const bool spillable = (data.length() <= SPILL_MAX_DATA);
+
+      while(true) {
+        // Once updates have been spilled, new updates must follow them to keep the queue in order.
+        if(spill.count() == 0 && append(subDeviceId, data, completion, millis())) {
+          return 0;
+        }
+
+        if(spillable && spill.push(subDeviceId, data)) {
+          fail(completion);
+
+          stats.spilled++;
+
+          return 0;
+        }
+
+        if(policy == QUEUE_DROP_NEWEST || (!spillable && spill.count() > 0) || !dropOldest(spillable)) {
+          fail(completion);
+
+          stats.dropped++;
+
+          return -1;
+        }
+      }
+    }
+
+    /**
+     * Moves spilled updates back into RAM while there is room.  They have already waited, so they are sent with the next batch.
+     */
+    void refill() {
+      uint16_t subDeviceId;
+      String data;
+
+      while(size < OUTBOUND_RAM_RECORDS && spill.peek(subDeviceId, data)) {
+        append(subDeviceId, data, NULL, 0);
+        spill.pop();
+      }
+    }
+
+    /**
+     * Schedules a handle to be completed with RESPONSE_TIMEOUT.  Completing it immediately could run its callback while the
+     * queue is being modified.
+     *
+     * @param completion (DCPCompletion *) - the handle or NULL
+     */
+    void fail(DCPCompletion *completion) {
+      if(failed == NULL) {
+        failed = completion;
+      } else {
+        failed->link(completion);
+      }
+    }
+
+    /**
+     * Completes the handles scheduled by `fail()`.
+     */
+    void completeFailed() {
+      DCPCompletion *completion = failed;
+      failed = NULL;
+
+      if(completion != NULL) {
+        completion->complete(DCPResponse(RESPONSE_TIMEOUT), 0);
+      }
+    }
+};
+
+OutboundQueue::OutboundQueue(const int spillAddr, const int spillSize, const OverflowPolicy policy) {
+  implementation = new Implementation(spillAddr, spillSize, policy);
+}
+
+OutboundQueue::~OutboundQueue() {
+  delete implementation;
+}
+
+int OutboundQueue::begin() {
+  const int recovered = implementation->spill.begin();
+
+  implementation->refill();
+
+  return recovered;
+}
+
+int OutboundQueue::push(uint16_t subDeviceId, const String &data, DCPCompletion *completion) {
+  implementation->stats.queued++;
+
+  // While updates are spilled, an older update of the sub device may be among them.  Replacing the one in RAM would leave the
+  // spilled update to be replayed after the latest, so the new update is stored behind the spilled ones instead.
+  if(implementation->policy == QUEUE_COLLAPSE && implementation->spill.count() == 0) {
+    const int index = implementation->findWaiting(subDeviceId);
+
+    if(index >= 0) {
+      QueuedUpdate &record = implementation->at(index);
+
+      record.data = data;
+
+      if(record.completion == NULL) {
+        record.completion = completion;
+      } else {
+        record.completion->link(completion);
+      }
+
+      implementation->stats.collapsed++;
+
+      return 1;
+    }
+  }
+
+  const int status = implementation->store(subDeviceId, data, completion);
+  const int depth = count();
+
+  if(depth > implementation->stats.maxDepth) {
+    implementation->stats.maxDepth = depth;
+  }
+
+  implementation->completeFailed();
+
+  return status;
+}
+
+int OutboundQueue::take(UpdateBatch &batch, const unsigned int byteBudget) {
+  int taken = 0;
+
+  for(int index = 0; index < implementation->size; index++) {
+    QueuedUpdate &record = implementation->at(index);
+
+    if(!Implementation::waiting(record)) {
+      continue;
+    }
+
+    if(taken > 0 && batch.bytes() + record.data.length() + BATCH_RECORD_OVERHEAD > byteBudget) {
+      break;
+    }
+
+    if(batch.add(record.subDeviceId, record.data) < 0) {
+      break;
+    }
+
+    record.batch = OUTBOUND_PENDING;
+    taken++;
+  }
+
+  return taken;
+}
+
+void OutboundQueue::dispatched(const unsigned long timestamp) {
+  for(int index = 0; index < implementation->size; index++) {
+    QueuedUpdate &record = implementation->at(index);
+
+    if(record.batch == OUTBOUND_PENDING) {
+      record.batch = timestamp;
+    }
+  }
+}
+
+void OutboundQueue::acknowledge(const unsigned long timestamp, const DCPResponse &response, const unsigned long latency) {
+  DCPCompletion *completion = NULL;
+
+  for(int index = 0; index < implementation->size; index++) {
+    QueuedUpdate &record = implementation->at(index);
+
+    if(record.batch != timestamp || record.acked) {
+      continue;
+    }
+
+    record.acked = true;
+    implementation->stats.delivered++;
+
+    if(completion == NULL) {
+      completion = record.completion;
+    } else {
+      completion->link(record.completion);
+    }
+
+    record.completion = NULL;
+  }
+
+  implementation->popAcknowledged();
+
+  // Complete the handles last since their callbacks may queue new updates.
+  if(completion != NULL) {
+    completion->complete(response, latency);
+  }
+}
+
+void OutboundQueue::release(const unsigned long timestamp) {
+  for(int index = 0; index < implementation->size; index++) {
+    QueuedUpdate &record = implementation->at(index);
+
+    if(record.batch == timestamp && !record.acked) {
+      record.batch = 0;
+      implementation->stats.retried++;
+    }
+  }
+}
+
+void OutboundQueue::maintain() {
+  implementation->refill();
+
+  if(millis() - implementation->lastSync >= 2UL * SPILL_SYNC_INTERVAL) {
+    sync();
+  }
+}
+
+bool OutboundQueue::sync() {
+  if(millis() - implementation->lastSync < SPILL_SYNC_INTERVAL) {
+    return false;
+  }
+
+  implementation->lastSync = millis();
+
+  return implementation->spill.sync();
+}
+
+unsigned long OutboundQueue::age() const {
+  for(int index = 0; index < implementation->size; index++) {
+    const QueuedUpdate &record = implementation->at(index);
+
+    if(Implementation::waiting(record)) {
+      return millis() - record.queuedAt;
+    }
+  }
+
+  return 0;
+}
+
+unsigned int OutboundQueue::waitingBytes() const {
+  unsigned int bytes = 0;
+
+  for(int index = 0; index < implementation->size; index++) {
+    const QueuedUpdate &record = implementation->at(index);
+
+    if(Implementation::waiting(record)) {
+      bytes += record.data.length();
+    }
+  }
+
+  return bytes;
+}
+
+int OutboundQueue::waitingCount() const {
+  int waiting = 0;
+
+  for(int index = 0; index < implementation->size; index++) {
+    if(Implementation::waiting(implementation->at(index))) {
+      waiting++;
+    }
+  }
+
+  return waiting;
+}
+
+int OutboundQueue::count() const {
+  return implementation->size + implementation->spill.count();
+}
+
+void OutboundQueue::setPolicy(const OverflowPolicy policy) {
+  implementation->policy = policy;
+}
+
+const QueueStats &OutboundQueue::getStats() const {
+  return implementation->stats;
+}
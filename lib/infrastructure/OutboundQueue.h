@@ -0,0 +1,217 @@
+/*
+ * OutboundQueue.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_OUTBOUNDQUEUE
+  #define _C1MOORE_INFRASTRUCTURE_OUTBOUNDQUEUE
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+
+  #include "DCP/DCPCompletion.h"
+  #include "DCP/DCPResponse.h"
+  #include "SpillRing.h"
+  #include "UpdateBatch.h"
+
+  // The number of updates kept in RAM.  Once full, new updates are spilled to EEPROM.
+  #ifndef OUTBOUND_RAM_RECORDS
+    #define OUTBOUND_RAM_RECORDS 32
+  #endif
+
+  // The minimum time, in milliseconds, between writes of spilled updates to flash.
+  #ifndef SPILL_SYNC_INTERVAL
+    #define SPILL_SYNC_INTERVAL 5000
+  #endif
+
+  // The batch tag of updates that have been taken for a request that has not been written yet.
+  #define OUTBOUND_PENDING ((unsigned long) -1)
+
+  /**
+   * OverflowPolicy determines what happens to an update when the OutboundQueue is full.
+   */
+  enum OverflowPolicy {
+    QUEUE_DROP_OLDEST,  // Drop the oldest update that is not in flight to make room for the new one.
+    QUEUE_DROP_NEWEST,  // Drop the new update.
+    QUEUE_COLLAPSE      // Replace the queued update of the same sub device, so only the latest state of each sub device is kept.  While updates are spilled, store it behind them instead.  If full, drop the oldest.
+  };
+
+  /**
+   * OutboundLane classifies updates by how urgently they must reach the Master node.  Each lane has its own OutboundQueue and
+   * higher lanes are always sent first.
+   */
+  enum OutboundLane {
+    LANE_URGENT,  // Events that drive an immediate reaction, such as motion turning on the lights.
+    LANE_NORMAL,  // State updates.
+    LANE_BULK,    // Telemetry and other large or periodic transfers that can wait.
+    LANE_COUNT    // The number of lanes.  This is not a lane.
+  };
+
+  /**
+   * LaneStats describes how long the updates of an OutboundLane waited to be sent.
+   */
+  struct LaneStats {
+    unsigned long requests;   // The number of requests sent from the lane.
+    unsigned long records;    // The number of updates sent in those requests.
+    unsigned long totalWait;  // The sum of the time, in milliseconds, the oldest update of each request waited to be sent.
+    unsigned long maxWait;    // The longest time, in milliseconds, an update waited to be sent.
+  };
+
+  /**
+   * QueueStats describes how the OutboundQueue has coped with the Master node's availability.
+   */
+  struct QueueStats {
+    unsigned long queued;     // The number of updates added to the queue.
+    unsigned long delivered;  // The number of updates acknowledged by the Master node.
+    unsigned long dropped;    // The number of updates dropped because the queue was full.
+    unsigned long collapsed;  // The number of updates that replaced an earlier update to the same sub device.
+    unsigned long spilled;    // The number of updates spilled to EEPROM.
+    unsigned long retried;    // The number of updates that had to be sent again.
+    int maxDepth;             // The most updates held by the queue at once.
+  };
+
+  /**
+   * The OutboundQueue stores updates until the Master node acknowledges them, so updates are not lost while the Master node is
+   * unreachable.  Updates are kept in RAM until OUTBOUND_RAM_RECORDS are queued, then spilled to a SpillRing in EEPROM.  Spilled
+   * updates are moved back into RAM, in order, as room frees up.  Memory use is bounded by both; once both are full, the
+   * OverflowPolicy decides which update is dropped.  Updates longer than SPILL_MAX_DATA cannot be spilled, so they are only
+   * queued if there is room for them in RAM and no update is waiting in EEPROM ahead of them.
+   *
+   * Updates are sent in batches.  `take()` moves the oldest updates that are not in flight into an UpdateBatch, `dispatched()`
+   * tags them with the SESSION_TIMESTAMP of the request that carried them, and `acknowledge()` or `release()` settles them once
+   * the request is answered.  Released updates keep their place in the queue, so after an outage the queue is replayed in the
+   * order the updates were made.
+   *
+   * The handle of an update is completed once the update is acknowledged or dropped.  Handles cannot be stored in EEPROM, so the
+   * handle of a spilled update is completed with RESPONSE_TIMEOUT when it is spilled, even though the update is still delivered.
+   */
+  class OutboundQueue {
+    public:
+      /**
+       * Creates a new OutboundQueue.
+       *
+       * @param spillAddr (const int) - the address of the EEPROM region used to spill updates
+       * @param spillSize (const int) - the number of bytes in the EEPROM region.  0 keeps every update in RAM.
+       * @param policy (const OverflowPolicy) _optional_ - what to do when the queue is full.  Default: QUEUE_DROP_OLDEST
+       */
+      OutboundQueue(const int spillAddr, const int spillSize, const OverflowPolicy policy = QUEUE_DROP_OLDEST);
+      ~OutboundQueue();
+
+      /**
+       * Recovers the updates spilled before the last restart.  `EEPROM.begin()` must be called first.
+       *
+       * @return (int) the number of updates recovered
+       */
+      int begin();
+
+      /**
+       * Adds an update to the end of the queue.
+       *
+       * @param subDeviceId (uint16_t) - the unique ID of the sub device sending the update
+       * @param data (const String &) - the data of the update
+       * @param completion (DCPCompletion *) - the handle to complete once the update is acknowledged or NULL
+       *
+       * @return (int) 0 if the update was queued; 1 if it replaced a queued update; -1 if it was dropped
+       */
+      int push(uint16_t subDeviceId, const String &data, DCPCompletion *completion);
+
+      /**
+       * Moves the oldest updates that are not in flight into `batch` until the batch is full or would exceed `byteBudget` bytes.
+       * At least one update is taken if any is waiting.  The updates are tagged OUTBOUND_PENDING until `dispatched()` is called.
+       *
+       * @param batch (UpdateBatch &) - an empty batch
+       * @param byteBudget (const unsigned int) - the size, in bytes, the batch should not exceed
+       *
+       * @return (int) the number of updates taken
+       */
+      int take(UpdateBatch &batch, const unsigned int byteBudget);
+
+      /**
+       * Tags the updates last taken with the request that carried them.
+       *
+       * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request or 0 if it could not be sent
+       */
+      void dispatched(const unsigned long timestamp);
+
+      /**
+       * Removes the updates carried by an acknowledged request and completes their handles.
+       *
+       * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request
+       * @param response (const DCPResponse &) - the response to the request
+       * @param latency (const unsigned long) - the round trip time, in milliseconds, of the request
+       */
+      void acknowledge(const unsigned long timestamp, const DCPResponse &response, const unsigned long latency);
+
+      /**
+       * Returns the updates carried by a failed request to the queue so they are sent again.
+       *
+       * @param timestamp (const unsigned long) - the SESSION_TIMESTAMP of the request
+       */
+      void release(const unsigned long timestamp);
+
+      /**
+       * Moves spilled updates back into RAM while there is room.  Spilled updates are written to flash by `sync()`; if they have
+       * waited twice SPILL_SYNC_INTERVAL for it, such as on a device that is never idle, they are written here instead.  This
+       * should be called regularly.
+       */
+      void maintain();
+
+      /**
+       * Writes spilled updates to flash if any changed and SPILL_SYNC_INTERVAL has passed since they were last written.  A write
+       * keeps the MCU for as long as the flash takes, so this is meant to be called when the device is idle.
+       *
+       * @return (bool) true iff the spilled updates were written
+       */
+      bool sync();
+
+      /**
+       * Returns how long the oldest update that is not in flight has been waiting.
+       *
+       * @return (unsigned long) the time, in milliseconds, the update has waited or 0 if no update is waiting
+       */
+      unsigned long age() const;
+
+      /**
+       * Returns the number of data bytes of the updates in RAM that are not in flight.
+       *
+       * @return (unsigned int) the number of bytes waiting to be sent
+       */
+      unsigned int waitingBytes() const;
+
+      /**
+       * Returns the number of updates in RAM that are not in flight.
+       *
+       * @return (int) the number of updates waiting to be sent
+       */
+      int waitingCount() const;
+
+      /**
+       * Returns the number of updates in the queue, including spilled updates and updates in flight.
+       *
+       * @return (int) the number of updates in the queue
+       */
+      int count() const;
+
+      /**
+       * Changes what happens to an update when the queue is full.
+       *
+       * @param policy (const OverflowPolicy) - the new policy
+       */
+      void setPolicy(const OverflowPolicy policy);
+
+      /**
+       * Returns the queue statistics.
+       *
+       * @return (const QueueStats &) the queue statistics
+       */
+      const QueueStats &getStats() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_OUTBOUNDQUEUE */
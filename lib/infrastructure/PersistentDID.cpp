@@ -4,6 +4,8 @@
  *  Created on: Feb 26, 2018
  *      Author: c1moore
  */
+#include <stddef.h>
+
 #include <EEPROM.h>
 
 #include "PersistentDID.h"
@@ -30,28 +32,8 @@ struct PersistentDId {
  * @return (uint8_t) the checksum calculated
  */
 uint8_t calculateChecksum(PersistentDId *pdid) {
-  const int dataLength = sizeof(pdid);
-
-  uint8_t bitmask;
-  uint8_t crc = 0xff;
-  uint8_t *data = (uint8_t *) pdid;
-
-  for(int byteIndex = 0; byteIndex < dataLength; byteIndex++) {
-      bitmask = (data[byteIndex] ^ crc) & 0xff;
-
-      crc = 0;
-
-      if(bitmask &  0x1) crc ^= 0x5e;
-      if(bitmask &  0x2) crc ^= 0xbc;
-      if(bitmask &  0x4) crc ^= 0x61;
-      if(bitmask &  0x8) crc ^= 0xc2;
-      if(bitmask & 0x10) crc ^= 0x9d;
-      if(bitmask & 0x20) crc ^= 0x23;
-      if(bitmask & 0x40) crc ^= 0x46;
-      if(bitmask & 0x80) crc ^= 0x8c;
-  }
-
-  return crc;
+  // The checksum covers every field before it.  On the ESP8266, this is the same 4 bytes the checksum has always covered.
+  return persistentChecksum(pdid, offsetof(PersistentDId, checksum));
 }
 
 int writeDeviceId(uint8_t dId, int startAddr) {
@@ -85,3 +67,26 @@ uint8_t readDeviceId(int startAddr) {
 
   return pdid.deviceId;
 }
+
+uint8_t persistentChecksum(const void *data, const int length) {
+  uint8_t bitmask;
+  uint8_t crc = 0xff;
+  const uint8_t *bytes = (const uint8_t *) data;
+
+  for(int byteIndex = 0; byteIndex < length; byteIndex++) {
+      bitmask = (bytes[byteIndex] ^ crc) & 0xff;
+
+      crc = 0;
+
+      if(bitmask &  0x1) crc ^= 0x5e;
+      if(bitmask &  0x2) crc ^= 0xbc;
+      if(bitmask &  0x4) crc ^= 0x61;
+      if(bitmask &  0x8) crc ^= 0xc2;
+      if(bitmask & 0x10) crc ^= 0x9d;
+      if(bitmask & 0x20) crc ^= 0x23;
+      if(bitmask & 0x40) crc ^= 0x46;
+      if(bitmask & 0x80) crc ^= 0x8c;
+  }
+
+  return crc;
+}
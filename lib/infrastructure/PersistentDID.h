@@ -30,4 +30,14 @@
    */
   uint8_t readDeviceId(int startAddr);
 
+  /**
+   * Calculates a CRC-8 checksum that can be used to validate data stored in EEPROM.
+   *
+   * @param data (const void *) - the data for which the checksum should be calculated
+   * @param length (const int) - the number of bytes in data
+   *
+   * @return (uint8_t) the checksum calculated
+   */
+  uint8_t persistentChecksum(const void *data, const int length);
+
 #endif /* _C1MOORE_INFRASTRUCTURE_PERSISTENTDID */
@@ -0,0 +1,32 @@
+/*
+ * PersistentLayout.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_PERSISTENTLAYOUT
+  #define _C1MOORE_INFRASTRUCTURE_PERSISTENTLAYOUT
+
+  /*
+   * The layout of the data this device keeps in EEPROM.  Each region starts at a fixed address so changing the size of one
+   * region does not invalidate the data stored in the others.
+   */
+
+  // The number of bytes of flash emulating EEPROM.  The ESP8266 supports at most 4096.
+  #define EEPROM_SIZE             4096
+
+  // The device ID assigned by the Master node.  See PersistentDID.h.
+  #define DEVICE_ID_ADDRESS       0
+
+  // The access point and IP configuration used to rejoin the network quickly.  See WiFiLink.h.
+  #define WIFI_CACHE_ADDRESS      16
+
+  // The session and sub device IDs assigned by the Master node, so a restart does not register every sub device again.  See
+  // RegistrationCache.h.
+  #define REGISTRATION_ADDRESS    64
+
+  // The ring that holds outbound updates that could not be kept in RAM while the Master node was unreachable.
+  #define OUTBOUND_SPILL_ADDRESS  1024
+  #define OUTBOUND_SPILL_SIZE     3072
+
+#endif /* _C1MOORE_INFRASTRUCTURE_PERSISTENTLAYOUT */
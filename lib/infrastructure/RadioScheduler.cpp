@@ -0,0 +1,169 @@
+/*
+ * RadioScheduler.cpp
+ *
+ *      Author: c1moore
+ */
+#include <ESP8266WiFi.h>
+
+#include "RadioScheduler.h"
+
+void ModemSleepRadio::wake() {
+  WiFi.setSleepMode(WIFI_NONE_SLEEP);
+}
+
+void ModemSleepRadio::sleep() {
+  WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+}
+
+ConstantPowerModel::ConstantPowerModel(const float onPower, const float sleepPower, const float wakeEnergy): onPower(onPower),
+    sleepPower(sleepPower), wakeEnergy(wakeEnergy) { }
+
+float ConstantPowerModel::getPower(const RadioState state) const {
+  return (state == RADIO_ON) ? onPower : sleepPower;
+}
+
+float ConstantPowerModel::getWakeEnergy() const {
+  return wakeEnergy;
+}
+
+class RadioScheduler::Implementation {
+  public:
+    Radio &radio;
+    PowerModel &model;
+    const unsigned long interval;
+    const unsigned long length;
+
+    RadioState state = RADIO_SLEEPING;
+    RadioStats stats = { 0, 0, 0, 0 };
+
+    unsigned long created;
+    unsigned long stateSince;   // The time, in milliseconds, the radio entered its current state.
+    unsigned long burstStart;   // The time, in milliseconds, the current or last burst started.
+    unsigned long nextBurst;    // The time, in milliseconds, the next scheduled burst starts.
+    unsigned long wakes = 0;    // The number of times the radio was turned on.
+
+    Implementation(Radio &radio, PowerModel &model, const unsigned long interval, const unsigned long length): radio(radio),
+        model(model), interval(interval), length(length) {
+      created = millis();
+      stateSince = created;
+      burstStart = created;
+      nextBurst = created;
+    }
+
+    /**
+     * Moves the radio to a new state, accounting for the time spent in the old one.
+     *
+     * @param next (const RadioState) - the new state
+     */
+    void enter(const RadioState next) {
+      const unsigned long now = millis();
+
+      if(state == RADIO_ON) {
+        stats.onTime += now - stateSince;
+      } else {
+        stats.sleepTime += now - stateSince;
+      }
+
+      state = next;
+      stateSince = now;
+
+      if(next == RADIO_ON) {
+        wakes++;
+        burstStart = now;
+
+        radio.wake();
+      } else {
+        radio.sleep();
+      }
+    }
+};
+
+RadioScheduler::RadioScheduler(Radio &radio, PowerModel &model, const unsigned long interval, const unsigned long length) {
+  implementation = new Implementation(radio, model, interval, length);
+}
+
+RadioScheduler::~RadioScheduler() {
+  delete implementation;
+}
+
+void RadioScheduler::update(const bool busy) {
+  const unsigned long now = millis();
+
+  if(implementation->state == RADIO_SLEEPING) {
+    if((long) (now - implementation->nextBurst) >= 0) {
+      implementation->stats.bursts++;
+      implementation->nextBurst += implementation->interval;
+
+      // Skip the bursts that were missed rather than running them back to back.
+      if((long) (now - implementation->nextBurst) >= 0) {
+        implementation->nextBurst = now + implementation->interval;
+      }
+
+      implementation->enter(RADIO_ON);
+    }
+
+    return;
+  }
+
+  if(!busy && now - implementation->burstStart >= implementation->length) {
+    implementation->enter(RADIO_SLEEPING);
+  }
+}
+
+void RadioScheduler::breakthrough() {
+  if(implementation->state == RADIO_ON) {
+    return;
+  }
+
+  implementation->stats.breakthroughs++;
+  implementation->enter(RADIO_ON);
+}
+
+bool RadioScheduler::isAwake() const {
+  return (implementation->state == RADIO_ON);
+}
+
+const RadioStats &RadioScheduler::getStats() const {
+  return implementation->stats;
+}
+
+float RadioScheduler::getDutyCycle() const {
+  const unsigned long elapsed = millis() - implementation->created;
+  unsigned long onTime = implementation->stats.onTime;
+
+  if(implementation->state == RADIO_ON) {
+    onTime += millis() - implementation->stateSince;
+  }
+
+  if(elapsed == 0) {
+    return (implementation->state == RADIO_ON) ? 1 : 0;
+  }
+
+  return (float) onTime / elapsed;
+}
+
+float RadioScheduler::getEnergyPerHour() const {
+  const unsigned long now = millis();
+  const unsigned long elapsed = now - implementation->created;
+
+  unsigned long onTime = implementation->stats.onTime;
+  unsigned long sleepTime = implementation->stats.sleepTime;
+
+  if(implementation->state == RADIO_ON) {
+    onTime += now - implementation->stateSince;
+  } else {
+    sleepTime += now - implementation->stateSince;
+  }
+
+  if(elapsed == 0) {
+    return 0;
+  }
+
+  const PowerModel &model = implementation->model;
+
+  // Milliwatts for milliseconds are microjoules.
+  const float energy = (onTime * model.getPower(RADIO_ON) + sleepTime * model.getPower(RADIO_SLEEPING)) / 1000000.0 +
+      implementation->wakes * model.getWakeEnergy() / 1000.0;
+
+  return energy * (3600000.0 / elapsed);
+}
@@ -0,0 +1,194 @@
+/*
+ * RadioScheduler.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_RADIOSCHEDULER
+  #define _C1MOORE_INFRASTRUCTURE_RADIOSCHEDULER
+
+  #include <Arduino.h>
+
+  // The default time, in milliseconds, from the start of one burst to the start of the next.
+  #ifndef RADIO_BURST_INTERVAL
+    #define RADIO_BURST_INTERVAL 30000
+  #endif
+
+  // The default time, in milliseconds, the radio stays on for each burst.  The radio stays on longer while requests are waiting
+  // for a response.
+  #ifndef RADIO_BURST_LENGTH
+    #define RADIO_BURST_LENGTH 250
+  #endif
+
+  /**
+   * RadioState enumerates the power states of the radio.
+   */
+  enum RadioState {
+    RADIO_ON,       // The radio can send and receive.
+    RADIO_SLEEPING  // The radio is in its low-power state between bursts.
+  };
+
+  /**
+   * Radio switches the radio between its power states.
+   */
+  class Radio {
+    public:
+      Radio() {}
+      virtual ~Radio() {};
+
+      /**
+       * Turns the radio on.
+       */
+      virtual void wake() = 0;
+
+      /**
+       * Puts the radio in its low-power state.
+       */
+      virtual void sleep() = 0;
+  };
+
+  /**
+   * PowerModel estimates what the radio costs in each of its power states, so the effect of the burst schedule can be compared
+   * across hardware.
+   */
+  class PowerModel {
+    public:
+      PowerModel() {}
+      virtual ~PowerModel() {};
+
+      /**
+       * Returns the power the radio draws in a state.
+       *
+       * @param state (const RadioState) - the state
+       *
+       * @return (float) the power, in milliwatts
+       */
+      virtual float getPower(const RadioState state) const = 0;
+
+      /**
+       * Returns the energy it takes to turn the radio on, in addition to the power it draws once it is on.
+       *
+       * @return (float) the energy, in millijoules
+       */
+      virtual float getWakeEnergy() const = 0;
+  };
+
+  /**
+   * ModemSleepRadio puts the ESP8266 in modem sleep between bursts.  Unlike `WiFi.forceSleepBegin()`, modem sleep keeps the
+   * device associated with the access point, so the persistent connection to the Master node survives the low-power state and
+   * no time is spent rejoining the network at the start of each burst.
+   */
+  class ModemSleepRadio: public Radio {
+    public:
+      void wake();
+      void sleep();
+  };
+
+  /**
+   * ConstantPowerModel draws a constant power in each state.  The defaults are the ESP8266 datasheet figures at 3.3V: 56mA while
+   * receiving and 15mA in modem sleep.
+   */
+  class ConstantPowerModel: public PowerModel {
+    public:
+      /**
+       * Creates a new ConstantPowerModel.
+       *
+       * @param onPower (const float) _optional_ - the power, in milliwatts, drawn while the radio is on.  Default: 184.8
+       * @param sleepPower (const float) _optional_ - the power, in milliwatts, drawn while the radio sleeps.  Default: 49.5
+       * @param wakeEnergy (const float) _optional_ - the energy, in millijoules, it takes to turn the radio on.  Default: 0
+       */
+      ConstantPowerModel(const float onPower = 184.8, const float sleepPower = 49.5, const float wakeEnergy = 0);
+
+      float getPower(const RadioState state) const;
+      float getWakeEnergy() const;
+
+    private:
+      const float onPower;
+      const float sleepPower;
+      const float wakeEnergy;
+  };
+
+  /**
+   * RadioStats describes how long the radio was on and why.
+   */
+  struct RadioStats {
+    unsigned long bursts;         // The number of scheduled bursts.
+    unsigned long breakthroughs;  // The number of times the radio was turned on early for an urgent update.
+    unsigned long onTime;         // The total time, in milliseconds, the radio was on.
+    unsigned long sleepTime;      // The total time, in milliseconds, the radio slept.
+  };
+
+  /**
+   * RadioScheduler aligns the traffic to the Master node into bursts so the radio can sleep in between, which matters on
+   * battery-powered devices where the radio is the dominant cost.  Every `interval` milliseconds the radio is turned on for
+   * at least `length` milliseconds; the owner holds back everything that is not urgent until the radio is on (see
+   * `Coordinator::setRadioScheduler()`).  Urgent updates break through: `breakthrough()` turns the radio on immediately and
+   * starts an unscheduled burst, which everything else waiting can use as well.
+   *
+   * The interval trades radio-on time for latency: an update that is not urgent waits for up to `interval` milliseconds.  The
+   * radio-on time and energy estimate here, together with the wait times in `Coordinator::getLaneStats()`, show the tradeoff.
+   * Both the Radio and the PowerModel can be replaced, for example by a simulated radio to measure a schedule without hardware.
+   */
+  class RadioScheduler {
+    public:
+      /**
+       * Creates a new RadioScheduler.  The first burst starts immediately.
+       *
+       * @param radio (Radio &) - the radio to switch
+       * @param model (PowerModel &) - the model used to estimate the energy used by the radio
+       * @param interval (const unsigned long) _optional_ - the time, in milliseconds, between bursts.  Default: RADIO_BURST_INTERVAL
+       * @param length (const unsigned long) _optional_ - the time, in milliseconds, the radio stays on for each burst.  Default:
+       *  RADIO_BURST_LENGTH
+       */
+      RadioScheduler(Radio &radio, PowerModel &model, const unsigned long interval = RADIO_BURST_INTERVAL,
+          const unsigned long length = RADIO_BURST_LENGTH);
+      ~RadioScheduler();
+
+      /**
+       * Turns the radio on when the next burst is due and back off once the burst is over.  This should be called regularly by
+       * the owner.
+       *
+       * @param busy (const bool) - whether requests are waiting for a response, which keeps the radio on past the end of the burst
+       */
+      void update(const bool busy);
+
+      /**
+       * Turns the radio on immediately for an urgent update.  Does nothing if the radio is already on.
+       */
+      void breakthrough();
+
+      /**
+       * Checks whether the radio is on.
+       *
+       * @return (bool) true iff the radio is on
+       */
+      bool isAwake() const;
+
+      /**
+       * Returns the radio statistics, up to the last state change.
+       *
+       * @return (const RadioStats &) the radio statistics
+       */
+      const RadioStats &getStats() const;
+
+      /**
+       * Returns the fraction of the time the radio has been on.
+       *
+       * @return (float) the duty cycle, between 0 and 1
+       */
+      float getDutyCycle() const;
+
+      /**
+       * Estimates the energy the radio uses per hour, averaged since the RadioScheduler was created.
+       *
+       * @return (float) the energy, in joules per hour
+       */
+      float getEnergyPerHour() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_RADIOSCHEDULER */
@@ -0,0 +1,211 @@
+/*
+ * RegistrationCache.cpp
+ *
+ *      Author: c1moore
+ */
+#include <EEPROM.h>
+
+#include "PersistentDID.h"
+#include "RegistrationCache.h"
+
+#define REGISTRATION_MAGIC_NUMBER 0x5b
+
+/**
+ * RegisteredSubDevice is the registration of one sub device.
+ */
+struct RegisteredSubDevice {
+  uint8_t kind;   // The SubDeviceKind of the sub device.
+  uint8_t type;   // The SensorType or OutputType of the sub device.
+  uint16_t id;    // The ID of the sub device.
+};
+
+/**
+ * PersistentRegistration is the layout of the cache in EEPROM.
+ */
+struct PersistentRegistration {
+  uint8_t magicNumber;
+  uint8_t checksum;
+  uint8_t count;
+  uint8_t padding;
+
+  uint32_t configHash;
+  char sessionId[REGISTRATION_SESSION_LENGTH + 1];
+
+  RegisteredSubDevice subDevices[MAX_REGISTRATIONS];
+};
+
+class RegistrationCache::Implementation {
+  public:
+    const int startAddr;
+
+    PersistentRegistration cached;            // The cache read by `begin()`.
+    bool valid = false;
+    bool claimed[MAX_REGISTRATIONS] = {};     // Whether a sub device of the current configuration took the cached ID.
+
+    RegisteredSubDevice current[MAX_REGISTRATIONS];
+    int count = 0;
+
+    Implementation(const int startAddr): startAddr(startAddr) {
+      memset(&cached, 0, sizeof(cached));
+    }
+
+    /**
+     * Checks whether an ID is taken by the cache or the current configuration.
+     *
+     * @param id (const uint16_t) - the ID
+     *
+     * @return (bool) true iff the ID is taken
+     */
+    bool taken(const uint16_t id) const {
+      for(int index = 0; valid && index < cached.count; index++) {
+        if(cached.subDevices[index].id == id) {
+          return true;
+        }
+      }
+
+      for(int index = 0; index < count; index++) {
+        if(current[index].id == id) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    /**
+     * Calculates the FNV-1a hash of the current configuration.  A CRC-8 is enough to detect corrupted flash but would let
+     * different configurations collide too easily.
+     *
+     * @return (uint32_t) the configuration hash
+     */
+    uint32_t hash() const {
+      uint32_t value = 2166136261UL;
+      const uint8_t *bytes = (const uint8_t *) current;
+
+      for(unsigned int index = 0; index < count * sizeof(RegisteredSubDevice); index++) {
+        value = (value ^ bytes[index]) * 16777619UL;
+      }
+
+      return value;
+    }
+};
+
+RegistrationCache::RegistrationCache(const int startAddr) {
+  implementation = new Implementation(startAddr);
+}
+
+RegistrationCache::~RegistrationCache() {
+  delete implementation;
+}
+
+bool RegistrationCache::begin() {
+  PersistentRegistration &cached = implementation->cached;
+
+  EEPROM.get(implementation->startAddr, cached);
+
+  const uint8_t checksum = cached.checksum;
+  cached.checksum = 0;
+
+  implementation->valid = (cached.magicNumber == REGISTRATION_MAGIC_NUMBER && cached.count <= MAX_REGISTRATIONS &&
+      checksum == persistentChecksum(&cached, sizeof(cached)));
+
+  if(!implementation->valid) {
+    memset(&cached, 0, sizeof(cached));
+  }
+
+  return implementation->valid;
+}
+
+int RegistrationCache::assign(const SubDeviceKind kind, const uint8_t type) {
+  if(implementation->count >= MAX_REGISTRATIONS) {
+    return -1;
+  }
+
+  const PersistentRegistration &cached = implementation->cached;
+  uint16_t id = 0;
+
+  for(int index = 0; implementation->valid && index < cached.count; index++) {
+    const RegisteredSubDevice &subDevice = cached.subDevices[index];
+
+    if(!implementation->claimed[index] && subDevice.kind == kind && subDevice.type == type) {
+      implementation->claimed[index] = true;
+      id = subDevice.id;
+
+      break;
+    }
+  }
+
+  if(id == 0) {
+    for(id = 1; implementation->taken(id); id++);
+  }
+
+  RegisteredSubDevice &subDevice = implementation->current[implementation->count++];
+
+  subDevice.kind = kind;
+  subDevice.type = type;
+  subDevice.id = id;
+
+  return id;
+}
+
+bool RegistrationCache::matches() const {
+  return (implementation->valid && implementation->cached.count == implementation->count &&
+      implementation->cached.configHash == implementation->hash());
+}
+
+uint32_t RegistrationCache::getConfigHash() const {
+  return implementation->hash();
+}
+
+String RegistrationCache::getSessionId() const {
+  if(!implementation->valid) {
+    return String();
+  }
+
+  return String(implementation->cached.sessionId);
+}
+
+String RegistrationCache::encode() const {
+  String encoded;
+
+  for(int index = 0; index < implementation->count; index++) {
+    const RegisteredSubDevice &subDevice = implementation->current[index];
+
+    encoded += String((unsigned int) subDevice.kind);
+    encoded += ':';
+    encoded += String((unsigned int) subDevice.type);
+    encoded += ':';
+    encoded += String((unsigned int) subDevice.id);
+    encoded += '\n';
+  }
+
+  return encoded;
+}
+
+void RegistrationCache::store(const String &sessionId) {
+  PersistentRegistration registration;
+  memset(&registration, 0, sizeof(registration));
+
+  registration.magicNumber = REGISTRATION_MAGIC_NUMBER;
+  registration.count = implementation->count;
+  registration.configHash = implementation->hash();
+  strncpy(registration.sessionId, sessionId.c_str(), REGISTRATION_SESSION_LENGTH);
+  memcpy(registration.subDevices, implementation->current, implementation->count * sizeof(RegisteredSubDevice));
+
+  if(implementation->valid && memcmp(&registration, &implementation->cached, sizeof(registration)) == 0) {
+    return;
+  }
+
+  implementation->cached = registration;
+  implementation->valid = true;
+
+  // The claims were made against the old cache; the current configuration now owns every cached ID.
+  for(int index = 0; index < MAX_REGISTRATIONS; index++) {
+    implementation->claimed[index] = (index < implementation->count);
+  }
+
+  registration.checksum = persistentChecksum(&registration, sizeof(registration));
+
+  EEPROM.put(implementation->startAddr, registration);
+  EEPROM.commit();
+}
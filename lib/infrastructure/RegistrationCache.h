@@ -0,0 +1,115 @@
+/*
+ * RegistrationCache.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_REGISTRATIONCACHE
+  #define _C1MOORE_INFRASTRUCTURE_REGISTRATIONCACHE
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+
+  // The maximum number of sub devices that can be registered with the Master node.
+  #ifndef MAX_REGISTRATIONS
+    #define MAX_REGISTRATIONS 32
+  #endif
+
+  // The maximum number of characters in a session ID assigned by the Master node.
+  #define REGISTRATION_SESSION_LENGTH 32
+
+  /**
+   * SubDeviceKind enumerates the kinds of sub devices that can be registered with the Master node.
+   */
+  enum SubDeviceKind {
+    SUBDEVICE_SENSOR,
+    SUBDEVICE_OUTPUT
+  };
+
+  /**
+   * RegistrationCache keeps the result of registering this device's sub devices with the Master node in EEPROM, so a restart
+   * does not have to register every sub device again.  The cache holds the session ID assigned by the Master node, the ID of
+   * every sub device, and a hash of the configuration: the kind, type and ID of each sub device, in the order they were
+   * registered.
+   *
+   * Sub devices are registered while the device starts, before the Master node can be reached, so `assign()` hands out IDs
+   * locally.  A sub device gets the ID it had before the restart if the cache holds a sub device of the same kind and type that
+   * has not been claimed yet; otherwise it gets the lowest ID not used by the cache or the current configuration.  IDs therefore
+   * survive sub devices being added or removed, and the configuration hash only changes when the configuration does.
+   *
+   * The Coordinator compares the hash with the cached one once registration is done (see `matches()`) and stores the new
+   * configuration once the Master node has accepted it (see `store()`).
+   */
+  class RegistrationCache {
+    public:
+      /**
+       * Creates a new RegistrationCache.  The cache is not read until `begin()` is called.
+       *
+       * @param startAddr (const int) - the address of the EEPROM region holding the cache
+       */
+      RegistrationCache(const int startAddr);
+      ~RegistrationCache();
+
+      /**
+       * Reads the cache.  `EEPROM.begin()` must be called first.
+       *
+       * @return (bool) true iff a valid cache was found
+       */
+      bool begin();
+
+      /**
+       * Registers a sub device locally and assigns it an ID.
+       *
+       * @param kind (const SubDeviceKind) - the kind of the sub device
+       * @param type (const uint8_t) - the SensorType or OutputType of the sub device
+       *
+       * @return (int) the ID of the sub device, which is never 0, or -1 if MAX_REGISTRATIONS sub devices are already registered
+       */
+      int assign(const SubDeviceKind kind, const uint8_t type);
+
+      /**
+       * Checks whether the current configuration is the one the Master node accepted before the restart.
+       *
+       * @return (bool) true iff the cache is valid and its configuration hash matches the current configuration
+       */
+      bool matches() const;
+
+      /**
+       * Returns the hash of the current configuration.
+       *
+       * @return (uint32_t) the configuration hash
+       */
+      uint32_t getConfigHash() const;
+
+      /**
+       * Returns the session ID cached with the configuration.
+       *
+       * @return (String) the cached session ID or an empty String if the cache is not valid
+       */
+      String getSessionId() const;
+
+      /**
+       * Encodes the current configuration for a registration request, one sub device per line:
+       *
+       *    KIND:TYPE:ID
+       *
+       * @return (String) the encoded configuration
+       */
+      String encode() const;
+
+      /**
+       * Caches the current configuration with the session ID the Master node assigned to it.  Flash is only written if the cache
+       * changed.
+       *
+       * @param sessionId (const String &) - the session ID, truncated to REGISTRATION_SESSION_LENGTH characters
+       */
+      void store(const String &sessionId);
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_REGISTRATIONCACHE */
@@ -0,0 +1,247 @@
+/*
+ * RequestThrottle.cpp
+ *
+ *      Author: c1moore
+ */
+#include "RequestThrottle.h"
+
+class RequestThrottle::Implementation {
+  public:
+    unsigned int rate;
+    unsigned int burst;
+
+    unsigned long tokens;         // The tokens in the bucket, in thousandths of a request, as of `lastRefill`.
+    unsigned long lastRefill;     // The time, in milliseconds, the bucket was last refilled.  This is in the future while suspended.
+
+    bool suspended = false;
+    unsigned long resumeAt = 0;   // The time, in milliseconds, sending resumes.
+    int downCount = 0;            // The number of consecutive SERVER_DOWN responses without a recovery time.
+
+    unsigned int requestLimit = 0;  // The limit set by REQUEST_TOO_LONG or 0 if there is none.
+    unsigned int timeoutLimit = 0;  // The limit set by REQUEST_TIMEOUT or 0 if there is none.
+    unsigned int timedOut = 0;      // The size of the request that set `timeoutLimit`, to which it recovers.
+    int successes = 0;              // The number of successful requests since `timeoutLimit` last changed.
+
+    ThrottleStats stats = { 0, 0, 0, 0 };
+
+    Implementation(const unsigned int rate, const unsigned int burst): rate(rate), burst(burst) {
+      tokens = burst * 1000UL;
+      lastRefill = millis();
+    }
+
+    /**
+     * Calculates the tokens in the bucket now.
+     *
+     * @return (unsigned long) the tokens, in thousandths of a request
+     */
+    unsigned long available() const {
+      const unsigned long capacity = burst * 1000UL;
+      const long elapsed = (long) (millis() - lastRefill);
+
+      if(elapsed <= 0 || rate == 0) {
+        return tokens;
+      }
+
+      // A bucket left alone long enough is full; checking first keeps `elapsed * rate` from overflowing.
+      if((unsigned long) elapsed >= capacity / rate) {
+        return capacity;
+      }
+
+      return min(capacity, tokens + elapsed * rate);
+    }
+
+    /**
+     * Checks whether sending is suspended.
+     *
+     * @return (bool) true iff the recovery time has not passed yet
+     */
+    bool suspendedNow() const {
+      return (suspended && (long) (resumeAt - millis()) > 0);
+    }
+
+    /**
+     * Suspends sending for `delay` milliseconds plus a random jitter.  A suspension already in effect is only extended.  The
+     * bucket is left with a single token, so the first request after the suspension probes the Master node and the rest
+     * follow at the rate limit.
+     *
+     * @param delay (unsigned long) - the time, in milliseconds, the Master node expects to be down
+     */
+    void suspend(unsigned long delay) {
+      if(delay > SERVER_DOWN_BACKOFF_MAX) {
+        delay = SERVER_DOWN_BACKOFF_MAX;
+      }
+
+      const unsigned long until = millis() + delay + random(RECOVERY_JITTER + 1);
+
+      if(!suspendedNow() || (long) (until - resumeAt) > 0) {
+        resumeAt = until;
+      }
+
+      suspended = true;
+      tokens = 1000;
+      lastRefill = resumeAt;
+    }
+
+    /**
+     * Lowers the request limit set by REQUEST_TOO_LONG.  The limit is never raised again, since the Master node only lowers it by
+     * rejecting requests.
+     *
+     * @param limit (unsigned long) - the new limit, in bytes
+     */
+    void shrink(unsigned long limit) {
+      if(limit < REQUEST_LIMIT_MIN) {
+        limit = REQUEST_LIMIT_MIN;
+      }
+
+      if(requestLimit == 0 || limit < requestLimit) {
+        requestLimit = limit;
+      }
+    }
+
+    /**
+     * Halves the request limit set by REQUEST_TIMEOUT.
+     *
+     * @param bytes (const unsigned int) - the size, in bytes, of the request that timed out
+     */
+    void timeout(const unsigned int bytes) {
+      const unsigned int limit = max(bytes / 2, (unsigned int) REQUEST_LIMIT_MIN);
+
+      if(timeoutLimit == 0) {
+        timedOut = bytes;
+      }
+
+      if(timeoutLimit == 0 || limit < timeoutLimit) {
+        timeoutLimit = limit;
+      }
+
+      successes = 0;
+    }
+
+    /**
+     * Counts a successful request, doubling the request limit set by REQUEST_TIMEOUT after REQUEST_LIMIT_RECOVERY of them.  Once
+     * the limit is back to the size of the request that timed out, it is removed.
+     */
+    void succeeded() {
+      if(timeoutLimit == 0 || ++successes < REQUEST_LIMIT_RECOVERY) {
+        return;
+      }
+
+      successes = 0;
+      timeoutLimit = (timeoutLimit >= timedOut / 2) ? 0 : timeoutLimit * 2;
+    }
+};
+
+RequestThrottle::RequestThrottle(const unsigned int rate, const unsigned int burst) {
+  implementation = new Implementation(rate, burst);
+}
+
+RequestThrottle::~RequestThrottle() {
+  delete implementation;
+}
+
+bool RequestThrottle::ready() const {
+  return (!implementation->suspendedNow() && implementation->available() >= 1000);
+}
+
+bool RequestThrottle::take() {
+  if(!ready()) {
+    implementation->stats.throttled++;
+
+    return false;
+  }
+
+  const unsigned long now = millis();
+
+  implementation->suspended = false;
+  implementation->tokens = implementation->available() - 1000;
+
+  if((long) (now - implementation->lastRefill) > 0) {
+    implementation->lastRefill = now;
+  }
+
+  return true;
+}
+
+void RequestThrottle::observe(const DCPResponse &response, const unsigned int bytes) {
+  switch(response.statusCode) {
+    case SERVER_DOWN: {
+      const long recovery = response.data.toInt();
+      unsigned long delay = SERVER_DOWN_BACKOFF_MAX;
+
+      if(recovery > 0) {
+        delay = recovery;
+      } else if(implementation->downCount < 16) {
+        delay = (unsigned long) SERVER_DOWN_BACKOFF << implementation->downCount;
+        implementation->downCount++;
+      }
+
+      implementation->stats.suspensions++;
+      implementation->suspend(delay);
+      break;
+    }
+
+    case REQUEST_TOO_LONG: {
+      const long limit = response.data.toInt();
+
+      implementation->stats.tooLong++;
+
+      if(limit > 0) {
+        implementation->shrink(limit);
+      } else if(bytes > 0) {
+        implementation->shrink(bytes / 2);
+      }
+      break;
+    }
+
+    case REQUEST_TIMEOUT:
+      // The body holds how long the Master node waits for a request, which cannot be changed from here; sending less can.
+      implementation->stats.timeouts++;
+
+      if(bytes > 0) {
+        implementation->timeout(bytes);
+      }
+      break;
+
+    case RESPONSE_TIMEOUT:
+    case INVALID_RESPONSE:
+      // These are raised on this device and say nothing about the Master node's load.
+      break;
+
+    default:
+      implementation->downCount = 0;
+
+      if(response.statusCode == SUCCESS || response.statusCode == SUCCESS_NOCONTENT) {
+        implementation->succeeded();
+      }
+      break;
+  }
+}
+
+bool RequestThrottle::isSuspended() const {
+  return implementation->suspendedNow();
+}
+
+unsigned int RequestThrottle::getRequestLimit() const {
+  const unsigned int requestLimit = implementation->requestLimit;
+  const unsigned int timeoutLimit = implementation->timeoutLimit;
+
+  if(requestLimit == 0 || (timeoutLimit != 0 && timeoutLimit < requestLimit)) {
+    return timeoutLimit;
+  }
+
+  return requestLimit;
+}
+
+void RequestThrottle::setRate(const unsigned int rate, const unsigned int burst) {
+  implementation->tokens = min(implementation->available(), burst * 1000UL);
+  implementation->rate = rate;
+  implementation->burst = burst;
+
+  if((long) (millis() - implementation->lastRefill) > 0) {
+    implementation->lastRefill = millis();
+  }
+}
+
+const ThrottleStats &RequestThrottle::getStats() const {
+  return implementation->stats;
+}
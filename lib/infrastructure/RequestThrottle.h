@@ -0,0 +1,149 @@
+/*
+ * RequestThrottle.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_REQUESTTHROTTLE
+  #define _C1MOORE_INFRASTRUCTURE_REQUESTTHROTTLE
+
+  #include <Arduino.h>
+
+  #include "DCP/DCPResponse.h"
+
+  // The number of requests per second the device may send to the Master node on average.
+  #ifndef THROTTLE_RATE
+    #define THROTTLE_RATE 4
+  #endif
+
+  // The number of requests the device may send back to back before it is held to THROTTLE_RATE.
+  #ifndef THROTTLE_BURST
+    #define THROTTLE_BURST 8
+  #endif
+
+  // How long, in milliseconds, to stop sending after the first SERVER_DOWN that does not say when the Master node will recover.
+  // Each consecutive SERVER_DOWN doubles the delay up to SERVER_DOWN_BACKOFF_MAX.
+  #ifndef SERVER_DOWN_BACKOFF
+    #define SERVER_DOWN_BACKOFF 5000
+  #endif
+
+  // The longest time, in milliseconds, sending is suspended after a SERVER_DOWN, whatever recovery time the Master node sends.
+  #ifndef SERVER_DOWN_BACKOFF_MAX
+    #define SERVER_DOWN_BACKOFF_MAX 300000
+  #endif
+
+  // The longest time, in milliseconds, added at random to the recovery time sent by the Master node.
+  #ifndef RECOVERY_JITTER
+    #define RECOVERY_JITTER 5000
+  #endif
+
+  // The smallest request size, in bytes, the device will shrink its requests to.
+  #ifndef REQUEST_LIMIT_MIN
+    #define REQUEST_LIMIT_MIN 64
+  #endif
+
+  // The number of successful requests in a row after which a request limit lowered by REQUEST_TIMEOUT is doubled.
+  #ifndef REQUEST_LIMIT_RECOVERY
+    #define REQUEST_LIMIT_RECOVERY 8
+  #endif
+
+  /**
+   * ThrottleStats describes how often the device held back requests for the Master node's sake.
+   */
+  struct ThrottleStats {
+    unsigned long throttled;    // The number of requests refused because sending was suspended or the token bucket was empty.
+    unsigned long suspensions;  // The number of SERVER_DOWN responses that suspended sending.
+    unsigned long timeouts;     // The number of REQUEST_TIMEOUT responses.
+    unsigned long tooLong;      // The number of REQUEST_TOO_LONG responses.
+  };
+
+  /**
+   * RequestThrottle decides how often and how much the device may send to the Master node, and adjusts both to what the Master
+   * node says about its load:
+   *  - requests are limited by a token bucket holding up to `burst` tokens, refilled at `rate` tokens per second.  Each request
+   *    takes a token.
+   *  - SERVER_DOWN suspends sending until the recovery time the Master node sends in the body, in milliseconds, has passed.
+   *    Without a recovery time, sending is suspended for SERVER_DOWN_BACKOFF milliseconds, doubling with each consecutive
+   *    SERVER_DOWN.  Either way, up to RECOVERY_JITTER milliseconds are added at random so a fleet of devices told the same
+   *    recovery time does not return all at once, and the bucket is left with a single token so each device sends one request
+   *    to probe the Master node and then ramps back up at `rate` rather than replaying its backlog in a burst.
+   *  - REQUEST_TOO_LONG sets the request limit to the one the Master node sends in the body, in bytes, or to half the size of the
+   *    rejected request if there is none.  This limit is never raised again.
+   *  - REQUEST_TIMEOUT halves the request limit as well, since a smaller request is sent sooner.  A timeout is usually caused by
+   *    a slow link rather than the Master node, so this limit is doubled again after every REQUEST_LIMIT_RECOVERY successful
+   *    requests in a row until it is back to the size of the request that timed out.
+   * The owner splits what it sends to fit the lower of the two request limits.
+   *
+   * The owner checks `ready()` before preparing a request, calls `take()` when it sends one, and passes every response to
+   * `observe()`.
+   */
+  class RequestThrottle {
+    public:
+      /**
+       * Creates a new RequestThrottle with a full bucket.
+       *
+       * @param rate (const unsigned int) _optional_ - the number of requests per second allowed on average.  Default: THROTTLE_RATE
+       * @param burst (const unsigned int) _optional_ - the number of requests allowed back to back.  Default: THROTTLE_BURST
+       */
+      RequestThrottle(const unsigned int rate = THROTTLE_RATE, const unsigned int burst = THROTTLE_BURST);
+      ~RequestThrottle();
+
+      /**
+       * Checks whether a request may be sent now.
+       *
+       * @return (bool) true iff sending is not suspended and a token is available
+       */
+      bool ready() const;
+
+      /**
+       * Takes a token for a request about to be sent.
+       *
+       * @return (bool) true iff the request may be sent; otherwise, no token is taken
+       */
+      bool take();
+
+      /**
+       * Adjusts the throttle to a response from the Master node.
+       *
+       * @param response (const DCPResponse &) - the response
+       * @param bytes (const unsigned int) - the size, in bytes, of the body of the request or 0 if it is not known
+       */
+      void observe(const DCPResponse &response, const unsigned int bytes);
+
+      /**
+       * Checks whether sending is suspended because the Master node is down.
+       *
+       * @return (bool) true iff sending is suspended
+       */
+      bool isSuspended() const;
+
+      /**
+       * Returns the largest request body that should be sent: the lower of the limit set by REQUEST_TOO_LONG and the limit set
+       * by REQUEST_TIMEOUT.
+       *
+       * @return (unsigned int) the limit, in bytes, or 0 if there is none
+       */
+      unsigned int getRequestLimit() const;
+
+      /**
+       * Changes the rate limit.  The tokens already in the bucket are kept, up to the new burst.
+       *
+       * @param rate (const unsigned int) - the number of requests per second allowed on average
+       * @param burst (const unsigned int) - the number of requests allowed back to back
+       */
+      void setRate(const unsigned int rate, const unsigned int burst);
+
+      /**
+       * Returns the throttle statistics.
+       *
+       * @return (const ThrottleStats &) the throttle statistics
+       */
+      const ThrottleStats &getStats() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_REQUESTTHROTTLE */
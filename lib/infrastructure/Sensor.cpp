@@ -0,0 +1,45 @@
+/*
+ * Sensor.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stddef.h>
+
+#include "Sensor.h"
+
+Sensor::Sensor(const SensorType type, const SensorMode mode, const int pin, const unsigned long period): type(type), mode(mode), pin(pin), period(period) {
+  id = 0;
+  filter = NULL;
+}
+
+SensorType Sensor::getType() const {
+  return type;
+}
+
+SensorMode Sensor::getMode() const {
+  return mode;
+}
+
+int Sensor::getPin() const {
+  return pin;
+}
+
+unsigned long Sensor::getPeriod() const {
+  return period;
+}
+
+int Sensor::getId() const {
+  return id;
+}
+
+void Sensor::setId(int id) {
+  this->id = id;
+}
+
+InputFilter *Sensor::getFilter() const {
+  return filter;
+}
+
+void Sensor::setFilter(InputFilter *filter) {
+  this->filter = filter;
+}
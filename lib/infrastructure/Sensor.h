@@ -0,0 +1,155 @@
+/*
+ * Sensor.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_SENSOR
+  #define _C1MOORE_INFRASTRUCTURE_SENSOR
+
+  #include <stdint.h>
+
+  #include "InputFilter.h"
+  #include "SensorType.h"
+
+  /**
+   * SensorMode enumerates how a Sensor's input is read.
+   */
+  enum SensorMode {
+    SENSOR_INTERRUPT, // The Sensor is notified of each edge on its pin as captured by the interrupt layer.
+    SENSOR_POLLED     // The Sensor is sampled at a regular period.
+  };
+
+  /**
+   * SensorEdge represents a single edge on a pin as captured by the interrupt layer.
+   */
+  struct SensorEdge {
+    uint32_t timestamp; // The time, in microseconds, the edge occurred.
+    uint8_t pin;        // The pin on which the edge occurred.
+    bool level;         // The level of the pin after the edge.
+  };
+
+  /**
+   * EdgeSource is the interface between the SensorRegistry and the MCU's interrupt layer.  It allows the SensorRegistry to
+   * remain independent of how interrupts are captured on a specific MCU.
+   */
+  class EdgeSource {
+    public:
+      EdgeSource() {}
+      virtual ~EdgeSource() {};
+
+      /**
+       * Removes up to maxEdges captured edges and copies them to edges, oldest first.
+       *
+       * @param edges (SensorEdge *) - a buffer with a capacity of at least maxEdges edges
+       * @param maxEdges (int) - the maximum number of edges to drain
+       *
+       * @return (int) the number of edges copied to edges
+       */
+      virtual int drain(SensorEdge *edges, int maxEdges) = 0;
+  };
+
+  /**
+   * Sensor is the base class for every sensor attached to the device.  Rather than each Sensor being its own process, every
+   * Sensor is added to a SensorRegistry, which services all of them from a single process.  A Sensor is either
+   *  - interrupt-driven, in which case `onChange()` is called with each (filtered) change to its input, or
+   *  - polled, in which case `sample()` is called every `period` milliseconds.
+   * Subclasses should override the method corresponding to their mode.  Both methods should return quickly.
+   */
+  class Sensor {
+    public:
+      /**
+       * Creates a new Sensor.
+       *
+       * @param type (const SensorType) - the type of the sensor
+       * @param mode (const SensorMode) - how the sensor's input should be read
+       * @param pin (const int) - the pin to which the sensor is attached
+       * @param period (const unsigned long) _optional_ - for polled sensors, the number of milliseconds between samples.
+       *  Default: 0
+       */
+      Sensor(const SensorType type, const SensorMode mode, const int pin, const unsigned long period = 0);
+      virtual ~Sensor() {};
+
+      /**
+       * Returns the type of this Sensor.
+       *
+       * @return (SensorType) the type of this Sensor
+       */
+      SensorType getType() const;
+
+      /**
+       * Returns how this Sensor's input is read.
+       *
+       * @return (SensorMode) the mode of this Sensor
+       */
+      SensorMode getMode() const;
+
+      /**
+       * Returns the pin to which this Sensor is attached.
+       *
+       * @return (int) the pin to which this Sensor is attached
+       */
+      int getPin() const;
+
+      /**
+       * Returns the number of milliseconds between samples of a polled Sensor.
+       *
+       * @return (unsigned long) the sampling period
+       */
+      unsigned long getPeriod() const;
+
+      /**
+       * Returns the unique ID assigned to this Sensor by the Master node when it was registered.
+       *
+       * @return (int) the unique ID for this Sensor or 0 if it has not been registered
+       */
+      int getId() const;
+
+      /**
+       * Sets the unique ID assigned to this Sensor by the Master node.
+       *
+       * @param id (int) - the unique ID for this Sensor
+       */
+      void setId(int id);
+
+      /**
+       * Returns the filter applied to edges of an interrupt-driven Sensor, if any.
+       *
+       * @return (InputFilter *) the filter for this Sensor or NULL if edges are not filtered
+       */
+      InputFilter *getFilter() const;
+
+      /**
+       * Sets the filter applied to edges of an interrupt-driven Sensor.
+       *
+       * @param filter (InputFilter *) - the filter for this Sensor or NULL to stop filtering edges
+       */
+      void setFilter(InputFilter *filter);
+
+      /**
+       * Called when the input of an interrupt-driven Sensor changes.  If the Sensor has a filter, this is only called for changes
+       * reported by the filter.
+       *
+       * @param timestamp (uint32_t) - the time, in microseconds, of the change
+       * @param change (FilterResult) - the change to the input.  This is never FILTER_NONE.
+       */
+      virtual void onChange(uint32_t timestamp, FilterResult change) {}
+
+      /**
+       * Called when a polled Sensor should be sampled.
+       *
+       * @param now (unsigned long) - the current time, in milliseconds
+       */
+      virtual void sample(unsigned long now) {}
+
+    private:
+      const SensorType type;
+      const SensorMode mode;
+      const int pin;
+      const unsigned long period;
+
+      int id;
+      InputFilter *filter;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_SENSOR */
@@ -0,0 +1,141 @@
+/*
+ * SensorRegistry.cpp
+ *
+ *      Author: c1moore
+ */
+#include <Arduino.h>
+
+#include "SensorRegistry.h"
+
+class SensorRegistry::Implementation {
+  public:
+    Coordinator &coordinator;
+    EdgeSource &edges;
+
+    Sensor *sensors[MAX_SENSORS] = { NULL };          // Every Sensor in the registry.
+    Sensor *pinSensors[MAX_SENSOR_PINS] = { NULL };   // The interrupt-driven Sensor attached to each pin, if any.
+    unsigned long nextSample[MAX_SENSORS] = { 0 };    // The time, in milliseconds, each polled Sensor should next be sampled.
+    int sensorCount = 0;
+
+    Implementation(Coordinator &coordinator, EdgeSource &edges): coordinator(coordinator), edges(edges) {}
+
+    /**
+     * Drains every captured edge and passes each to the Sensor attached to its pin.
+     */
+    void serviceEdges() {
+      SensorEdge batch[SENSOR_EDGE_BATCH];
+      int edgeCount;
+
+      do {
+        edgeCount = edges.drain(batch, SENSOR_EDGE_BATCH);
+
+        for(int edgeIndex = 0; edgeIndex < edgeCount; edgeIndex++) {
+          const SensorEdge &edge = batch[edgeIndex];
+
+          if(edge.pin >= MAX_SENSOR_PINS || pinSensors[edge.pin] == NULL) {
+            continue;
+          }
+
+          Sensor *sensor = pinSensors[edge.pin];
+          InputFilter *filter = sensor->getFilter();
+          FilterResult change;
+
+          if(filter == NULL) {
+            change = edge.level ? FILTER_ON : FILTER_OFF;
+          } else {
+            change = filter->input(edge.timestamp, edge.level);
+          }
+
+          if(change != FILTER_NONE) {
+            sensor->onChange(edge.timestamp, change);
+          }
+        }
+      } while(edgeCount == SENSOR_EDGE_BATCH);
+    }
+
+    /**
+     * Confirms any pending filter transitions and samples every polled Sensor that is due.
+     */
+    void serviceSensors() {
+      const unsigned long now = millis();
+      const uint32_t nowMicros = micros();
+
+      for(int sensorIndex = 0; sensorIndex < sensorCount; sensorIndex++) {
+        Sensor *sensor = sensors[sensorIndex];
+
+        if(sensor->getMode() == SENSOR_INTERRUPT) {
+          InputFilter *filter = sensor->getFilter();
+
+          if(filter == NULL) {
+            continue;
+          }
+
+          FilterResult change = filter->update(nowMicros);
+
+          if(change != FILTER_NONE) {
+            sensor->onChange(nowMicros, change);
+          }
+
+          continue;
+        }
+
+        if((long) (now - nextSample[sensorIndex]) < 0) {
+          continue;
+        }
+
+        nextSample[sensorIndex] = now + sensor->getPeriod();
+        sensor->sample(now);
+      }
+    }
+};
+
+SensorRegistry::SensorRegistry(Coordinator &coordinator, EdgeSource &edges) {
+  implementation = new Implementation(coordinator, edges);
+}
+
+SensorRegistry::~SensorRegistry() {
+  delete implementation;
+}
+
+int SensorRegistry::add(Sensor &sensor) {
+  if(implementation->sensorCount >= MAX_SENSORS) {
+    return -1;
+  }
+
+  const int pin = sensor.getPin();
+  const bool interrupt = (sensor.getMode() == SENSOR_INTERRUPT);
+
+  if(interrupt && (pin < 0 || pin >= MAX_SENSOR_PINS || implementation->pinSensors[pin] != NULL)) {
+    return -2;
+  }
+
+  // The Sensor only joins the registry once it has an ID, so a Sensor the Master node cannot know about is never serviced and
+  // leaves its pin free.
+  const int id = implementation->coordinator.registerSensor(sensor.getType());
+
+  if(id < 0) {
+    return -3;
+  }
+
+  sensor.setId(id);
+
+  if(interrupt) {
+    implementation->pinSensors[pin] = &sensor;
+  }
+
+  implementation->nextSample[implementation->sensorCount] = millis();
+  implementation->sensors[implementation->sensorCount++] = &sensor;
+
+  return id;
+}
+
+int SensorRegistry::count() const {
+  return implementation->sensorCount;
+}
+
+int SensorRegistry::run() {
+  implementation->serviceEdges();
+  implementation->serviceSensors();
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * SensorRegistry.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_SENSORREGISTRY
+  #define _C1MOORE_INFRASTRUCTURE_SENSORREGISTRY
+
+  #include "../scheduler/Runnable.h"
+  #include "Coordinator.h"
+  #include "Sensor.h"
+
+  // The maximum number of Sensors that can be added to a SensorRegistry.
+  #define MAX_SENSORS       16
+
+  // The number of pins that can have an interrupt-driven Sensor attached.
+  #define MAX_SENSOR_PINS   32
+
+  // The maximum number of edges handled in a single batch.
+  #define SENSOR_EDGE_BATCH 16
+
+  /**
+   * SensorRegistry services every Sensor on the device from a single process.  Each time it executes, the SensorRegistry
+   *  1. drains every edge captured by the interrupt layer and passes each to the interrupt-driven Sensor on that pin (through
+   *     the Sensor's filter, if any),
+   *  2. confirms pending filter transitions, and
+   *  3. samples every polled Sensor whose period has elapsed.
+   * This way, adding more Sensors does not add more processes to the Scheduler or more per-Sensor overhead.  The SensorRegistry
+   * should be scheduled to execute repeatedly, at least as often as the shortest sampling period.
+   */
+  class SensorRegistry: public Runnable {
+    public:
+      /**
+       * Creates a new SensorRegistry.
+       *
+       * @param coordinator (Coordinator &) - the Coordinator used to register Sensors with the Master node
+       * @param edges (EdgeSource &) - the source of edges captured by the interrupt layer
+       */
+      SensorRegistry(Coordinator &coordinator, EdgeSource &edges);
+      ~SensorRegistry();
+
+      /**
+       * Registers a Sensor with the Master node and adds it to this registry.  Only one interrupt-driven Sensor can be attached
+       * to each pin.  A Sensor that cannot be registered is not added.
+       *
+       * @param sensor (Sensor &) - the Sensor to add
+       *
+       * @return (int) the unique ID assigned to the Sensor if it was added; -1 if MAX_SENSORS Sensors have been added; -2 if the
+       *  pin is invalid or already has an interrupt-driven Sensor; -3 if the Sensor could not be registered
+       */
+      int add(Sensor &sensor);
+
+      /**
+       * Returns the total number of Sensors added to this registry.
+       *
+       * @return (int) the total number of Sensors
+       */
+      int count() const;
+
+      /**
+       * Services every Sensor once.
+       *
+       * @return (int) 0
+       */
+      int run();
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_SENSORREGISTRY */
@@ -9,7 +9,11 @@
   #define _C1MOORE_INFRASTRUCTURE_SENSORTYPE
 
   enum SensorType {
-    INFRARED_MOTION
+    INFRARED_MOTION,
+    AMBIENT_LIGHT,
+    TEMPERATURE,
+    DOOR_CONTACT,
+    ZONE_OCCUPANCY
   };
 
 #endif /* _C1MOORE_INFRASTRUCTURE_SENSORTYPE */
@@ -0,0 +1,87 @@
+/*
+ * SocketInterest.cpp
+ *
+ *      Author: c1moore
+ */
+#ifndef ARDUINO
+  #include <poll.h>
+  #include <stddef.h>
+
+  #include "../scheduler/Scheduler.h"
+  #include "SocketInterest.h"
+
+  // Every SocketInterest created on this thread.  Each Scheduler polls the conditions of its waiting processes on its own thread.
+  static thread_local SocketInterest *interests = NULL;
+
+  // The Scheduler whose pass the events of every SocketInterest on this thread were last checked in.
+  static thread_local Scheduler *polledScheduler = NULL;
+
+  SocketInterest::SocketInterest(const int fd, const SocketEvent event): fd(fd), event(event), previous(NULL), next(interests),
+      pass(-1), occurred(false) {
+    if(interests != NULL) {
+      interests->previous = this;
+    }
+
+    interests = this;
+  }
+
+  SocketInterest::~SocketInterest() {
+    if(previous != NULL) {
+      previous->next = next;
+    } else {
+      interests = next;
+    }
+
+    if(next != NULL) {
+      next->previous = previous;
+    }
+  }
+
+  bool SocketInterest::poll() {
+    Scheduler &scheduler = Scheduler::current();
+    const long currentPass = scheduler.getPollPass();
+
+    if(currentPass < 0) {
+      // The Scheduler is not polling its waiting processes, so no other socket is about to be checked.
+      check(this, 1);
+    } else if(polledScheduler != &scheduler || pass != currentPass) {
+      check(interests, -1);
+
+      for(SocketInterest *interest = interests; interest != NULL; interest = interest->next) {
+        interest->pass = currentPass;
+      }
+
+      polledScheduler = &scheduler;
+    }
+
+    return occurred;
+  }
+
+  void SocketInterest::check(SocketInterest *first, int count) {
+    struct pollfd descriptors[SOCKET_POLL_BATCH];
+    SocketInterest *batch[SOCKET_POLL_BATCH];
+    SocketInterest *interest = first;
+
+    // Sockets are checked SOCKET_POLL_BATCH at a time, so more than that take more than one call.
+    while(interest != NULL && count != 0) {
+      int batchSize = 0;
+
+      for(; interest != NULL && count != 0 && batchSize < SOCKET_POLL_BATCH; interest = interest->next, count--) {
+        descriptors[batchSize].fd = interest->fd;
+        descriptors[batchSize].events = (interest->event == SOCKET_READABLE) ? POLLIN : POLLOUT;
+        descriptors[batchSize].revents = 0;
+
+        batch[batchSize++] = interest;
+      }
+
+      const int result = ::poll(descriptors, batchSize, 0);
+
+      for(int index = 0; index < batchSize; index++) {
+        // Errors and hang ups are reported as the event so the waiting process can find out what happened.
+        const short revents = (result > 0) ? descriptors[index].revents : 0;
+
+        batch[index]->occurred = (revents & (descriptors[index].events | POLLERR | POLLHUP)) != 0;
+      }
+    }
+  }
+#endif
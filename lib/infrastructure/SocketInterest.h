@@ -0,0 +1,71 @@
+/*
+ * SocketInterest.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_SOCKETINTEREST
+  #define _C1MOORE_INFRASTRUCTURE_SOCKETINTEREST
+
+  #ifndef ARDUINO
+    #include "../scheduler/Pollable.h"
+
+    // The most sockets checked by a single poll(2).
+    #ifndef SOCKET_POLL_BATCH
+      #define SOCKET_POLL_BATCH 64
+    #endif
+
+    /**
+     * SocketEvent enumerates the events of a POSIX socket a process can wait on.
+     */
+    enum SocketEvent {
+      SOCKET_READABLE,  // The socket has received data that can be read or the connection has been closed.
+      SOCKET_WRITABLE   // The socket can accept more data to send.  For a connecting socket, the connection has completed.
+    };
+
+    /**
+     * SocketInterest is the host counterpart of ClientInterest.  It registers interest in an event of a POSIX socket so a
+     * process can wait for the event using `Scheduler::await()`.  The socket is checked using poll(2) without blocking.
+     *
+     * While the Scheduler polls the conditions of its waiting processes, the first SocketInterest polled checks the sockets of
+     * every SocketInterest on the thread with a single poll(2), and the rest of the pass uses the result (see
+     * `Scheduler::getPollPass()`).  A simulation waiting on many sockets thus makes one system call per pass rather than one per
+     * socket.  A SocketInterest must be destroyed on the thread that created it and cannot be copied.
+     *
+     * This is only available when building for a host (i.e. ARDUINO is not defined), such as when simulating devices.
+     */
+    class SocketInterest: public Pollable {
+      public:
+        SocketInterest(const int fd, const SocketEvent event);
+        ~SocketInterest();
+
+        SocketInterest(SocketInterest const &interest) = delete;
+        void operator=(SocketInterest const &interest) = delete;
+
+        /**
+         * Checks whether the event has occurred.
+         *
+         * @return (bool) true iff the event has occurred
+         */
+        bool poll();
+
+      private:
+        /**
+         * Checks the sockets of `count` SocketInterests, starting with `first`, and records which events occurred.
+         *
+         * @param first (SocketInterest *) - the first SocketInterest to check
+         * @param count (int) - the number of SocketInterests to check or a negative value to check every one after `first`
+         */
+        static void check(SocketInterest *first, int count);
+
+        const int fd;
+        const SocketEvent event;
+
+        SocketInterest *previous;   // The previous SocketInterest created on this thread.
+        SocketInterest *next;       // The next SocketInterest created on this thread.
+        long pass;                  // The pass of the Scheduler in which the socket was last checked along with the others.
+        bool occurred;              // true iff the event had occurred when the socket was last checked.
+    };
+  #endif
+
+#endif /* _C1MOORE_INFRASTRUCTURE_SOCKETINTEREST */
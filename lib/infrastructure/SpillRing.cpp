@@ -0,0 +1,190 @@
+/*
+ * SpillRing.cpp
+ *
+ *      Author: c1moore
+ */
+#include <EEPROM.h>
+
+#include "PersistentDID.h"
+#include "SpillRing.h"
+
+#define SPILL_MAGIC_NUMBER  0x5b
+#define SPILL_RECORD_HEADER 3   // A record starts with its sub device ID (2 bytes) and data length (1 byte).
+
+/**
+ * SpillHeader describes the contents of the ring.  It is stored at the start of the region.
+ */
+struct SpillHeader {
+  uint8_t magicNumber;
+  uint8_t checksum;
+
+  uint16_t head;  // The offset of the oldest record in the data area.
+  uint16_t used;  // The number of bytes used by records.
+  uint16_t count; // The number of records.
+};
+
+class SpillRing::Implementation {
+  public:
+    const int headerAddr;
+    const int dataAddr;
+    const int capacity;   // The number of bytes in the data area.
+
+    SpillHeader header;
+    bool dirty = false;
+
+    Implementation(const int startAddr, const int size): headerAddr(startAddr), dataAddr(startAddr + sizeof(SpillHeader)),
+        capacity(size > (int) sizeof(SpillHeader) ? size - sizeof(SpillHeader) : 0) {
+      clear();
+    }
+
+    /**
+     * Empties the ring.
+     */
+    void clear() {
+      header.magicNumber = SPILL_MAGIC_NUMBER;
+      header.head = 0;
+      header.used = 0;
+      header.count = 0;
+    }
+
+    /**
+     * Writes the header to EEPROM.
+     */
+    void writeHeader() {
+      header.checksum = 0;
+      header.checksum = persistentChecksum(&header, sizeof(header));
+
+      EEPROM.put(headerAddr, header);
+
+      dirty = true;
+    }
+
+    /**
+     * Reads a byte of the data area.
+     *
+     * @param offset (const int) - the offset of the byte, relative to the oldest record
+     *
+     * @return (uint8_t) the byte
+     */
+    uint8_t read(const int offset) const {
+      return EEPROM.read(dataAddr + (header.head + offset) % capacity);
+    }
+
+    /**
+     * Writes a byte of the data area.
+     *
+     * @param offset (const int) - the offset of the byte, relative to the oldest record
+     * @param value (const uint8_t) - the byte to write
+     */
+    void write(const int offset, const uint8_t value) {
+      EEPROM.write(dataAddr + (header.head + offset) % capacity, value);
+    }
+};
+
+SpillRing::SpillRing(const int startAddr, const int size) {
+  implementation = new Implementation(startAddr, size);
+}
+
+SpillRing::~SpillRing() {
+  delete implementation;
+}
+
+int SpillRing::begin() {
+  // A ring without room for records does not own any EEPROM, not even for its header.
+  if(implementation->capacity == 0) {
+    return 0;
+  }
+
+  SpillHeader stored;
+
+  EEPROM.get(implementation->headerAddr, stored);
+
+  const uint8_t checksum = stored.checksum;
+  stored.checksum = 0;
+
+  if(stored.magicNumber != SPILL_MAGIC_NUMBER || checksum != persistentChecksum(&stored, sizeof(stored)) ||
+      stored.head >= implementation->capacity || stored.used > implementation->capacity) {
+    implementation->clear();
+    implementation->writeHeader();
+
+    return 0;
+  }
+
+  implementation->header = stored;
+
+  return stored.count;
+}
+
+bool SpillRing::push(uint16_t subDeviceId, const String &data) {
+  const int length = data.length();
+
+  if(length > SPILL_MAX_DATA || implementation->header.used + SPILL_RECORD_HEADER + length > implementation->capacity) {
+    return false;
+  }
+
+  const int offset = implementation->header.used;
+
+  implementation->write(offset, subDeviceId & 0xff);
+  implementation->write(offset + 1, subDeviceId >> 8);
+  implementation->write(offset + 2, length);
+
+  for(int index = 0; index < length; index++) {
+    implementation->write(offset + SPILL_RECORD_HEADER + index, data[index]);
+  }
+
+  implementation->header.used += SPILL_RECORD_HEADER + length;
+  implementation->header.count++;
+  implementation->writeHeader();
+
+  return true;
+}
+
+bool SpillRing::peek(uint16_t &subDeviceId, String &data) const {
+  if(implementation->header.count == 0) {
+    return false;
+  }
+
+  subDeviceId = implementation->read(0) | (implementation->read(1) << 8);
+
+  const int length = implementation->read(2);
+
+  data = String();
+  data.reserve(length);
+
+  for(int index = 0; index < length; index++) {
+    data += (char) implementation->read(SPILL_RECORD_HEADER + index);
+  }
+
+  return true;
+}
+
+void SpillRing::pop() {
+  SpillHeader &header = implementation->header;
+
+  if(header.count == 0) {
+    return;
+  }
+
+  const int recordSize = SPILL_RECORD_HEADER + implementation->read(2);
+
+  header.head = (header.head + recordSize) % implementation->capacity;
+  header.used -= recordSize;
+  header.count--;
+
+  implementation->writeHeader();
+}
+
+int SpillRing::count() const {
+  return implementation->header.count;
+}
+
+bool SpillRing::sync() {
+  if(!implementation->dirty) {
+    return false;
+  }
+
+  EEPROM.commit();
+  implementation->dirty = false;
+
+  return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * SpillRing.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_SPILLRING
+  #define _C1MOORE_INFRASTRUCTURE_SPILLRING
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+
+  // The longest update data, in bytes, that can be spilled.
+  #define SPILL_MAX_DATA 255
+
+  /**
+   * A SpillRing is a FIFO of updates stored in a region of EEPROM.  It holds the updates that do not fit in RAM while the Master
+   * node is unreachable, and because it is persistent, those updates survive a restart.
+   *
+   * On the ESP8266, EEPROM is emulated by a RAM buffer that is written to flash by `EEPROM.commit()`.  Every commit erases a flash
+   * sector, so changes are only committed when `sync()` is called.  The caller decides how often that is, trading flash wear
+   * against how many updates can be lost to a power failure.  `EEPROM.begin()` must be called before the SpillRing is used.
+   */
+  class SpillRing {
+    public:
+      /**
+       * Creates a SpillRing in the specified region of EEPROM.  The ring is not usable until `begin()` is called.
+       *
+       * @param startAddr (const int) - the address of the first byte of the region
+       * @param size (const int) - the number of bytes in the region, including a small header
+       */
+      SpillRing(const int startAddr, const int size);
+      ~SpillRing();
+
+      /**
+       * Recovers the updates stored by a previous run.  If the region does not hold a valid ring, the ring is emptied.
+       *
+       * @return (int) the number of updates recovered
+       */
+      int begin();
+
+      /**
+       * Adds an update to the end of the ring.
+       *
+       * @param subDeviceId (uint16_t) - the unique ID of the sub device that sent the update
+       * @param data (const String &) - the data of the update
+       *
+       * @return (bool) true iff the update was added; false if the ring is full or the data is longer than SPILL_MAX_DATA
+       */
+      bool push(uint16_t subDeviceId, const String &data);
+
+      /**
+       * Reads the oldest update in the ring without removing it.
+       *
+       * @param subDeviceId (uint16_t &) - set to the unique ID of the sub device that sent the update
+       * @param data (String &) - set to the data of the update
+       *
+       * @return (bool) true iff there was an update to read
+       */
+      bool peek(uint16_t &subDeviceId, String &data) const;
+
+      /**
+       * Removes the oldest update from the ring.
+       */
+      void pop();
+
+      /**
+       * Returns the number of updates in the ring.
+       *
+       * @return (int) the number of updates in the ring
+       */
+      int count() const;
+
+      /**
+       * Writes any changes to flash.
+       *
+       * @return (bool) true iff there were changes to write
+       */
+      bool sync();
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_SPILLRING */
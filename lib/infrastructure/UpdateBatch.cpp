@@ -0,0 +1,141 @@
+/*
+ * UpdateBatch.cpp
+ *
+ *      Author: c1moore
+ */
+#include "UpdateBatch.h"
+
+/**
+ * BatchRecord is the latest update of a single sub device.
+ */
+struct BatchRecord {
+  uint16_t subDeviceId; // The unique ID of the sub device.
+  String data;          // The data of the latest update.
+};
+
+class UpdateBatch::Implementation {
+  public:
+    BatchRecord records[MAX_BATCH_RECORDS];
+    int recordCount = 0;
+
+    unsigned int bytes = 0;       // The size of the encoded batch.
+    unsigned long firstAdded = 0; // The time, in milliseconds, the oldest update was added.
+
+    /**
+     * Returns the size of a record once encoded.
+     *
+     * @param record (const BatchRecord &) - the record
+     *
+     * @return (unsigned int) the size of the encoded record
+     */
+    static unsigned int encodedSize(const BatchRecord &record) {
+      return String((unsigned int) record.subDeviceId).length() + 1 + String(record.data.length()).length() + 1 + record.data.length();
+    }
+
+    /**
+     * Finds the record of a sub device.
+     *
+     * @param subDeviceId (uint16_t) - the unique ID of the sub device
+     *
+     * @return (int) the index of the record or -1 if the sub device has no record in the batch
+     */
+    int find(uint16_t subDeviceId) const {
+      for(int index = 0; index < recordCount; index++) {
+        if(records[index].subDeviceId == subDeviceId) {
+          return index;
+        }
+      }
+
+      return -1;
+    }
+};
+
+UpdateBatch::UpdateBatch() {
+  implementation = new Implementation();
+}
+
+UpdateBatch::~UpdateBatch() {
+  delete implementation;
+}
+
+int UpdateBatch::add(uint16_t subDeviceId, const String &data) {
+  const int index = implementation->find(subDeviceId);
+
+  if(index >= 0) {
+    BatchRecord &record = implementation->records[index];
+
+    implementation->bytes -= Implementation::encodedSize(record);
+    record.data = data;
+    implementation->bytes += Implementation::encodedSize(record);
+
+    return 1;
+  }
+
+  if(implementation->recordCount >= MAX_BATCH_RECORDS) {
+    return -1;
+  }
+
+  if(implementation->recordCount == 0) {
+    implementation->firstAdded = millis();
+  }
+
+  BatchRecord &record = implementation->records[implementation->recordCount++];
+
+  record.subDeviceId = subDeviceId;
+  record.data = data;
+
+  implementation->bytes += Implementation::encodedSize(record);
+
+  return 0;
+}
+
+int UpdateBatch::count() const {
+  return implementation->recordCount;
+}
+
+unsigned int UpdateBatch::bytes() const {
+  return implementation->bytes;
+}
+
+unsigned long UpdateBatch::age() const {
+  if(implementation->recordCount == 0) {
+    return 0;
+  }
+
+  return millis() - implementation->firstAdded;
+}
+
+uint16_t UpdateBatch::getSubDeviceId(int index) const {
+  return implementation->records[index].subDeviceId;
+}
+
+const String &UpdateBatch::getData(int index) const {
+  return implementation->records[index].data;
+}
+
+String UpdateBatch::encode() const {
+  String encoded;
+  encoded.reserve(implementation->bytes);
+
+  for(int index = 0; index < implementation->recordCount; index++) {
+    const BatchRecord &record = implementation->records[index];
+
+    encoded += String((unsigned int) record.subDeviceId);
+    encoded += ':';
+    encoded += String(record.data.length());
+    encoded += '\n';
+    encoded += record.data;
+  }
+
+  return encoded;
+}
+
+void UpdateBatch::clear() {
+  for(int index = 0; index < implementation->recordCount; index++) {
+    // Release the memory held by the data now rather than when the record is reused.
+    implementation->records[index].data = String();
+  }
+
+  implementation->recordCount = 0;
+  implementation->bytes = 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * UpdateBatch.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_UPDATEBATCH
+  #define _C1MOORE_INFRASTRUCTURE_UPDATEBATCH
+
+  #include <stdint.h>
+
+  #include <Arduino.h>
+
+  // The maximum number of sub devices whose updates can be collected in one batch.
+  #ifndef MAX_BATCH_RECORDS
+    #define MAX_BATCH_RECORDS 16
+  #endif
+
+  /**
+   * BatchStats describes the tradeoff made by batching: fewer, larger requests in exchange for holding updates back.
+   */
+  struct BatchStats {
+    unsigned long batches;      // The number of batches sent.
+    unsigned long records;      // The number of records sent in those batches.
+    unsigned long merged;       // The number of updates that replaced an earlier update to the same sub device.
+    unsigned long bytes;        // The number of body bytes sent in those batches.
+    unsigned int maxRecords;    // The most records sent in a single batch.
+    unsigned long totalDelay;   // The sum of the time, in milliseconds, each batch held its oldest update.
+    unsigned long maxDelay;     // The longest time, in milliseconds, a batch held its oldest update.
+  };
+
+  /**
+   * An UpdateBatch collects the updates of several sub devices so they can be sent in a single DCP request.  Only the latest
+   * update of each sub device is kept; an update to a sub device that is already in the batch replaces the earlier one.  The
+   * batch is encoded as a sequence of records, one per sub device:
+   *
+   *    SUBDEVICE_ID:LENGTH
+   *    DATA
+   *
+   * LENGTH is the number of bytes in DATA, which is not followed by a newline.  The next record starts immediately after it.
+   */
+  class UpdateBatch {
+    public:
+      UpdateBatch();
+      ~UpdateBatch();
+
+      /**
+       * Adds an update to the batch.
+       *
+       * @param subDeviceId (uint16_t) - the unique ID of the sub device sending the update
+       * @param data (const String &) - the data of the update
+       *
+       * @return (int) 0 if the update was added; 1 if it replaced an earlier update to the same sub device; -1 if the batch is
+       *  full
+       */
+      int add(uint16_t subDeviceId, const String &data);
+
+      /**
+       * Returns the number of records in the batch.
+       *
+       * @return (int) the number of records in the batch
+       */
+      int count() const;
+
+      /**
+       * Returns the number of bytes the batch will take once encoded.
+       *
+       * @return (unsigned int) the size of the encoded batch
+       */
+      unsigned int bytes() const;
+
+      /**
+       * Returns how long the oldest update in the batch has been waiting.
+       *
+       * @return (unsigned long) the time, in milliseconds, since the first update was added or 0 if the batch is empty
+       */
+      unsigned long age() const;
+
+      /**
+       * Returns the sub device of a record.
+       *
+       * @param index (int) - the index of the record
+       *
+       * @return (uint16_t) the unique ID of the sub device
+       */
+      uint16_t getSubDeviceId(int index) const;
+
+      /**
+       * Returns the data of a record.
+       *
+       * @param index (int) - the index of the record
+       *
+       * @return (const String &) the data of the record
+       */
+      const String &getData(int index) const;
+
+      /**
+       * Encodes every record in the batch.
+       *
+       * @return (String) the encoded batch
+       */
+      String encode() const;
+
+      /**
+       * Removes every record from the batch.
+       */
+      void clear();
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_UPDATEBATCH */
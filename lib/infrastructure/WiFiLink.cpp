@@ -0,0 +1,226 @@
+/*
+ * WiFiLink.cpp
+ *
+ *      Author: c1moore
+ */
+#include <EEPROM.h>
+
+#include "BootTimeline.h"
+#include "PersistentDID.h"
+#include "WiFiLink.h"
+
+#define WIFI_CACHE_MAGIC_NUMBER 0x3c
+
+/**
+ * WiFiCache holds the details needed to rejoin the network without scanning or DHCP.
+ */
+struct WiFiCache {
+  uint8_t magicNumber;
+  uint8_t checksum;
+
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t padding;
+
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
+class WiFiLink::Implementation {
+  public:
+    const char *ssid;
+    const char *password;
+    const int cacheAddr;
+
+    WiFiLinkState state = LINK_IDLE;
+
+    unsigned long attemptStart = 0;   // The time, in milliseconds, the current attempt started.
+    unsigned long backoffDelay = 0;   // The length, in milliseconds, of the current backoff.
+    int failures = 0;                 // The number of consecutive failed attempts.
+
+    unsigned long joinTime = 0;
+    bool fromCache = false;
+
+    Implementation(const char *ssid, const char *password, const int cacheAddr): ssid(ssid), password(password), cacheAddr(cacheAddr) {}
+
+    /**
+     * Reads the cached connection details.
+     *
+     * @param cache (WiFiCache &) - set to the cached connection details
+     *
+     * @return (bool) true iff valid connection details were cached
+     */
+    bool readCache(WiFiCache &cache) const {
+      EEPROM.get(cacheAddr, cache);
+
+      const uint8_t checksum = cache.checksum;
+      cache.checksum = 0;
+
+      return (cache.magicNumber == WIFI_CACHE_MAGIC_NUMBER && checksum == persistentChecksum(&cache, sizeof(cache)));
+    }
+
+    /**
+     * Caches the details of the current connection.  Flash is only written if they changed.
+     */
+    void writeCache() {
+      WiFiCache cache;
+      memset(&cache, 0, sizeof(cache));
+
+      cache.magicNumber = WIFI_CACHE_MAGIC_NUMBER;
+      memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+      cache.channel = WiFi.channel();
+      cache.ip = WiFi.localIP();
+      cache.gateway = WiFi.gatewayIP();
+      cache.subnet = WiFi.subnetMask();
+      cache.dns = WiFi.dnsIP();
+      cache.checksum = persistentChecksum(&cache, sizeof(cache));
+
+      WiFiCache cached;
+      EEPROM.get(cacheAddr, cached);
+
+      if(memcmp(&cache, &cached, sizeof(cache)) == 0) {
+        return;
+      }
+
+      EEPROM.put(cacheAddr, cache);
+      EEPROM.commit();
+    }
+
+    /**
+     * Joins the cached access point with the cached IP configuration if the cache is valid; otherwise, starts a full attempt.
+     */
+    void joinFromCache() {
+      WiFiCache cache;
+
+      if(!readCache(cache)) {
+        join();
+
+        return;
+      }
+
+      WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+      WiFi.begin(ssid, password, cache.channel, cache.bssid);
+
+      attemptStart = millis();
+      state = LINK_FAST;
+    }
+
+    /**
+     * Scans for the network and requests an IP lease.
+     */
+    void join() {
+      // Clearing the static configuration turns DHCP back on.
+      WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u));
+      WiFi.begin(ssid, password);
+
+      attemptStart = millis();
+      state = LINK_JOINING;
+    }
+
+    /**
+     * Waits before trying again.  The delay doubles with each consecutive failure up to WIFI_BACKOFF_MAX.
+     */
+    void backoff() {
+      backoffDelay = WIFI_BACKOFF_MAX;
+
+      if(failures < 16 && (1000UL << failures) < WIFI_BACKOFF_MAX) {
+        backoffDelay = 1000UL << failures;
+      }
+
+      failures++;
+
+      attemptStart = millis();
+      state = LINK_BACKOFF;
+    }
+
+    /**
+     * Records a successful attempt.
+     */
+    void connected() {
+      joinTime = millis() - attemptStart;
+      fromCache = (state == LINK_FAST);
+      failures = 0;
+
+      state = LINK_CONNECTED;
+
+      recordBootEvent(BOOT_WIFI_CONNECTED);
+      writeCache();
+    }
+};
+
+WiFiLink::WiFiLink(const char *ssid, const char *password, const int cacheAddr) {
+  implementation = new Implementation(ssid, password, cacheAddr);
+}
+
+WiFiLink::~WiFiLink() {
+  delete implementation;
+}
+
+void WiFiLink::begin() {
+  // The connection details are cached by the WiFiLink; the SDK does not need to write them to flash as well.
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+
+  implementation->joinFromCache();
+}
+
+int WiFiLink::run() {
+  const wl_status_t status = WiFi.status();
+  const unsigned long elapsed = millis() - implementation->attemptStart;
+
+  switch(implementation->state) {
+    case LINK_IDLE:
+      break;
+
+    case LINK_FAST:
+      if(status == WL_CONNECTED) {
+        implementation->connected();
+      } else if(elapsed >= FAST_CONNECT_TIMEOUT) {
+        implementation->join();
+      }
+      break;
+
+    case LINK_JOINING:
+      if(status == WL_CONNECTED) {
+        implementation->connected();
+      } else if(status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL || elapsed >= WIFI_ATTEMPT_TIMEOUT) {
+        implementation->backoff();
+      }
+      break;
+
+    case LINK_BACKOFF:
+      if(elapsed >= implementation->backoffDelay) {
+        implementation->join();
+      }
+      break;
+
+    case LINK_CONNECTED:
+      if(status != WL_CONNECTED) {
+        // The SDK reconnects on its own; only start over if it takes too long.
+        implementation->attemptStart = millis();
+        implementation->state = LINK_JOINING;
+      }
+      break;
+  }
+
+  return 0;
+}
+
+bool WiFiLink::isConnected() const {
+  return implementation->state == LINK_CONNECTED;
+}
+
+WiFiLinkState WiFiLink::getState() const {
+  return implementation->state;
+}
+
+unsigned long WiFiLink::getJoinTime() const {
+  return implementation->joinTime;
+}
+
+bool WiFiLink::joinedFromCache() const {
+  return implementation->fromCache;
+}
@@ -0,0 +1,113 @@
+/*
+ * WiFiLink.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_WIFILINK
+  #define _C1MOORE_INFRASTRUCTURE_WIFILINK
+
+  #include <Arduino.h>
+  #include <ESP8266WiFi.h>
+
+  #include "../scheduler/Runnable.h"
+
+  // How long, in milliseconds, to wait for the cached access point before falling back to a full scan and DHCP.
+  #ifndef FAST_CONNECT_TIMEOUT
+    #define FAST_CONNECT_TIMEOUT 2000
+  #endif
+
+  // How long, in milliseconds, to wait for a full connection attempt before starting over.
+  #ifndef WIFI_ATTEMPT_TIMEOUT
+    #define WIFI_ATTEMPT_TIMEOUT 15000
+  #endif
+
+  // The longest delay, in milliseconds, between failed connection attempts.
+  #ifndef WIFI_BACKOFF_MAX
+    #define WIFI_BACKOFF_MAX 30000
+  #endif
+
+  /**
+   * WiFiLinkState enumerates the states of a WiFiLink.
+   */
+  enum WiFiLinkState {
+    LINK_IDLE,        // `begin()` has not been called.
+    LINK_FAST,        // Joining the cached access point with the cached IP configuration.
+    LINK_JOINING,     // Scanning for the network and requesting an IP lease.
+    LINK_BACKOFF,     // The last attempt failed.  The next attempt will be made after a delay.
+    LINK_CONNECTED    // The device is on the network.
+  };
+
+  /**
+   * WiFiLink brings up and maintains the network connection as a scheduled process instead of blocking `setup()`, so sensors and
+   * local logic run while the network is still coming up.  The WiFiLink should be scheduled to execute periodically.
+   *
+   * Most of the time spent joining a network goes to scanning for the access point and waiting for a DHCP lease.  Once joined, the
+   * access point's BSSID and channel and the IP configuration are cached in EEPROM.  After a restart, such as after a power blip,
+   * the WiFiLink joins the cached access point directly with the cached IP configuration, skipping both.  If that does not succeed
+   * within FAST_CONNECT_TIMEOUT, e.g. because the access point changed channels, it falls back to a full scan and DHCP.  Reusing
+   * the cached IP configuration assumes the DHCP server keeps leases for longer than the device is off, which is true of most home
+   * routers.
+   *
+   * `EEPROM.begin()` must be called before `begin()`.
+   */
+  class WiFiLink: public Runnable {
+    public:
+      /**
+       * Creates a new WiFiLink.  Nothing happens until `begin()` is called.
+       *
+       * @param ssid (const char *) - the SSID of the network to join
+       * @param password (const char *) - the password of the network
+       * @param cacheAddr (const int) - the address in EEPROM where the connection details are cached
+       */
+      WiFiLink(const char *ssid, const char *password, const int cacheAddr);
+      ~WiFiLink();
+
+      /**
+       * Starts joining the network and returns immediately.
+       */
+      void begin();
+
+      /**
+       * Checks on the progress of joining the network, falling back or retrying as necessary, and rejoins if the connection is
+       * lost.
+       *
+       * @return (int) 0
+       */
+      int run();
+
+      /**
+       * Checks whether the device is on the network.
+       *
+       * @return (bool) true iff the device is on the network
+       */
+      bool isConnected() const;
+
+      /**
+       * Returns the current state of the WiFiLink.
+       *
+       * @return (WiFiLinkState) the current state
+       */
+      WiFiLinkState getState() const;
+
+      /**
+       * Returns how long the most recent successful attempt to join the network took.
+       *
+       * @return (unsigned long) the time, in milliseconds, the attempt took or 0 if the network has not been joined
+       */
+      unsigned long getJoinTime() const;
+
+      /**
+       * Returns whether the most recent successful attempt used the cached connection details.
+       *
+       * @return (bool) true iff the network was joined using the cache
+       */
+      bool joinedFromCache() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_WIFILINK */
@@ -0,0 +1,158 @@
+/*
+ * WindowedAggregate.cpp
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE_IMPLEMENTATION
+  #define _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE_IMPLEMENTATION
+
+  #include "../infrastructure/WindowedAggregate.h"
+
+  template<class T, int WINDOW>
+  WindowedAggregate<T, WINDOW>::WindowedAggregate(float smoothing): smoothing(smoothing) {
+    added = 0;
+    sum = T();
+
+    minHead = 0;
+    minCount = 0;
+    maxHead = 0;
+    maxCount = 0;
+
+    ema = 0;
+
+    hasThresholds = false;
+    low = 0;
+    high = 0;
+    above = false;
+  }
+
+  template<class T, int WINDOW>
+  CrossingResult WindowedAggregate<T, WINDOW>::add(const T sample) {
+    const unsigned long sampleNumber = added;
+
+    if(sampleNumber >= WINDOW) {
+      const unsigned long evicted = sampleNumber - WINDOW;
+
+      sum -= sampleAt(evicted);
+
+      // The evicted sample can only be at the front of either queue.
+      if(minCount && minQueue[minHead] == evicted) {
+        minHead = (minHead + 1) % WINDOW;
+        minCount--;
+      }
+
+      if(maxCount && maxQueue[maxHead] == evicted) {
+        maxHead = (maxHead + 1) % WINDOW;
+        maxCount--;
+      }
+    }
+
+    samples[sampleNumber % WINDOW] = sample;
+    sum += sample;
+    added++;
+
+    pushMin(sampleNumber);
+    pushMax(sampleNumber);
+
+    ema = (sampleNumber == 0) ? (float) sample : ema + smoothing * ((float) sample - ema);
+
+    if(!hasThresholds) {
+      return CROSSING_NONE;
+    }
+
+    if(!above && ema > high) {
+      above = true;
+
+      return CROSSING_RISE;
+    }
+
+    if(above && ema < low) {
+      above = false;
+
+      return CROSSING_FALL;
+    }
+
+    return CROSSING_NONE;
+  }
+
+  template<class T, int WINDOW>
+  void WindowedAggregate<T, WINDOW>::setThresholds(float low, float high) {
+    this->low = low;
+    this->high = high;
+
+    hasThresholds = true;
+    above = (added > 0 && ema > high);
+  }
+
+  template<class T, int WINDOW>
+  WindowSummary<T> WindowedAggregate<T, WINDOW>::summarize() const {
+    WindowSummary<T> summary;
+    const int sampleCount = count();
+
+    summary.count = sampleCount;
+    summary.ema = ema;
+
+    if(sampleCount == 0) {
+      summary.min = T();
+      summary.max = T();
+      summary.mean = 0;
+
+      return summary;
+    }
+
+    summary.min = sampleAt(minQueue[minHead]);
+    summary.max = sampleAt(maxQueue[maxHead]);
+    summary.mean = (float) sum / sampleCount;
+
+    return summary;
+  }
+
+  template<class T, int WINDOW>
+  bool WindowedAggregate<T, WINDOW>::isAbove() const {
+    return above;
+  }
+
+  template<class T, int WINDOW>
+  int WindowedAggregate<T, WINDOW>::count() const {
+    return (added < WINDOW) ? (int) added : WINDOW;
+  }
+
+  /**
+   * Returns the sample with the specified sample number.  The sample must still be in the window.
+   */
+  template<class T, int WINDOW>
+  T WindowedAggregate<T, WINDOW>::sampleAt(unsigned long sampleNumber) const {
+    return samples[sampleNumber % WINDOW];
+  }
+
+  /**
+   * Adds a sample to the back of the minimum queue, first removing every sample that can no longer be the minimum.
+   */
+  template<class T, int WINDOW>
+  void WindowedAggregate<T, WINDOW>::pushMin(unsigned long sampleNumber) {
+    const T sample = sampleAt(sampleNumber);
+
+    while(minCount && sampleAt(minQueue[(minHead + minCount - 1) % WINDOW]) >= sample) {
+      minCount--;
+    }
+
+    minQueue[(minHead + minCount) % WINDOW] = sampleNumber;
+    minCount++;
+  }
+
+  /**
+   * Adds a sample to the back of the maximum queue, first removing every sample that can no longer be the maximum.
+   */
+  template<class T, int WINDOW>
+  void WindowedAggregate<T, WINDOW>::pushMax(unsigned long sampleNumber) {
+    const T sample = sampleAt(sampleNumber);
+
+    while(maxCount && sampleAt(maxQueue[(maxHead + maxCount - 1) % WINDOW]) <= sample) {
+      maxCount--;
+    }
+
+    maxQueue[(maxHead + maxCount) % WINDOW] = sampleNumber;
+    maxCount++;
+  }
+#endif /* _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE_IMPLEMENTATION */
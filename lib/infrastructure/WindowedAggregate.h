@@ -0,0 +1,118 @@
+/*
+ * WindowedAggregate.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE
+  #define _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE
+
+  /**
+   * CrossingResult enumerates the threshold crossings a WindowedAggregate can detect.
+   */
+  enum CrossingResult {
+    CROSSING_NONE,  // No threshold was crossed.
+    CROSSING_RISE,  // The smoothed value rose above the high threshold.
+    CROSSING_FALL   // The smoothed value fell below the low threshold.
+  };
+
+  /**
+   * WindowSummary summarizes the samples in a WindowedAggregate's window.
+   */
+  template<class T>
+  struct WindowSummary {
+    T min;        // The smallest sample in the window.
+    T max;        // The largest sample in the window.
+    float mean;   // The mean of the samples in the window.
+    float ema;    // The exponential moving average of every sample added.
+    int count;    // The number of samples in the window.
+  };
+
+  /**
+   * A WindowedAggregate maintains statistics over a stream of samples in fixed memory.  The minimum, maximum, and mean are
+   * calculated over a sliding window of the last WINDOW samples, while the exponential moving average (EMA) covers every sample.
+   * Adding a sample takes amortized constant time and the memory used is fixed at compile time by WINDOW.
+   *
+   * The EMA is also used to detect threshold crossings.  The thresholds provide hysteresis: once the EMA rises above the high
+   * threshold, it must fall below the low threshold before another rise is detected, and vice versa.
+   *
+   * T must be a numeric type able to hold the sum of WINDOW samples.
+   */
+  template<class T, int WINDOW>
+  class WindowedAggregate {
+    public:
+      /**
+       * Creates a new WindowedAggregate.
+       *
+       * @param smoothing (float) _optional_ - the weight, between 0 and 1, of each new sample in the EMA.  Default: 0.1
+       */
+      WindowedAggregate(float smoothing = 0.1f);
+
+      /**
+       * Adds a sample to the window, evicting the oldest sample if the window is full.
+       *
+       * @param sample (const T) - the sample to add
+       *
+       * @return (CrossingResult) the threshold crossing caused by the sample, if any
+       */
+      CrossingResult add(const T sample);
+
+      /**
+       * Sets the thresholds used to detect crossings.  Threshold crossings are not detected until this method is called.
+       *
+       * @param low (float) - the value the EMA must fall below to detect a falling crossing
+       * @param high (float) - the value the EMA must rise above to detect a rising crossing
+       */
+      void setThresholds(float low, float high);
+
+      /**
+       * Returns a summary of the samples in the window.
+       *
+       * @return (WindowSummary<T>) the summary of the window
+       */
+      WindowSummary<T> summarize() const;
+
+      /**
+       * Returns whether the EMA is currently above the thresholds, as of the last crossing.
+       *
+       * @return (bool) true iff the last crossing detected was a rise
+       */
+      bool isAbove() const;
+
+      /**
+       * Returns the number of samples in the window.
+       *
+       * @return (int) the number of samples in the window
+       */
+      int count() const;
+
+    private:
+      T samples[WINDOW];      // The samples in the window, stored in a ring buffer.
+      unsigned long added;    // The total number of samples ever added.  The next sample is stored at `added % WINDOW`.
+      T sum;                  // The sum of the samples in the window.
+
+      // Monotonic queues of sample numbers (i.e. the value of `added` when the sample was added) used to find the minimum and
+      // maximum.  Each is a ring buffer holding at most WINDOW sample numbers.
+      unsigned long minQueue[WINDOW];
+      int minHead;
+      int minCount;
+      unsigned long maxQueue[WINDOW];
+      int maxHead;
+      int maxCount;
+
+      const float smoothing;
+      float ema;
+
+      bool hasThresholds;
+      float low;
+      float high;
+      bool above;
+
+      T sampleAt(unsigned long sampleNumber) const;
+      void pushMin(unsigned long sampleNumber);
+      void pushMax(unsigned long sampleNumber);
+  };
+
+  #include "../infrastructure/WindowedAggregate.cpp"
+
+#endif /* _C1MOORE_INFRASTRUCTURE_WINDOWEDAGGREGATE */
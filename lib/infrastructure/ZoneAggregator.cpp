@@ -0,0 +1,176 @@
+/*
+ * ZoneAggregator.cpp
+ *
+ *      Author: c1moore
+ */
+#include <Arduino.h>
+
+#include "ZoneAggregator.h"
+
+/**
+ * Zone represents the state of a single zone.
+ */
+struct Zone {
+  uint16_t id;              // The sub-device ID of the zone, as registered with the Master node.
+  unsigned long holdOff;    // The number of milliseconds without motion after which the zone becomes vacant.
+  unsigned long lastMotion; // The time, in milliseconds, motion was last detected in the zone.
+  bool occupied;            // true iff the zone is currently occupied.
+};
+
+/**
+ * ZoneAssignment maps a sensor to the zone it covers.
+ */
+struct ZoneAssignment {
+  int sensorId; // The unique ID of the sensor.
+  int zone;     // The index of the zone the sensor covers.
+};
+
+class ZoneAggregator::Implementation {
+  public:
+    Coordinator &coordinator;
+
+    Zone zones[MAX_ZONES];
+    int zoneCount = 0;
+
+    ZoneAssignment assignments[MAX_ZONE_SENSORS];
+    int assignmentCount = 0;
+
+    unsigned long reportCount = 0;
+    unsigned long updateCount = 0;
+
+    Implementation(Coordinator &coordinator): coordinator(coordinator) {}
+
+    /**
+     * Returns the index of the zone the specified sensor is assigned to.
+     *
+     * @param sensorId (int) - the unique ID of the sensor
+     *
+     * @return (int) the index of the sensor's zone or -1 if the sensor is not assigned to a zone
+     */
+    int findZone(int sensorId) const {
+      for(int assignmentIndex = 0; assignmentIndex < assignmentCount; assignmentIndex++) {
+        if(assignments[assignmentIndex].sensorId == sensorId) {
+          return assignments[assignmentIndex].zone;
+        }
+      }
+
+      return -1;
+    }
+
+    /**
+     * Sets the occupancy of a zone and sends an update to the Master node.
+     *
+     * @param zone (Zone &) - the zone to update
+     * @param occupied (bool) - whether the zone is now occupied
+     */
+    void setOccupied(Zone &zone, bool occupied) {
+      zone.occupied = occupied;
+      updateCount++;
+
+      // Occupancy changes drive the lights, so they are sent as events rather than batched.
+      coordinator.sendEvent(zone.id, occupied ? "1" : "0");
+    }
+};
+
+ZoneAggregator::ZoneAggregator(Coordinator &coordinator) {
+  implementation = new Implementation(coordinator);
+}
+
+ZoneAggregator::~ZoneAggregator() {
+  delete implementation;
+}
+
+int ZoneAggregator::addZone(unsigned long holdOff) {
+  if(implementation->zoneCount >= MAX_ZONES) {
+    return -1;
+  }
+
+  const int zoneId = implementation->coordinator.registerSensor(ZONE_OCCUPANCY);
+
+  if(zoneId < 0) {
+    return -2;
+  }
+
+  Zone &zone = implementation->zones[implementation->zoneCount];
+
+  zone.id = zoneId;
+  zone.holdOff = holdOff;
+  zone.lastMotion = 0;
+  zone.occupied = false;
+
+  return implementation->zoneCount++;
+}
+
+int ZoneAggregator::assign(int sensorId, int zone) {
+  if(zone < 0 || zone >= implementation->zoneCount) {
+    return -1;
+  }
+
+  if(implementation->assignmentCount >= MAX_ZONE_SENSORS) {
+    return -2;
+  }
+
+  ZoneAssignment &assignment = implementation->assignments[implementation->assignmentCount++];
+
+  assignment.sensorId = sensorId;
+  assignment.zone = zone;
+
+  return 0;
+}
+
+int ZoneAggregator::reportMotion(int sensorId) {
+  const int zoneIndex = implementation->findZone(sensorId);
+
+  if(zoneIndex < 0) {
+    return -1;
+  }
+
+  Zone &zone = implementation->zones[zoneIndex];
+
+  implementation->reportCount++;
+  zone.lastMotion = millis();
+
+  if(!zone.occupied) {
+    implementation->setOccupied(zone, true);
+  }
+
+  return 0;
+}
+
+int ZoneAggregator::getZoneId(int zone) const {
+  if(zone < 0 || zone >= implementation->zoneCount) {
+    return -1;
+  }
+
+  return implementation->zones[zone].id;
+}
+
+bool ZoneAggregator::isOccupied(int zone) const {
+  if(zone < 0 || zone >= implementation->zoneCount) {
+    return false;
+  }
+
+  return implementation->zones[zone].occupied;
+}
+
+int ZoneAggregator::run() {
+  const unsigned long now = millis();
+
+  for(int zoneIndex = 0; zoneIndex < implementation->zoneCount; zoneIndex++) {
+    Zone &zone = implementation->zones[zoneIndex];
+
+    if(zone.occupied && (now - zone.lastMotion) >= zone.holdOff) {
+      implementation->setOccupied(zone, false);
+    }
+  }
+
+  return 0;
+}
+
+unsigned long ZoneAggregator::getReportCount() const {
+  return implementation->reportCount;
+}
+
+unsigned long ZoneAggregator::getUpdateCount() const {
+  return implementation->updateCount;
+}
@@ -0,0 +1,120 @@
+/*
+ * ZoneAggregator.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_INFRASTRUCTURE_ZONEAGGREGATOR
+  #define _C1MOORE_INFRASTRUCTURE_ZONEAGGREGATOR
+
+  #include <stdint.h>
+
+  #include "../scheduler/Runnable.h"
+  #include "Coordinator.h"
+
+  // The maximum number of zones a ZoneAggregator can track.
+  #define MAX_ZONES         8
+
+  // The maximum number of sensors that can be assigned to zones.
+  #define MAX_ZONE_SENSORS  16
+
+  /**
+   * A ZoneAggregator combines the motion reported by several sensors into the occupancy of the zones (e.g. rooms) they cover and
+   * only sends an update to the Master node when a zone's occupancy changes.  Without aggregation, a room with several motion
+   * sensors would send an update for every trigger of every sensor, most of which tell the Master nothing new.
+   *
+   * A zone becomes occupied the first time any of its sensors reports motion.  It remains occupied until none of its sensors has
+   * reported motion for the zone's hold-off period, at which point it becomes vacant.  The ZoneAggregator should be scheduled to
+   * execute periodically so vacancies are detected in a timely manner.
+   *
+   * Each zone is registered with the Master node as a ZONE_OCCUPANCY sensor, so it has a sub-device ID of its own that cannot
+   * collide with any other sub device's.  Updates are sent using that ID.  The data of the update is "1" if the zone is occupied
+   * and "0" if it is vacant.
+   */
+  class ZoneAggregator: public Runnable {
+    public:
+      /**
+       * Creates a new ZoneAggregator.
+       *
+       * @param coordinator (Coordinator &) - the Coordinator used to send updates to the Master node
+       */
+      ZoneAggregator(Coordinator &coordinator);
+      ~ZoneAggregator();
+
+      /**
+       * Adds a new zone and registers it with the Master node (see `Coordinator::registerSensor()`).  Zones should be added
+       * before the Coordinator registers its sub devices with the Master node.
+       *
+       * @param holdOff (unsigned long) - the number of milliseconds without motion after which the zone becomes vacant
+       *
+       * @return (int) the index of the zone if it was added; -1 if MAX_ZONES zones already exist; -2 if the zone could not be
+       *  registered
+       */
+      int addZone(unsigned long holdOff);
+
+      /**
+       * Returns the sub-device ID the Master node knows a zone by.
+       *
+       * @param zone (int) - the index of the zone
+       *
+       * @return (int) the sub-device ID of the zone or -1 if there is no such zone
+       */
+      int getZoneId(int zone) const;
+
+      /**
+       * Assigns a sensor to a zone.  Motion reported by the sensor will be attributed to the zone.
+       *
+       * @param sensorId (int) - the unique ID of the sensor
+       * @param zone (int) - the index of the zone, as returned by `addZone()`
+       *
+       * @return (int) 0 iff the sensor was assigned; otherwise, a negative value
+       */
+      int assign(int sensorId, int zone);
+
+      /**
+       * Reports that a sensor detected motion.  If the sensor's zone was vacant, an update is sent to the Master node.
+       *
+       * @param sensorId (int) - the unique ID of the sensor that detected motion
+       *
+       * @return (int) 0 iff the motion was attributed to a zone; otherwise, a negative value if the sensor is not assigned to a zone
+       */
+      int reportMotion(int sensorId);
+
+      /**
+       * Returns whether a zone is currently occupied.
+       *
+       * @param zone (int) - the index of the zone
+       *
+       * @return (bool) true iff the zone is occupied
+       */
+      bool isOccupied(int zone) const;
+
+      /**
+       * Marks every zone whose hold-off period has expired as vacant and sends an update to the Master node for each.
+       *
+       * @return (int) 0
+       */
+      int run();
+
+      /**
+       * Returns the total number of motion reports received from sensors.
+       *
+       * @return (unsigned long) the total number of motion reports
+       */
+      unsigned long getReportCount() const;
+
+      /**
+       * Returns the total number of updates sent to the Master node.  Comparing this to `getReportCount()` gives the reduction in
+       * outbound requests achieved by aggregation.
+       *
+       * @return (unsigned long) the total number of updates sent
+       */
+      unsigned long getUpdateCount() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_INFRASTRUCTURE_ZONEAGGREGATOR */
@@ -66,8 +66,9 @@
 
     int delta = delta0;
 
-    while(current->next && current->item->delta <= delta) {
-      delta -= current->item->delta;
+    // The head is a sentinel without an item, so the deltas compared are those of the nodes after `current`.
+    while(current->next && current->next->item->delta <= delta) {
+      delta -= current->next->item->delta;
 
       current = current->next;
     }
@@ -83,7 +84,9 @@
 
   template<class T>
   void DeltaList<T>::decrement(const int value) {
-    implementation->HEAD->next->item->delta--;
+    if(implementation->HEAD->next) {
+      implementation->HEAD->next->item->delta -= value;
+    }
   }
 
   template<class T>
@@ -99,6 +102,10 @@
   const T DeltaList<T>::remove() {
     typename Implementation::DeltaNode *first = implementation->HEAD->next;
 
+    if(!first) {
+      return T();
+    }
+
     implementation->HEAD->next = first->next;
 
     T value = first->item->value;
@@ -111,6 +118,6 @@
 
   template<class T>
   bool DeltaList<T>::isEmpty() const {
-    return (implementation->HEAD->next != NULL);
+    return (implementation->HEAD->next == NULL);
   }
 #endif /* _SL_SCHEDULER_DELTALIST_IMPLEMENTATION */
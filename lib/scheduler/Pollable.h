@@ -0,0 +1,28 @@
+/*
+ * Pollable.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _ARDUINO_POLLABLE
+  #define _ARDUINO_POLLABLE
+
+  /**
+   * Pollable defines an interface for conditions a process can wait on using `Scheduler::await()`, such as a network client
+   * becoming readable.  The Scheduler polls every condition being waited on once per pass, so polling should be cheap and
+   * must never block.  Conditions that share an expensive check can do it once per pass (see `Scheduler::getPollPass()`).
+   */
+  class Pollable {
+    public:
+      Pollable() {}
+      virtual ~Pollable() {};
+
+      /**
+       * Checks whether the condition currently holds.
+       *
+       * @returns (bool) true iff the condition holds and the process waiting on it can resume
+       */
+      virtual bool poll() = 0;
+  };
+
+#endif
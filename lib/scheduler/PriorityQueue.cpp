@@ -79,7 +79,7 @@
     PriorityNode<T> *node = new PriorityNode<T>(item, priority);
     PriorityNode<T> *current = implementation->HEAD;
 
-    while(current->next && current->priority >= priority) {
+    while(current->next && current->next->priority >= priority) {
       current = current->next;
     }
 
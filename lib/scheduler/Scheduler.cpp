@@ -12,6 +12,46 @@
 #include "../scheduler/DeltaList.h"
 #include "../scheduler/PriorityQueue.h"
 #include "../scheduler/Runnable.h"
+#include "../scheduler/Pollable.h"
+
+/**
+ * Returns the current value of the MCU's cycle counter.  The counter is expected to wrap, so values returned by this method
+ * should only be compared using their difference.  If the MCU does not provide a cycle counter, microseconds are used instead.
+ *
+ * @returns (uint32_t) the current value of the cycle counter
+ */
+static inline uint32_t cycleCount() {
+  #ifdef ESP8266
+    return ESP.getCycleCount();
+  #else
+    return micros();
+  #endif
+}
+
+#ifdef SCHEDULER_POLICY_FAIR_SHARE
+  // The weight of each priority used to scale a process's virtual runtime.  Each priority level receives roughly 25% more of the
+  // MCU than the level below it.  A process of priority 1 accrues virtual runtime at the same rate as real time.
+  static const uint32_t FAIR_SHARE_WEIGHTS[] = {
+    1024, 1024, 1280, 1600, 2000, 2500, 3125, 3906, 4883, 6104, 7629, 9537, 11921, 14901, 18626, 23283
+  };
+
+  #define FAIR_SHARE_BASE_WEIGHT  1024
+  #define FAIR_SHARE_MAX_PRIORITY 15
+
+  // The least virtual runtime at which all virtual runtimes are shifted back toward 0.
+  #define FAIR_SHARE_RENORMALIZE  0x40000000UL
+#endif
+
+// The thread-local storage class used for the current Scheduler.  Arduino MCUs only have a single thread and may not support
+// thread-local storage, so it is only used when building for a host.
+#ifdef ARDUINO
+  #define SCHEDULER_THREAD_LOCAL
+#else
+  #define SCHEDULER_THREAD_LOCAL thread_local
+#endif
+
+// The Scheduler currently executing on this thread, if any.
+static SCHEDULER_THREAD_LOCAL Scheduler *currentScheduler = NULL;
 
 /**
  * ProcessData represents the structure of data stored about each process in the process table.
@@ -22,6 +62,24 @@ struct ProcessData {
   int priority;       // The process's priority
   int repetitions;    // If the process should execute at a specific interval, the total number of times the process should execute
   int interval;       // If the process should execute multiple times at a given interval, the interval at which the process should execute.
+  int waitResult;     // If the process was WAITING, the result of the wait to return from `await()`.
+  bool resident;      // true iff the process returns to SUSPENDED, rather than being removed, once it finishes executing.
+  bool woken;         // true iff the process was marked READY while it was executing and must execute again.
+  bool stacked;       // true iff the process has been dispatched and has not returned, even if another process preempted it.
+
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    uint32_t vruntime;  // The process's virtual runtime, in weighted microseconds.
+  #endif
+};
+
+/**
+ * Waiter represents a process waiting for a Pollable condition to hold.
+ */
+struct Waiter {
+  int pid;              // The ID of the waiting process.
+  Pollable *condition;  // The condition on which the process is waiting.
+  unsigned long start;  // The time, in milliseconds, at which the process started waiting.
+  int timeout;          // The maximum number of milliseconds the process will wait or a negative value to wait indefinitely.
 };
 
 /**
@@ -29,22 +87,66 @@ struct ProcessData {
  */
 class Scheduler::SchedulerImplementation {
   public:
-    ProcessData ptable[MAX_PROCESSES] = { { 0 } };  // The table of all processes managed by Scheduler.
+    ProcessData ptable[MAX_PROCESSES] = {};  // The table of all processes managed by Scheduler.
 
     PriorityQueue<int> readyList; // The list of processes waiting to execute.
     DeltaList<int> sleepingList;  // The list of processes currently sleeping.
 
+    Waiter waiters[MAX_PROCESSES];  // The processes currently waiting for a condition to hold.
+    int waiterCount;                // The total number of processes currently waiting.
+    long pollPass;                  // The number of the current (or last) pass over the waiting processes' conditions.
+    bool polling;                   // true iff the conditions of the waiting processes are being polled.
+
+    Runnable *idleTasks[MAX_IDLE_TASKS];  // The tasks executed when no process is READY.
+    int idleTaskCount;                    // The total number of idle tasks registered.
+    int nextIdleTask;                     // The index of the next idle task to execute.
+    bool idling;                          // true iff an idle task is currently executing.
+
+    unsigned long loadWindowStart;  // The time, in microseconds, the current load window started.
+    unsigned long idleSince;        // The time, in microseconds, the last process dispatched by `step()` returned control.
+    unsigned long idleMicros;       // The total number of microseconds the Scheduler has been idle in the current load window.
+    int cpuLoad;                    // The CPU load, as a percentage, measured in the last complete load window.
+
     int currentPid;               // The ID of the process currently executing.
     int nextValidPid;             // The next process ID to attempt when assigning a new process its ID.
+    uint32_t quantumEnd;          // The value of the cycle counter at which the current process's quantum expires.
+
+    #ifdef SCHEDULER_ENABLE_CLOCK
+      unsigned long clockTime;    // The time, in milliseconds, up to which the sleeping processes have been accounted for.
+    #endif
+
+    #ifdef SCHEDULER_POLICY_FAIR_SHARE
+      uint32_t minVruntime;       // The (monotonically increasing) least virtual runtime of any READY or EXECUTING process.
+      unsigned long runStart;     // The time, in microseconds, at which the current process last started accruing runtime.
+    #endif
 
     bool started;                 // true iff Scheduler has started; false otherwise
 
     SchedulerImplementation() {
-      readyList = PriorityQueue<int>();
-      sleepingList = DeltaList<int>();
-
       currentPid = -1;
       nextValidPid = 0;
+      quantumEnd = 0;
+      waiterCount = 0;
+      pollPass = 0;
+      polling = false;
+
+      idleTaskCount = 0;
+      nextIdleTask = 0;
+      idling = false;
+
+      loadWindowStart = micros();
+      idleSince = loadWindowStart;
+      idleMicros = 0;
+      cpuLoad = 0;
+
+      #ifdef SCHEDULER_POLICY_FAIR_SHARE
+        minVruntime = 0;
+        runStart = micros();
+      #endif
+
+      #ifdef SCHEDULER_ENABLE_CLOCK
+        clockTime = millis();
+      #endif
 
       started = false;
     }
@@ -58,18 +160,25 @@ class Scheduler::SchedulerImplementation {
      */
     int getNextAvailablePid() {
       // Scheduling a new thread is not expected to be common, so we'll trade time for memory.
-      int nextPid = nextValidPid;
-      int originalPid = nextPid;
-
-      if(ptable[nextPid].state != DEAD) {
-        nextPid = (nextPid + 1) % MAX_PROCESSES;
+      for(int offset = 0; offset < MAX_PROCESSES; offset++) {
+        const int nextPid = (nextValidPid + offset) % MAX_PROCESSES;
 
-        if(nextPid == originalPid) {
-          return -1;
+        if(ptable[nextPid].state == DEAD) {
+          return nextPid;
         }
       }
 
-      return nextPid;
+      return -1;
+    }
+
+    /**
+     * Claims `pid` for a newly scheduled process.  While pid + 1 may not be (currently) available, it may be available by the
+     * next time a process is scheduled and we want to minimize the number of times a PID is reused.
+     *
+     * @param pid (const int) - the PID assigned to the new process
+     */
+    void claimPid(const int pid) {
+      nextValidPid = (pid + 1) % MAX_PROCESSES;
     }
 
     /**
@@ -79,63 +188,391 @@ class Scheduler::SchedulerImplementation {
     void reschedule() {
       delay(0); // Give the underlying OS, if any, time to do any necessary processing.
 
+      advanceClock();
+      pollWaiters();
+
       if(readyList.isEmpty()) {
+        // A waiting process does not need the MCU, so this is a good time to get some background work done.
+        if(currentPid >= 0 && ptable[currentPid].state == WAITING) {
+          const unsigned long idleStart = micros();
+
+          idle();
+          recordLoad(micros() - idleStart);
+        }
+
+        return;
+      }
+
+      const int nextPid = readyList.peek();
+
+      // A process that was preempted can only resume once every process dispatched on top of it has returned.
+      if(ptable[nextPid].stacked) {
         return;
       }
 
-      int nextPid = readyList.peek();
+      // A process that yields stays EXECUTING, rather than going back in the ready list, since it resumes as soon as the next
+      // process returns control.
+      if(currentPid >= 0 && ptable[currentPid].state == EXECUTING) {
+        chargeRuntime();
 
-      if(ptable[currentPid].state == EXECUTING) {
-        if(ptable[nextPid].priority < ptable[currentPid].priority) {
+        if(!precedes(nextPid, currentPid, true)) {
           return;
         }
-
-        ptable[currentPid].state = READY;
-        readyList.enqueue(currentPid, ptable[currentPid].priority);
       }
 
-      nextPid = readyList.dequeue();
+      readyList.dequeue();
 
       switchContext(nextPid);
     }
 
     /**
-     * For processes that should be repeated, updates the process's state in the process table to reflect a completed iteration.
+     * Wakes every sleeping process whose delay has passed since the clock was last advanced.  The clock follows `millis()`, so
+     * it is advanced on every pass rather than by a clock interrupt.  This has no effect unless SCHEDULER_ENABLE_CLOCK is
+     * defined.
+     */
+    void advanceClock() {
+      #ifdef SCHEDULER_ENABLE_CLOCK
+        const unsigned long now = millis();
+        unsigned long elapsed = now - clockTime;
+
+        clockTime = now;
+
+        while(!sleepingList.isEmpty()) {
+          const int delta = sleepingList.peek().delta;
+
+          if(delta > 0 && (unsigned long) delta > elapsed) {
+            break;
+          }
+
+          elapsed -= (delta > 0) ? delta : 0;
+
+          const int awokenPid = sleepingList.remove();
+
+          // A process that was killed or woken some other way while it slept stays as it is.
+          if(ptable[awokenPid].state == SLEEPING) {
+            enqueueReady(awokenPid);
+          }
+        }
+
+        sleepingList.decrement((int) elapsed);
+      #endif
+    }
+
+    /**
+     * Polls the condition of every waiting process.  Each process whose condition holds or whose timeout has been reached will
+     * be marked as READY.  These processes are not added to the ready list since they resume from `await()` once control is
+     * returned to them.
+     */
+    void pollWaiters() {
+      const unsigned long now = millis();
+      int waiterIndex = 0;
+
+      polling = true;
+      pollPass = (pollPass == 0x7fffffffL) ? 0 : pollPass + 1;
+
+      while(waiterIndex < waiterCount) {
+        Waiter &waiter = waiters[waiterIndex];
+        int result;
+
+        if(waiter.condition->poll()) {
+          result = 0;
+        } else if(waiter.timeout >= 0 && (now - waiter.start) >= (unsigned long) waiter.timeout) {
+          result = -2;
+        } else {
+          waiterIndex++;
+
+          continue;
+        }
+
+        ptable[waiter.pid].waitResult = result;
+        ptable[waiter.pid].state = READY;
+
+        // Order does not matter, so fill the gap with the last waiter.
+        waiters[waiterIndex] = waiters[--waiterCount];
+      }
+
+      polling = false;
+    }
+
+    /**
+     * Executes idle tasks until each has executed once or a process is READY.  The caller records the time spent idle for the
+     * CPU load.
+     */
+    void idle() {
+      const uint32_t previousQuantumEnd = quantumEnd;
+
+      // Idle tasks have no quantum, so `shouldYield()` goes straight to checking the ready list.
+      idling = true;
+      quantumEnd = cycleCount();
+
+      for(int taskCount = 0; taskCount < idleTaskCount && readyList.isEmpty(); taskCount++) {
+        Runnable *task = idleTasks[nextIdleTask];
+
+        nextIdleTask = (nextIdleTask + 1) % idleTaskCount;
+
+        task->run();
+      }
+
+      idling = false;
+      quantumEnd = previousQuantumEnd;
+    }
+
+    /**
+     * Records time spent idle and, once the current load window has elapsed, calculates the CPU load for the window.
+     *
+     * @param idleTime (const unsigned long) - the number of microseconds the Scheduler was idle since the last time this method
+     *  was called
+     */
+    void recordLoad(const unsigned long idleTime) {
+      const unsigned long now = micros();
+      const unsigned long elapsed = now - loadWindowStart;
+
+      idleMicros += idleTime;
+
+      if(elapsed < (unsigned long) LOAD_WINDOW * 1000UL) {
+        return;
+      }
+
+      cpuLoad = (idleMicros >= elapsed) ? 0 : (int) (100 - ((uint64_t) idleMicros * 100) / elapsed);
+
+      loadWindowStart = now;
+      idleMicros = 0;
+    }
+
+    /**
+     * Returns whether a READY process should take control of the MCU from the current process once its quantum has expired.
+     *
+     * @returns (bool) true iff a process with a priority at least as high as the current process's priority is READY and can
+     *  be dispatched
+     */
+    bool hasPreemptingProcess() const {
+      if(idling) {
+        return !readyList.isEmpty();
+      }
+
+      if(currentPid < 0 || readyList.isEmpty()) {
+        return false;
+      }
+
+      const int nextPid = readyList.peek();
+
+      // Neither the current process nor a process it preempted can be dispatched on top of it.
+      if(nextPid == currentPid || ptable[nextPid].stacked) {
+        return false;
+      }
+
+      return precedes(nextPid, currentPid, true);
+    }
+
+    /**
+     * Returns whether the process identified by `pid` should execute before the process identified by `otherPid` according to the
+     * scheduling policy.  With the default policy, the process with the higher priority should execute first.  If
+     * SCHEDULER_POLICY_FAIR_SHARE is defined, the process with the least virtual runtime should execute first.
+     *
+     * @param pid (const int) - the ID of the process being compared
+     * @param otherPid (const int) - the ID of the process against which `pid` is compared
+     * @param ties (const bool) - the value to return if neither process should execute before the other
+     *
+     * @returns (bool) true iff `pid` should execute before `otherPid`
+     */
+    bool precedes(const int pid, const int otherPid, const bool ties) const {
+      #ifdef SCHEDULER_POLICY_FAIR_SHARE
+        const uint32_t vruntime = ptable[pid].vruntime;
+        const uint32_t otherVruntime = ptable[otherPid].vruntime;
+
+        return (vruntime < otherVruntime || (ties && vruntime == otherVruntime));
+      #else
+        const int priority = ptable[pid].priority;
+        const int otherPriority = ptable[otherPid].priority;
+
+        return (priority > otherPriority || (ties && priority == otherPriority));
+      #endif
+    }
+
+    /**
+     * Marks the process identified by `pid` as READY and adds it to the ready list in the position determined by the scheduling
+     * policy.
+     *
+     * @param pid (const int) - the ID of the process that is ready to execute
+     */
+    void enqueueReady(const int pid) {
+      ptable[pid].state = READY;
+
+      #ifdef SCHEDULER_POLICY_FAIR_SHARE
+        // A process that has been waiting cannot bank more than FAIR_SHARE_WAKEUP_CREDIT of virtual runtime; otherwise, it would
+        // monopolize the MCU after waking.
+        const uint32_t floor = (minVruntime > FAIR_SHARE_WAKEUP_CREDIT) ? (minVruntime - FAIR_SHARE_WAKEUP_CREDIT) : 0;
+
+        if(ptable[pid].vruntime < floor) {
+          ptable[pid].vruntime = floor;
+        }
+
+        // The ready list favors larger values, so the least virtual runtime must have the largest value.
+        readyList.enqueue(pid, -((int) ptable[pid].vruntime));
+      #else
+        readyList.enqueue(pid, ptable[pid].priority);
+      #endif
+    }
+
+    /**
+     * Charges the current process for the time it has executed since it was dispatched or last charged.  A process that is not
+     * EXECUTING (e.g. it is WAITING) is not charged.  This has no effect unless SCHEDULER_POLICY_FAIR_SHARE is defined.
+     */
+    void chargeRuntime() {
+      #ifdef SCHEDULER_POLICY_FAIR_SHARE
+        const unsigned long now = micros();
+
+        if(currentPid >= 0 && ptable[currentPid].state == EXECUTING) {
+          ProcessData &process = ptable[currentPid];
+          int priority = process.priority;
+
+          if(priority < 1) {
+            priority = 1;
+          } else if(priority > FAIR_SHARE_MAX_PRIORITY) {
+            priority = FAIR_SHARE_MAX_PRIORITY;
+          }
+
+          process.vruntime += (uint32_t) (((uint64_t) (now - runStart) * FAIR_SHARE_BASE_WEIGHT) / FAIR_SHARE_WEIGHTS[priority]);
+
+          // Advance the least virtual runtime, but never past a process that is still waiting to execute.
+          uint32_t least = process.vruntime;
+
+          if(!readyList.isEmpty() && ptable[readyList.peek()].vruntime < least) {
+            least = ptable[readyList.peek()].vruntime;
+          }
+
+          if(least > minVruntime) {
+            minVruntime = least;
+          }
+
+          if(minVruntime >= FAIR_SHARE_RENORMALIZE) {
+            renormalize();
+          }
+        }
+
+        runStart = now;
+      #endif
+    }
+
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    /**
+     * Shifts the virtual runtime of every process so the least virtual runtime is 0 and rebuilds the ready list.  The ready list
+     * orders processes using a signed int, so this must be done before any virtual runtime can exceed the largest int.
+     */
+    void renormalize() {
+      int ready[MAX_PROCESSES];
+      int readyCount = 0;
+
+      while(!readyList.isEmpty()) {
+        ready[readyCount++] = readyList.dequeue();
+      }
+
+      for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        ptable[pid].vruntime = (ptable[pid].vruntime > minVruntime) ? (ptable[pid].vruntime - minVruntime) : 0;
+      }
+
+      minVruntime = 0;
+
+      for(int readyIndex = 0; readyIndex < readyCount; readyIndex++) {
+        enqueueReady(ready[readyIndex]);
+      }
+    }
+  #endif
+
+    /**
+     * Updates the process's state in the process table once it has finished executing.  Processes that should be repeated are
+     * put to sleep, resident processes are suspended until they are woken, and all other processes are removed so their PID can
+     * be reused.
      *
      * @param pid (const int) - the ID of the process that just finished executing
      */
     void postExecute(const int pid) {
-      ProcessData process = ptable[pid];
+      ProcessData &process = ptable[pid];
+
+      if(process.state == DEAD) {
+        // The process killed itself.
+        return;
+      }
 
-      if(process.repetitions > 0) {
+      if(process.resident) {
+        if(process.state == READY) {
+          // The process is already in the ready list, so it will execute again anyway.
+          process.woken = false;
+        } else if(process.woken) {
+          process.woken = false;
+
+          enqueueReady(pid);
+        } else if(process.state != SLEEPING) {
+          // A process that went to sleep stays in the sleeping list until its delay has passed.
+          process.state = SUSPENDED;
+        }
+      } else if(process.repetitions > 0) {
         --process.repetitions;
 
         if(process.repetitions <= 0) {
           // The process has finished all its repetitions and can be removed from the process table.
-          ptable[pid] = { 0 };
+          release(pid);
         } else {
           // The process needs to be repeated.
-          repeatProcess(pid, process);
+          repeatProcess(pid);
         }
       } else if(process.repetitions < 0) {
         // This process repeats indefinitely.  Make it sleep.
-        repeatProcess(pid, process);
+        repeatProcess(pid);
+      } else {
+        // The process only executes once.
+        release(pid);
       }
     }
 
+    /**
+     * Removes the process identified by `pid` from the process table so its PID can be assigned to another process.
+     *
+     * @param pid (const int) - the ID of the process to remove
+     */
+    void release(const int pid) {
+      if(ptable[pid].state == READY) {
+        readyList.remove(pid);
+      }
+
+      ptable[pid] = ProcessData();
+    }
+
     /**
      * Starts executing the process specified by nextPid.
      *
      * @param nextPid (int) - the ID of the process that should be executed
      */
     void switchContext(int nextPid) {
-      ProcessData nextProcess = ptable[nextPid];
+      ProcessData &nextProcess = ptable[nextPid];
+
+      // The next process executes on top of the current process's stack, so the current process's context must be restored
+      // once the next process returns control.
+      const int previousPid = currentPid;
+      const uint32_t previousQuantumEnd = quantumEnd;
+
+      chargeRuntime();
 
       currentPid = nextPid;
       nextProcess.state = EXECUTING;
+      nextProcess.stacked = true;
+      quantumEnd = cycleCount() + ((uint32_t) nextProcess.priority * QUANTUM_CYCLES);
 
       nextProcess.process->run();
+
+      chargeRuntime();
+      nextProcess.stacked = false;
       postExecute(nextPid);
+
+      currentPid = previousPid;
+      quantumEnd = previousQuantumEnd;
+
+      // The previous process resumes here, so if it was readied while it was preempted (e.g. woken after suspending itself or
+      // sleeping), it is executing again rather than waiting in the ready list.
+      if(previousPid >= 0 && ptable[previousPid].state == READY) {
+        readyList.remove(previousPid);
+        ptable[previousPid].state = EXECUTING;
+      }
     }
 
   private:
@@ -143,12 +580,13 @@ class Scheduler::SchedulerImplementation {
      * Adds the back to the sleeping list to be executed again.
      *
      * @param pid (const int) - the ID of the process that should be repeated
-     * @param process (ProcessData) - the process's entry in the ptable
      */
-    void repeatProcess(const int pid, ProcessData process) {
-      sleepingList.insert(pid, process.interval);
+    void repeatProcess(const int pid) {
+      // The interval starts now, not when the clock was last advanced.
+      advanceClock();
+      sleepingList.insert(pid, ptable[pid].interval);
 
-      process.state = SLEEPING;
+      ptable[pid].state = SLEEPING;
     }
 };
 
@@ -166,6 +604,18 @@ Scheduler &Scheduler::getInstance() {
   return scheduler;
 }
 
+Scheduler &Scheduler::current() {
+  if(currentScheduler == NULL) {
+    return getInstance();
+  }
+
+  return *currentScheduler;
+}
+
+void Scheduler::setCurrent(Scheduler &scheduler) {
+  currentScheduler = &scheduler;
+}
+
 const int Scheduler::getCurrentPid() const {
   return implementation->currentPid;
 }
@@ -180,13 +630,15 @@ int Scheduler::schedule(Runnable &process, const int priority) {
 
   ptable[pid].process = &process;
   ptable[pid].priority = priority;
-  ptable[pid].state = READY;  // New processes must be READY.  If they aren't, they can be SUSPENDED immediately.
 
-  // While pid + 1 may not be (currently) available, it may be available by the next time a process is scheduled and we want to
-  // minimize the number of times a PID is reused.
-  implementation->nextValidPid = pid + 1;
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    ptable[pid].vruntime = implementation->minVruntime;
+  #endif
+
+  implementation->claimPid(pid);
 
-  implementation->readyList.enqueue(pid, priority);
+  // New processes must be READY.  If they aren't, they can be SUSPENDED immediately.
+  implementation->enqueueReady(pid);
 
   // If the Scheduler has already taken control, we need to give the new process a chance to be executed.
   if(implementation->started) {
@@ -199,7 +651,6 @@ int Scheduler::schedule(Runnable &process, const int priority) {
 int Scheduler::scheduleInterval(Runnable &process, const int interval, const int repetitions, const int priority) {
   #ifdef SCHEDULER_ENABLE_CLOCK
     int pid = implementation->getNextAvailablePid();
-    ProcessData processData = implementation->ptable[pid];
 
     if(pid < 0) {
       return pid;
@@ -209,21 +660,18 @@ int Scheduler::scheduleInterval(Runnable &process, const int interval, const int
       return -2;
     }
 
-    if(interval < MIN_INTERVAL) {
-      interval = MIN_INTERVAL;
-    }
+    const int period = (interval < MIN_INTERVAL) ? MIN_INTERVAL : interval;
+    ProcessData &processData = implementation->ptable[pid];
 
     processData.process = &process;
     processData.priority = priority;
     processData.state = SLEEPING;
-    processData.interval = interval;
+    processData.interval = period;
     processData.repetitions = repetitions;
 
-    // While pid + 1 may not be (currently) available, it may be available by the next time a process is scheduled and we want to
-    // minimize the number of times a PID is reused.
-    implementation->nextValidPid = pid + 1;
+    implementation->claimPid(pid);
 
-    implementation->sleepingList.insert(pid, interval, priority);
+    implementation->sleepingList.insert(pid, period);
 
     // If the Scheduler has already taken control, we need to give the new process a chance to be executed.
     if(implementation->started) {
@@ -241,34 +689,131 @@ void Scheduler::start() {
 
   // This will take the place of loop(), so we need to loop forever.
   while(true) {
-    delay(0);   // First let any underlying OS or external services get a chance to execute.
-    
-    if(implementation->readyList.isEmpty()) {
-      continue;
-    }
+    step();
+  }
+}
 
+bool Scheduler::step() {
+  implementation->started = true;
+
+  delay(0);   // First let any underlying OS or external services get a chance to execute.
+
+  // Processes and idle tasks executed by this Scheduler expect it to be the current Scheduler.
+  Scheduler *previousScheduler = currentScheduler;
+  currentScheduler = this;
+
+  implementation->advanceClock();
+
+  const bool dispatched = !implementation->readyList.isEmpty();
+
+  // Only the time spent executing a process is busy.  Everything since the last process returned control, including the time
+  // given to the underlying OS and the time between passes, is idle.
+  if(dispatched) {
     int nextPid = implementation->readyList.dequeue();
 
-    implementation->ptable[nextPid].process->run();
-    implementation->postExecute(nextPid);
+    implementation->recordLoad(micros() - implementation->idleSince);
+    implementation->switchContext(nextPid);
+
+    implementation->idleSince = micros();
+  } else {
+    implementation->idle();
+
+    // The rest of this pass is idle as well, so it is recorded with the next one.
+    const unsigned long now = micros();
+
+    implementation->recordLoad(now - implementation->idleSince);
+    implementation->idleSince = now;
   }
+
+  currentScheduler = previousScheduler;
+
+  return dispatched;
+}
+
+int Scheduler::scheduleSuspended(Runnable &process, const int priority) {
+  int pid = implementation->getNextAvailablePid();
+
+  if(pid < 0) {
+    return pid;
+  }
+
+  ProcessData &processData = implementation->ptable[pid];
+
+  processData.process = &process;
+  processData.priority = priority;
+  processData.state = SUSPENDED;
+  processData.resident = true;
+
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    processData.vruntime = implementation->minVruntime;
+  #endif
+
+  implementation->claimPid(pid);
+
+  return pid;
+}
+
+int Scheduler::registerIdleTask(Runnable &task) {
+  if(implementation->idleTaskCount >= MAX_IDLE_TASKS) {
+    return -1;
+  }
+
+  implementation->idleTasks[implementation->idleTaskCount++] = &task;
+
+  return 0;
+}
+
+long Scheduler::getPollPass() const {
+  return implementation->polling ? implementation->pollPass : -1;
+}
+
+int Scheduler::getCpuLoad() const {
+  return implementation->cpuLoad;
 }
 
 void Scheduler::yield() {
   implementation->reschedule();
 }
 
+bool Scheduler::shouldYield() const {
+  // Signed difference so the comparison survives the cycle counter wrapping.
+  if((int32_t) (cycleCount() - implementation->quantumEnd) < 0) {
+    return false;
+  }
+
+  return implementation->hasPreemptingProcess();
+}
+
 int Scheduler::ready(const int pid) {
-  ProcessData readyProcess = implementation->ptable[pid];
+  if(pid < 0 || pid >= MAX_PROCESSES) {
+    return -1;
+  }
+
+  ProcessData &readyProcess = implementation->ptable[pid];
+
+  if(readyProcess.resident && readyProcess.state == READY) {
+    return 0;
+  }
+
+  if(readyProcess.resident && readyProcess.state != SUSPENDED) {
+    // The process is executing (or is blocked while executing), so it executes again once it finishes.
+    readyProcess.woken = true;
+
+    return 0;
+  }
 
   if(readyProcess.state != SUSPENDED) {
     return -1;
   }
 
-  readyProcess.state = READY;
-  implementation->readyList.enqueue(pid, readyProcess.priority);
+  implementation->enqueueReady(pid);
+
+  // Like a newly scheduled process, a process woken before the Scheduler has taken control waits for it to start.
+  if(!implementation->started) {
+    return 0;
+  }
 
-  if(readyProcess.priority > implementation->ptable[implementation->currentPid].priority) {
+  if(implementation->currentPid < 0 || implementation->precedes(pid, implementation->currentPid, false)) {
     implementation->reschedule();
   }
 
@@ -277,17 +822,72 @@ int Scheduler::ready(const int pid) {
 
 int Scheduler::sleep(const int delay) {
   #ifdef SCHEDULER_ENABLE_CLOCK
+    if(implementation->currentPid < 0) {
+      return -1;
+    }
+
+    implementation->advanceClock();
     implementation->sleepingList.insert(implementation->currentPid, delay);
     implementation->ptable[implementation->currentPid].state = SLEEPING;
 
     implementation->reschedule();
+
+    return 0;
   #else
     return -1;
   #endif
 }
 
+int Scheduler::await(Pollable &condition, const int timeout) {
+  const unsigned long start = millis();
+  const int pid = implementation->currentPid;
+
+  if(condition.poll()) {
+    return 0;
+  }
+
+  if(pid < 0) {
+    // There is no process to suspend, so all we can do is wait.
+    while(!condition.poll()) {
+      if(timeout >= 0 && (millis() - start) >= (unsigned long) timeout) {
+        return -2;
+      }
+
+      delay(0);
+    }
+
+    return 0;
+  }
+
+  if(implementation->waiterCount >= MAX_PROCESSES) {
+    return -1;
+  }
+
+  ProcessData &process = implementation->ptable[pid];
+  Waiter &waiter = implementation->waiters[implementation->waiterCount++];
+
+  waiter.pid = pid;
+  waiter.condition = &condition;
+  waiter.start = start;
+  waiter.timeout = timeout;
+
+  implementation->chargeRuntime();
+  process.state = WAITING;
+
+  // Keep executing other processes until the condition holds.  The Scheduler marks this process READY once it does.
+  while(process.state == WAITING) {
+    implementation->reschedule();
+  }
+
+  // The time spent waiting should not be charged to the process.
+  implementation->chargeRuntime();
+  process.state = EXECUTING;
+
+  return process.waitResult;
+}
+
 int Scheduler::suspend(const int pid) {
-  ProcessData suspendedProcess = implementation->ptable[pid];
+  ProcessData &suspendedProcess = implementation->ptable[pid];
 
   if(suspendedProcess.state != READY && suspendedProcess.state != EXECUTING) {
     return -1;
@@ -300,37 +900,22 @@ int Scheduler::suspend(const int pid) {
   } else {
     suspendedProcess.state = SUSPENDED;
 
-    implementation->reschedule();
+    // A process that was preempted stops once it resumes; only the current process gives up the MCU now.
+    if(pid == implementation->currentPid) {
+      implementation->reschedule();
+    }
   }
 
   return 0;
 }
 
 int Scheduler::kill() {
-  implementation->ptable[implementation->currentPid] = { 0 };
+  implementation->ptable[implementation->currentPid] = ProcessData();
 
   return 0;
 }
 
 void Scheduler::tick() {
-  DeltaList<int> sleepingList = implementation->sleepingList;
-
-  sleepingList.decrement();
-
-  if(sleepingList.peek().delta > 0) {
-    return;
-  }
-
-  ProcessData *ptable = implementation->ptable;
-  PriorityQueue<int> readyList = implementation->readyList;
-
-  while(sleepingList.peek().delta <= 0) {
-    delay(0);
-
-    int awokenPid = sleepingList.remove();
-
-    readyList.enqueue(awokenPid, ptable[awokenPid].priority);
-  }
-
+  // The clock follows `millis()`, so a tick only checks it early.
   implementation->reschedule();
 }
@@ -8,6 +8,7 @@
   #define _SL_SCHEDULER_SCHEDULER
 
   #include "../scheduler/Runnable.h"
+  #include "../scheduler/Pollable.h"
 
   // A semi-random maximum number of threads allowed to be scheduled at any given time.  If you need this many threads, you
   // may want to reconsider your design.
@@ -18,6 +19,22 @@
   // milliseconds.
   #define MIN_INTERVAL    3
 
+  // The number of CPU cycles a process is granted per level of priority each time it is dispatched.  A process with a priority
+  // of 3 will have a quantum of 3 * QUANTUM_CYCLES cycles.  The default is roughly 1 millisecond on an ESP8266 running at 80MHz.
+  // On MCUs without a cycle counter, the quantum is measured in microseconds instead.
+  #define QUANTUM_CYCLES  80000
+
+  // The maximum number of idle tasks that can be registered with the Scheduler.
+  #define MAX_IDLE_TASKS  8
+
+  // The number of milliseconds over which the CPU load is measured.
+  #define LOAD_WINDOW     1000
+
+  // When the macro SCHEDULER_POLICY_FAIR_SHARE is defined, the number of microseconds of virtual runtime a process that has
+  // been waiting (e.g. sleeping or suspended) may be credited relative to the process that has run the least.  Larger values
+  // favor processes that wake up infrequently.
+  #define FAIR_SHARE_WAKEUP_CREDIT  10000
+
   /**
    * Represents the current state of a Process.
    */
@@ -26,7 +43,8 @@
     READY,      /* The Thread is ready and waiting to execute. */
     EXECUTING,  /* The Thread is executing. */
     SLEEPING,   /* The Thread is currently waiting for a delay to expire before it should execute. */
-    SUSPENDED   /* The Thread is not ready to execute, but still needs to execute. */
+    SUSPENDED,  /* The Thread is not ready to execute, but still needs to execute. */
+    WAITING     /* The Thread is waiting for a Pollable condition to hold. */
   };
 
   /**
@@ -60,27 +78,60 @@
    * are defining long running processes that never exit, this library is not for you as your stack could quickly run out.
    *
    * By default, the Scheduler does not support making processes sleep or scheduling processes that should be executed at
-   * a regular interval.  To support such behavior,
-   *    1. The MCU must support interrupts that occur at a regular basis or the external code must be able to spoof such
-   *       behavior
-   *    2. The macro SCHEDULER_ENABLE_CLOCK must be defined
-   *    3. `Scheduler.getInstance().tick()` must be called every milliseconds
-   * If the above conditions are not met, attempting to cause a process to sleep or scheduling a process to execute at a
+   * a regular interval.  To support such behavior, the macro SCHEDULER_ENABLE_CLOCK must be defined.  The Scheduler then
+   * checks `millis()` on every pass and wakes the sleeping processes whose delay has passed, so no clock interrupt is
+   * needed.  If the macro is not defined, attempting to cause a process to sleep or scheduling a process to execute at a
    * regular interval will fail.
+   *
+   * By default, the Scheduler always executes the READY process with the highest priority.  If starvation is a concern, the
+   * macro SCHEDULER_POLICY_FAIR_SHARE can be defined to use weighted fair sharing instead.  Under this policy, each process
+   * accrues virtual runtime while it executes at a rate inversely proportional to its priority, and the READY process with the
+   * least virtual runtime executes next.  Since the processes that are executing accrue virtual runtime while waiting processes
+   * do not, waiting processes age and are guaranteed to eventually execute.  Higher priority processes still receive a larger
+   * share of the MCU.
+   *
+   * When no process is READY, the Scheduler executes its idle tasks instead of simply spinning.  Idle tasks are for deferred,
+   * background work that should only use spare cycles (e.g. compacting flash, aggregating metrics, or flushing logs).  See
+   * `registerIdleTask()`.
+   *
+   * Most firmware only needs the default Scheduler returned by `getInstance()`.  However, Schedulers are independent of one
+   * another, so several can be created when necessary (e.g. to simulate many devices in a single host process or to give each
+   * worker thread its own run loop).  Code that needs to access the Scheduler executing it without having one passed in
+   * should use `current()`.
    */
   class Scheduler {
     public:
+      Scheduler();
+      ~Scheduler();
+
       Scheduler(Scheduler const &scheduler) = delete;
       void operator=(Scheduler const &scheduler) = delete;
     
       /**
-       * Returns an instance of the Scheduler.  This instance may or may not be the only Scheduler available; however, it
-       * can be assumed that the the instance returned will be coordinated with any other instances that may exist.
+       * Returns the default instance of the Scheduler.  This is the Scheduler firmware should use unless it explicitly needs
+       * multiple Schedulers.
        * 
-       * @return (Scheduler) an instance of Scheduler
+       * @return (Scheduler) the default instance of Scheduler
        */
       static Scheduler &getInstance();
 
+      /**
+       * Returns the Scheduler currently executing on this thread.  While a Scheduler is dispatching processes (see `start()`
+       * and `step()`), it is the current Scheduler.  Otherwise, the current Scheduler is the Scheduler last set using
+       * `setCurrent()` or, if none has been set, the default instance returned by `getInstance()`.
+       *
+       * @return (Scheduler &) the current Scheduler for this thread
+       */
+      static Scheduler &current();
+
+      /**
+       * Sets the current Scheduler for this thread.  This is only necessary if code outside of a process needs `current()` to
+       * return a Scheduler other than the default instance.
+       *
+       * @param scheduler (Scheduler &) - the Scheduler that should be returned by `current()` on this thread
+       */
+      static void setCurrent(Scheduler &scheduler);
+
       /**
        * Returns the PID of the currently executing process.  If no process is currently executing, -1 will be returned.  This
        * can occur, for example, if the method is invoked outside of `start()`.
@@ -90,12 +141,12 @@
       const int getCurrentPid() const;
 
       /**
-       * Schedules a new process to be executed.  If MAX_PROCESSES processes have been scheduled, a nonzero value will be
+       * Schedules a new process to be executed once.  Once the process finishes executing, it is removed from the Scheduler and
+       * its PID can be assigned to another process.  If MAX_PROCESSES processes have been scheduled, a nonzero value will be
        * returned and the process will not be scheduled to execute.
        *
-       * Any given process should only be scheduled once.  The only exception is when a process is scheduled using
-       * `scheduleInterval()` and a positive integer has been specified for `repetitions`.  In this case, the process can be
-       * re`schedule`d once it has completed all repetitions.
+       * Any given process should only be scheduled once at a time.  A process that should execute every time some event occurs
+       * should be scheduled using `scheduleSuspended()` and woken using `ready()` rather than being scheduled for each event.
        * 
        * @param process (Runnable &) - the process to add to the Scheduler
        * @param priority (const int) - the priority of the new process.  This value must be between 1 and 15.  A higher value
@@ -119,10 +170,7 @@
        * If MAX_PROCESSES processes have been scheduled, a nonzero value will be returned and the process will not be scheduled to
        * execute.
        *
-       * For this method to work, the embedded system must have a clock and support hardware interrupts for the clock.  If
-       * both of these conditions are met the the user wishes to use sleeping capabilities, s/he must register an interrupt
-       * for the clock that occurs every millisecond and call the Scheduler's `tick()` method.  Once these conditions are met,
-       * SCHEDULER_ENABLE_CLOCK macro must be defined to enable process sleeping.
+       * For this method to work, the SCHEDULER_ENABLE_CLOCK macro must be defined to enable process sleeping.
        *
        * @param process (Runnable &) - the process to add to the Scheduler
        * @param interval (int) - the interval at which the Thread should run, in milliseconds
@@ -136,19 +184,83 @@
        */
       int scheduleInterval(Runnable &process, const int interval, const int repetitions = 1, const int priority = 1);
 
+      /**
+       * Schedules a new process that executes each time it is woken using `ready()`.  The process starts SUSPENDED and, unlike a
+       * process scheduled using `schedule()`, returns to SUSPENDED each time it finishes executing, so it keeps its PID and never
+       * has to be scheduled again.  If the process is woken while it is executing, it executes once more after it finishes;
+       * therefore, a process can wake itself to execute again on the next pass of the Scheduler.
+       *
+       * If MAX_PROCESSES processes have been scheduled, a negative value will be returned and the process will not be scheduled.
+       *
+       * @param process (Runnable &) - the process to add to the Scheduler
+       * @param priority (const int) - the priority of the new process.  This value must be between 1 and 15.  A higher value
+       *  priority means the process should take precedence over other priorities of lower value.  Default: 1
+       *
+       * @returns (int) a positive integer representing the new process's PID if the process was successfully scheduled;
+       *  otherwise, a negative value will be returned
+       */
+      int scheduleSuspended(Runnable &process, const int priority = 1);
+
+      /**
+       * Registers a task that should be executed when no process is READY.  Idle tasks are executed one after another, in a
+       * round-robin fashion, and the Scheduler stops executing idle tasks as soon as a process is READY.  Therefore, each call
+       * to an idle task's `run()` should only perform a small amount of work.  Idle tasks that perform more work should check
+       * `shouldYield()`, which returns true while an idle task is executing iff a process is READY, and return as soon as it
+       * does.
+       *
+       * Idle tasks are not processes: they have no PID, cannot sleep, wait, or be suspended, and should never call `yield()`.
+       *
+       * @param task (Runnable &) - the task to execute when the Scheduler is idle
+       *
+       * @returns (int) 0 iff the task was registered; otherwise, a negative value if MAX_IDLE_TASKS tasks are already
+       *  registered
+       */
+      int registerIdleTask(Runnable &task);
+
+      /**
+       * Identifies the pass over the conditions of waiting processes that is in progress.  The conditions are polled one after
+       * another, so conditions that can all be checked by a single call (e.g. poll(2) for several sockets) can check all of them
+       * the first time one is polled in a pass and reuse the result for the rest of the pass.
+       *
+       * @returns (long) a number that differs from the previous pass's while the conditions of waiting processes are being
+       *  polled; otherwise, -1
+       */
+      long getPollPass() const;
+
+      /**
+       * Returns the CPU load measured over the last complete LOAD_WINDOW.  The CPU load is the percentage of time the Scheduler
+       * was executing processes.  Everything else is idle, including the time spent in idle tasks, the time given to the
+       * underlying OS, and the time between passes.
+       *
+       * @returns (int) the CPU load as a percentage between 0 and 100
+       */
+      int getCpuLoad() const;
+
       /**
        * Starts the Scheduler.  This should be executed at the end of the `setup()` method.
        */
       void start();
 
       /**
-       * Notifies the Scheduler that a millisecond has passed.  Any sleeping processes that should be awoken will be awoken
-       * and the scheduler will reschedule.
+       * Performs a single pass of the Scheduler, dispatching the next READY process, if any.  `start()` simply calls this method
+       * forever.  Calling this method directly allows several Schedulers to be driven from a single loop, such as when
+       * simulating many devices in one process.
+       *
+       * @returns (bool) true iff a process was dispatched
+       */
+      bool step();
+
+      /**
+       * Notifies the Scheduler that time has passed.  Any sleeping processes that should be awoken will be awoken and the
+       * scheduler will reschedule.  The Scheduler already checks the clock on every pass, so this is only necessary to wake
+       * sleeping processes while the current process keeps the MCU.
        */
       void tick();
 
       /**
-       * Marks the process identified by `pid` as ready to execute.
+       * Marks the process identified by `pid` as ready to execute.  A process scheduled using `scheduleSuspended()` that is
+       * already READY is left as is, and one that is executing will execute again once it finishes.  A process marked ready
+       * before the Scheduler has started waits for `start()` or `step()`.
        *
        * @param pid (const int) - the PID of the process to mark as `READY`
        *
@@ -161,10 +273,7 @@
        * process will begin execution immediately after the specified interval, but it will do its best to execute the process
        * as close to the specified time as possible.
        * 
-       * For this method to work, the embedded system must have a clock and support hardware interrupts for the clock.  If
-       * both of these conditions are met the the user wishes to use sleeping capabilities, s/he must register an interrupt
-       * for the clock that occurs every millisecond and call the Scheduler's `tick()` method.  Once these conditions are met,
-       * SCHEDULER_ENABLE_CLOCK macro must be defined to enable process sleeping.
+       * For this method to work, the SCHEDULER_ENABLE_CLOCK macro must be defined to enable process sleeping.
        *
        * @param interval (int) - the minimum milliseconds to pause the process
        *
@@ -179,6 +288,49 @@
        */
       void yield();
 
+      /**
+       * Returns whether the currently executing process should yield its control of the MCU.  This is true iff the process has
+       * exhausted its quantum and another process of equal or higher priority is READY.  If SCHEDULER_POLICY_FAIR_SHARE is
+       * defined, a READY process with no more virtual runtime than the current process is considered of equal or higher
+       * priority.  Each process is assigned a quantum proportional to its priority (see QUANTUM_CYCLES) when it is dispatched.
+       *
+       * Unlike `yield()`, this method does not give the underlying OS a chance to execute and does not reschedule.  Until the
+       * quantum expires, it costs a single comparison against the cycle counter, so long running processes (e.g. parsing loops)
+       * can call it on every iteration and only call `yield()` when it returns true:
+       *
+       *    while(hasMoreWork()) {
+       *      doSomeWork();
+       *
+       *      if(scheduler.shouldYield()) {
+       *        scheduler.yield();
+       *      }
+       *    }
+       *
+       * While an idle task is executing, this method returns true iff a process is READY.
+       *
+       * @returns (bool) true iff the current process should call `yield()`
+       */
+      bool shouldYield() const;
+
+      /**
+       * Suspends the current process until `condition` holds or `timeout` milliseconds have passed.  While the process waits,
+       * other processes are executed and the process itself does not consume any time.  The conditions of all waiting processes
+       * are polled once per pass of the Scheduler, so a waiting process resumes within a single pass of its condition holding.
+       *
+       * Since processes share a single stack, a waiting process can only resume once every process dispatched while it was
+       * waiting has yielded control back to it.
+       *
+       * If this method is called outside of a process (e.g. before the Scheduler has started), it will busy-wait on
+       * `condition` instead.
+       *
+       * @param condition (Pollable &) - the condition the process should wait on
+       * @param timeout (const int) _optional_ - the maximum number of milliseconds to wait.  A negative value will wait
+       *  indefinitely.  Default: -1
+       *
+       * @returns (int) 0 iff the condition holds; -1 if the process could not wait; -2 if the timeout was reached first
+       */
+      int await(Pollable &condition, const int timeout = -1);
+
       /**
        * Suspends the process identified by `pid`.  A suspended process will not be scheduled to execute until it is unsuspended.
        *
@@ -207,9 +359,6 @@
     private:
       class SchedulerImplementation;
 
-      Scheduler();
-      ~Scheduler();
-      
       SchedulerImplementation *implementation;
   };
 
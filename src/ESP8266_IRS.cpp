@@ -12,177 +12,147 @@
 // void function pointer type
 typedef void (*voidFunc)();
 
-// Mask to record if a specific pin has been triggered.  A 1 bit means the pin was triggered.
-uint8_t interruptMask = 0;
-
-// Bitmask to find the bit that corresponds to a specific pin.
-const int PIN0_MASK = 0x1;
-const int PIN2_MASK = 0x2;
-const int PIN4_MASK = 0x4;
-const int PIN5_MASK = 0x8;
-const int PIN12_MASK = 0x10;
-const int PIN13_MASK = 0x20;
-const int PIN14_MASK = 0x40;
-const int PIN15_MASK = 0x80;
-
-// A noop function for invalid pins. Alternatives to this include returning a flag for invalid
-// pins or throwing an error.
-void noop() {}
-
-/* The IRSs for the various pins supported by ESP8266. */
-void pin0InterruptHandler() {
-  interruptMask |= PIN0_MASK;
-}
+// Mask to record if a specific pin has been triggered.  Bit n is set iff GPIO n was triggered.  The mask is only
+// modified by an IRS or while interrupts are disabled, so reads and updates are atomic with respect to the IRSs.
+static volatile uint32_t interruptMask = 0;
+
+// A ring buffer of captured interrupt events.  The IRSs are the only producer and `drainInterruptEvents()` is the
+// only consumer.  Since the IRSs cannot interrupt each other, each index is only ever written by one side and no
+// locking is required.
+static volatile InterruptEvent interruptEvents[INTERRUPT_EVENT_CAPACITY];
+static volatile uint32_t eventHead = 0;     // The total number of events captured.  Only written by the IRSs.
+static volatile uint32_t eventTail = 0;     // The total number of events drained.  Only written by the consumer.
+static volatile uint32_t eventOverflow = 0; // The total number of events dropped.  Only written by the IRSs.
+
+/**
+ * The IRS for pin.  A single IRS is instantiated for each pin that supports interrupts at compile time, so no
+ * lookup is required when the interrupt occurs.
+ */
+template<uint8_t pin>
+void ICACHE_RAM_ATTR pinInterruptHandler() {
+  const uint32_t timestamp = micros();
+  const uint32_t head = eventHead;
 
-void pin2InterruptHandler() {
-  interruptMask |= PIN2_MASK;
-}
+  interruptMask |= INTERRUPT_MASK(pin);
 
-void pin4InterruptHandler() {
-  interruptMask |= PIN4_MASK;
-}
+  if(head - eventTail >= INTERRUPT_EVENT_CAPACITY) {
+    eventOverflow = eventOverflow + 1;
 
-void pin5InterruptHandler() {
-  interruptMask |= PIN5_MASK;
-}
+    return;
+  }
 
-void pin12InterruptHandler() {
-  interruptMask |= PIN12_MASK;
-}
+  volatile InterruptEvent &event = interruptEvents[head & (INTERRUPT_EVENT_CAPACITY - 1)];
 
-void pin13InterruptHandler() {
-  interruptMask |= PIN13_MASK;
-}
+  event.timestamp = timestamp;
+  event.pin = pin;
+  event.edge = (digitalRead(pin) == HIGH) ? EDGE_RISING : EDGE_FALLING;
 
-void pin14InterruptHandler() {
-  interruptMask |= PIN14_MASK;
+  // Publish the event only once it has been fully written.
+  eventHead = head + 1;
 }
 
-void pin15InterruptHandler() {
-  interruptMask |= PIN15_MASK;
+/**
+ * PinDescriptor describes how a GPIO can be used with the interrupt layer.
+ */
+struct PinDescriptor {
+  voidFunc handler;   // The IRS for the pin or NULL if the pin does not support interrupts.
+};
+
+// Descriptors for each GPIO, indexed by GPIO number.  GPIOs 6-11 are connected to flash and GPIO 16 does not
+// support interrupts.
+static constexpr PinDescriptor PIN_DESCRIPTORS[GPIO_COUNT] = {
+  { pinInterruptHandler<0> },
+  { pinInterruptHandler<1> },
+  { pinInterruptHandler<2> },
+  { pinInterruptHandler<3> },
+  { pinInterruptHandler<4> },
+  { pinInterruptHandler<5> },
+  { NULL },
+  { NULL },
+  { NULL },
+  { NULL },
+  { NULL },
+  { NULL },
+  { pinInterruptHandler<12> },
+  { pinInterruptHandler<13> },
+  { pinInterruptHandler<14> },
+  { pinInterruptHandler<15> },
+  { NULL }
+};
+
+/**
+ * Returns whether pin supports interrupts.
+ *
+ * @param pin (int) - the pin to check
+ *
+ * @return (bool) true iff pin supports interrupts
+ */
+static inline bool supportsInterrupt(int pin) {
+  return (pin >= 0 && pin < GPIO_COUNT && PIN_DESCRIPTORS[pin].handler != NULL);
 }
 
 /* Public Interface */
 
 bool triggeredInterrupt(int pin) {
-  uint8_t bitMask = 0;
-
-  switch(pin) {
-    case 0:
-      bitMask = PIN0_MASK;
-      break;
-
-    case 2:
-      bitMask = PIN2_MASK;
-      break;
-
-    case 4:
-      bitMask = PIN4_MASK;
-      break;
-
-    case 5:
-      bitMask = PIN5_MASK;
-      break;
-
-    case 12:
-      bitMask = PIN12_MASK;
-      break;
-
-    case 13:
-      bitMask = PIN13_MASK;
-      break;
-
-    case 14:
-      bitMask = PIN14_MASK;
-      break;
-
-    case 15:
-      bitMask = PIN15_MASK;
-      break;
+  if(!supportsInterrupt(pin)) {
+    return false;
   }
 
-  return (interruptMask & bitMask);
+  return (interruptMask & INTERRUPT_MASK(pin));
 }
 
 void resetInterrupt(int pin) {
-  uint8_t bitMask = 0xFF;
-
-  switch(pin) {
-    case 0:
-      bitMask = !PIN0_MASK;
-      break;
-
-    case 2:
-      bitMask = !PIN2_MASK;
-      break;
-
-    case 4:
-      bitMask = !PIN4_MASK;
-      break;
+  if(!supportsInterrupt(pin)) {
+    return;
+  }
 
-    case 5:
-      bitMask = !PIN5_MASK;
-      break;
+  clearMask(INTERRUPT_MASK(pin));
+}
 
-    case 12:
-      bitMask = !PIN12_MASK;
-      break;
+uint32_t pendingMask() {
+  // Aligned 32-bit reads are atomic.
+  return interruptMask;
+}
 
-    case 13:
-      bitMask = !PIN13_MASK;
-      break;
+void clearMask(uint32_t mask) {
+  // Clearing is a read-modify-write, so an interrupt must not be able to set a bit in the middle of it.
+  uint32_t savedState = xt_rsil(15);
 
-    case 14:
-      bitMask = !PIN14_MASK;
-      break;
+  interruptMask &= ~mask;
 
-    case 15:
-      bitMask = !PIN15_MASK;
-      break;
-  }
-
-  interruptMask &= bitMask;
+  xt_wsr_ps(savedState);
 }
 
-void registerInterruptHandler(int pin, int mode) {
-  voidFunc handler;
-
-  switch(pin) {
-    case 0:
-      handler = pin0InterruptHandler;
-      break;
-
-    case 2:
-      handler = pin2InterruptHandler;
-      break;
+int drainInterruptEvents(InterruptEvent *events, int maxEvents) {
+  const uint32_t head = eventHead;
+  uint32_t tail = eventTail;
+  int eventCount = 0;
 
-    case 4:
-      handler = pin4InterruptHandler;
-      break;
+  while(tail != head && eventCount < maxEvents) {
+    volatile InterruptEvent &event = interruptEvents[tail & (INTERRUPT_EVENT_CAPACITY - 1)];
 
-    case 5:
-      handler = pin5InterruptHandler;
-      break;
+    events[eventCount].timestamp = event.timestamp;
+    events[eventCount].pin = event.pin;
+    events[eventCount].edge = event.edge;
 
-    case 12:
-      handler = pin12InterruptHandler;
-      break;
+    eventCount++;
+    tail++;
+  }
 
-    case 13:
-      handler = pin13InterruptHandler;
-      break;
+  // Release the slots back to the IRSs only once they have been copied.
+  eventTail = tail;
 
-    case 14:
-      handler = pin14InterruptHandler;
-      break;
+  return eventCount;
+}
 
-    case 15:
-      handler = pin15InterruptHandler;
-      break;
+uint32_t interruptOverflowCount() {
+  return eventOverflow;
+}
 
-    default:
-      handler = noop;
+void registerInterruptHandler(int pin, int mode) {
+  if(!supportsInterrupt(pin)) {
+    return;
   }
 
-  attachInterrupt(digitalPinToInterrupt(pin), handler, mode);
+  attachInterrupt(digitalPinToInterrupt(pin), PIN_DESCRIPTORS[pin].handler, mode);
 }
@@ -8,6 +8,35 @@
 #ifndef SL_IRS_H_
   #define SL_IRS_H_
 
+  #include <stdint.h>
+
+  // The total number of GPIOs on the MCU.  Interrupt flags are stored in a mask with one bit per GPIO.
+  #define GPIO_COUNT  17
+
+  // Returns the bit in an interrupt mask (see `pendingMask()`) that corresponds to pin.
+  #define INTERRUPT_MASK(pin)  (1UL << (pin))
+
+  // The maximum number of interrupt events that can be captured before they are drained.  This must be a power
+  // of 2.
+  #define INTERRUPT_EVENT_CAPACITY  32
+
+  /**
+   * InterruptEdge enumerates the edges that can trigger an interrupt.
+   */
+  enum InterruptEdge {
+    EDGE_FALLING = 0, // The pin transitioned from HIGH to LOW.
+    EDGE_RISING = 1   // The pin transitioned from LOW to HIGH.
+  };
+
+  /**
+   * InterruptEvent records a single hardware interrupt as captured by the IRS.
+   */
+  struct InterruptEvent {
+    uint32_t timestamp; // The value of `micros()` when the interrupt occurred.
+    uint8_t pin;        // The pin that caused the interrupt.
+    uint8_t edge;       // The InterruptEdge that caused the interrupt, determined by the pin's level in the IRS.
+  };
+
   /**
    * Returns whether the specified pin was the cause of a hardware interrupt since the last time the pin was
    * reset.
@@ -26,7 +55,47 @@
   void resetInterrupt(int pin);
 
   /**
-   * Registers an interrupt handler (or IRS) to listen for HW interrupts caused by pin.
+   * Returns a mask of every pin that caused a hardware interrupt since it was last reset.  Bit n of the mask
+   * (i.e. `INTERRUPT_MASK(n)`) is set iff GPIO n caused an interrupt.  This allows every pending pin to be
+   * serviced in one pass instead of checking each pin with `triggeredInterrupt()`.
+   *
+   * @return (uint32_t) the mask of pins with a pending interrupt
+   */
+  uint32_t pendingMask();
+
+  /**
+   * Atomically resets whether each pin in mask caused a hardware interrupt.  Pins not in mask are unaffected,
+   * even if they cause an interrupt while the mask is being cleared.
+   *
+   * @param mask (uint32_t) - the mask of pins to reset, in the same format returned by `pendingMask()`
+   */
+  void clearMask(uint32_t mask);
+
+  /**
+   * Removes up to maxEvents captured interrupt events and copies them to events, oldest first.  Every interrupt
+   * is captured with the time it occurred, so repeated interrupts are not collapsed and events can be ordered
+   * precisely even if they are drained long after they occurred.
+   *
+   * If more than INTERRUPT_EVENT_CAPACITY events occur before they are drained, the newest events are dropped
+   * and counted by `interruptOverflowCount()`.  Draining events does not affect `pendingMask()`.
+   *
+   * @param events (InterruptEvent *) - a buffer with a capacity of at least maxEvents events
+   * @param maxEvents (int) - the maximum number of events to drain
+   *
+   * @return (int) the number of events copied to events
+   */
+  int drainInterruptEvents(InterruptEvent *events, int maxEvents);
+
+  /**
+   * Returns the total number of interrupt events dropped because the capture buffer was full.
+   *
+   * @return (uint32_t) the total number of dropped interrupt events
+   */
+  uint32_t interruptOverflowCount();
+
+  /**
+   * Registers an interrupt handler (or IRS) to listen for HW interrupts caused by pin.  Pins that do not support
+   * interrupts (e.g. those reserved for flash) are ignored.
    *
    * @param pin (int) - the pin for which IRS should be registered
    * @param mode (int) - defines when the interrupt should be triggered. The values are defined in the
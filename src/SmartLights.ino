@@ -2,16 +2,31 @@
  * Simple IoT light controller.  
  */
 
+#include <EEPROM.h>
 #include <ESP8266WiFi.h>
 
 #include "../lib/scheduler/Runnable.h"
 #include "../lib/scheduler/Scheduler.h"
 
+#include "../lib/infrastructure/BootTimeline.h"
 #include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/InputFilter.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "../lib/infrastructure/Sensor.h"
+#include "../lib/infrastructure/SensorRegistry.h"
 #include "../lib/infrastructure/SensorType.h"
+#include "../lib/infrastructure/WiFiLink.h"
+#include "../lib/infrastructure/ZoneAggregator.h"
 
 #include "IRS.h"
 
+// The time, in milliseconds, each polled process sleeps between runs.  The Coordinator and sensors are checked often so
+// responses and edges are handled promptly; the network and zones only change on a human timescale.
+#define COORDINATOR_INTERVAL  5
+#define SENSORS_INTERVAL      5
+#define NETWORK_INTERVAL      100
+#define ZONES_INTERVAL        100
+
 //class Coordinator: public Runnable {
 //  public:
 //    Coordinator() {
@@ -35,88 +50,114 @@
 //    }
 //};
 
-class MotionSensor: public Runnable {
+/**
+ * Feeds the SensorRegistry the edges captured by the ESP8266 interrupt layer.
+ */
+class InterruptEdgeSource: public EdgeSource {
   public:
-    MotionSensor(Coordinator &coordinator, const int pin = 12): coordinator(coordinator), pin(pin), sid(coordinator.registerSensor(INFRARED_MOTION)) {
-      registerInterruptHandler(pin, MotionSensor::mode);
-    }
+    int drain(SensorEdge *edges, int maxEdges) {
+      InterruptEvent events[SENSOR_EDGE_BATCH];
 
-    int run() {
-      bool motionDetected = triggeredInterrupt(pin);
+      if(maxEdges > SENSOR_EDGE_BATCH) {
+        maxEdges = SENSOR_EDGE_BATCH;
+      }
+
+      const int eventCount = drainInterruptEvents(events, maxEdges);
 
-      if(!motionDetected) {
-        return 0;
+      for(int eventIndex = 0; eventIndex < eventCount; eventIndex++) {
+        edges[eventIndex].timestamp = events[eventIndex].timestamp;
+        edges[eventIndex].pin = events[eventIndex].pin;
+        edges[eventIndex].level = (events[eventIndex].edge == EDGE_RISING);
       }
 
-//      coordinator.update();
-      resetInterrupt(pin);
+      return eventCount;
+    }
+};
+
+/**
+ * Writes the updates the Coordinator spilled to EEPROM during an outage to flash.  A flash write keeps the MCU for several
+ * milliseconds, so it is done while every process is sleeping rather than in the middle of sending.
+ */
+class SpillSync: public Runnable {
+  public:
+    SpillSync(Coordinator &coordinator): coordinator(coordinator) {}
+
+    int run() {
+      coordinator.sync();
 
       return 0;
     }
 
   private:
-    static const auto mode = HIGH;
-
-    const int pin;
-    const int sid;
-
     Coordinator &coordinator;
 };
 
-/**
- * Raises base to the exponent-th power and returns the result.
- * 
- * @param base (double) - the value of the base
- * @param exponent (double) - the value of the exponent
- * 
- * @returns (double) the result of base^exponent
- */
-double power(double base, double exponent) {
-  int result = 1;
-
-  if(exponent >= 0) {
-    while(exponent-- > 0) {
-      result *= base;
+class MotionSensor: public Sensor {
+  public:
+    MotionSensor(ZoneAggregator &zones, const int pin = 12): Sensor(INFRARED_MOTION, SENSOR_INTERRUPT, pin), zones(zones),
+        filter(MotionSensor::FILTER_CONFIG) {
+      setFilter(&filter);
+      registerInterruptHandler(pin, MotionSensor::mode);
     }
-  } else {
-    while(exponent++ < 0) {
-      result /= base;
+
+    void onChange(uint32_t timestamp, FilterResult change) {
+      if(change != FILTER_ON && change != FILTER_RETRIGGER) {
+        return;
+      }
+
+      zones.reportMotion(getId());
     }
-  }
 
-  return result;
-}
+  private:
+    static const auto mode = CHANGE;
+
+    // PIR sensors hold their output for a couple of seconds and retrigger frequently while somebody is moving, so only report
+    // new motion every 5 seconds.
+    static constexpr FilterConfig FILTER_CONFIG = { 20000, 50000, 500000, 5000000, 0 };
+
+    ZoneAggregator &zones;
+    InputFilter filter;
+};
+
+constexpr FilterConfig MotionSensor::FILTER_CONFIG;
 
 /**
  * Performs all necessary initialization for the system.  This includes:
- *  - Creating a connection to a network
+ *  - Starting to connect to the network.  The network comes up in the background so sensors are armed immediately.
  *  - Creating a Coordinator, Sensors, and all output.
  *  - Initializing and starting the Scheduler.
  */
 void setup() {
-  // Setup the network.
-  WiFi.mode(WIFI_STA);
-  WiFi.begin("Waylon-guest", "cranberry33");
-
-  const int base = 250;
-  int attempts = 0;
-  
-  while(WiFi.status() != WL_CONNECTED) {
-    if(attempts < 8) {
-      delay(power(2, attempts) * base);
-    } else {
-      delay(30000);
-    }
-
-    attempts++;
-  }
+  EEPROM.begin(EEPROM_SIZE);
 
   Scheduler &scheduler = Scheduler::getInstance();
-  Coordinator coordinator = Coordinator();
-  MotionSensor motionSensor = MotionSensor(coordinator);
 
-  scheduler.schedule(coordinator);
-  scheduler.schedule(motionSensor);
+  WiFiLink network("Waylon-guest", "cranberry33", WIFI_CACHE_ADDRESS);
+  network.begin();
+
+  Coordinator coordinator;
+
+  InterruptEdgeSource edges;
+  SensorRegistry sensors(coordinator, edges);
+  ZoneAggregator zones(coordinator);
+  MotionSensor motionSensor(zones);
+
+  // Every sensor on this device covers the same room.  Consider it vacant after 2 minutes without motion.
+  const int room = zones.addZone(120000);
+
+  zones.assign(sensors.add(motionSensor), room);
+
+  SpillSync spillSync(coordinator);
+
+  // The network, Coordinator, sensors, and zones are all polled.  Each sleeps between runs, so the Scheduler is idle, and
+  // executes its idle tasks, whenever none of them has anything to do.
+  scheduler.scheduleInterval(network, NETWORK_INTERVAL, -1);
+  scheduler.scheduleInterval(coordinator, COORDINATOR_INTERVAL, -1);
+  scheduler.scheduleInterval(sensors, SENSORS_INTERVAL, -1);
+  scheduler.scheduleInterval(zones, ZONES_INTERVAL, -1);
+  scheduler.registerIdleTask(spillSync);
+
+  recordBootEvent(BOOT_SCHEDULER_START);
 
   scheduler.start();
 }
@@ -0,0 +1,163 @@
+/*
+ * ClientInterestTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/ClientInterest.h"
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The time, in milliseconds, before the peer writes to the connection.
+#define PEER_WRITE 50
+
+// The time, in milliseconds, before the peer closes the connection.
+#define PEER_CLOSE 100
+
+// The time, in milliseconds, the process waits for data that never arrives.
+#define SILENT_TIMEOUT 20
+
+/**
+ * ClientWaiter waits for the events of a connection in turn, as a process parsing a response from the Master node would: the
+ * connection first stays quiet, then data arrives, then the peer closes it.
+ */
+class ClientWaiter: public Runnable {
+  public:
+    ClientWaiter(Scheduler &scheduler, WiFiClient &client): scheduler(scheduler), client(client) { }
+
+    int run() {
+      ClientInterest connected(client, CLIENT_CONNECTED);
+      ClientInterest writable(client, CLIENT_WRITABLE);
+      ClientInterest readable(client, CLIENT_READABLE);
+
+      connectedResult = scheduler.await(connected, 0);
+      writableResult = scheduler.await(writable, 0);
+      silentResult = scheduler.await(readable, SILENT_TIMEOUT);
+
+      const unsigned long start = millis();
+
+      dataResult = scheduler.await(readable, 1000);
+      dataWait = millis() - start;
+      byte = client.read();
+
+      closeResult = scheduler.await(readable, 1000);
+      closed = !client.connected();
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    WiFiClient &client;
+    int connectedResult = 1;
+    int writableResult = 1;
+    int silentResult = 1;
+    int dataResult = 1;
+    int closeResult = 1;
+    unsigned long dataWait = 0;   // The time, in milliseconds, the process waited for the data.
+    int byte = -1;
+    bool closed = false;
+};
+
+/**
+ * SpinningProcess stands in for the rest of the device's processes.  It executes whenever the waiting process leaves it the MCU.
+ */
+class SpinningProcess: public Runnable {
+  public:
+    SpinningProcess(Scheduler &scheduler): scheduler(scheduler) { }
+
+    int run() {
+      executions++;
+
+      if(!done) {
+        scheduler.ready(pid);
+      }
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    int pid = -1;
+    unsigned long executions = 0;
+    bool done = false;
+};
+
+/**
+ * Runs a process waiting on a WiFiClient through ClientInterest, so the Scheduler polls the client on each pass while other
+ * processes execute.  The process must see the connection quiet, then readable once data arrives, then readable again once the
+ * peer closes it.
+ */
+int main() {
+  const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in address = {};
+  socklen_t length = sizeof(address);
+
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if(!CHECK(::bind(listener, (struct sockaddr *) &address, sizeof(address)) == 0) || !CHECK(::listen(listener, 1) == 0) ||
+      !CHECK(::getsockname(listener, (struct sockaddr *) &address, &length) == 0)) {
+    return testResult();
+  }
+
+  WiFiClient client;
+
+  if(!CHECK(client.connect(IPAddress(127, 0, 0, 1), ntohs(address.sin_port)))) {
+    return testResult();
+  }
+
+  const int peer = ::accept(listener, NULL, NULL);
+
+  Scheduler scheduler;
+  ClientWaiter waiter(scheduler, client);
+  SpinningProcess spinner(scheduler);
+
+  CHECK(scheduler.schedule(waiter, 1) >= 0);
+
+  spinner.pid = scheduler.scheduleSuspended(spinner, 1);
+
+  CHECK(scheduler.ready(spinner.pid) == 0);
+
+  std::thread writer([&]() {
+    const uint8_t byte = 42;
+
+    ::delay(PEER_WRITE);
+    ::write(peer, &byte, 1);
+    ::delay(PEER_CLOSE - PEER_WRITE);
+    ::close(peer);
+  });
+
+  // The waiting process is dispatched first and keeps the Scheduler busy with the other process until it is done.
+  scheduler.step();
+
+  spinner.done = true;
+
+  writer.join();
+
+  CHECK(waiter.connectedResult == 0);
+  CHECK(waiter.writableResult == 0);
+  CHECK(waiter.silentResult == -2);
+  CHECK(waiter.dataResult == 0);
+  CHECK(waiter.dataWait > 0);
+  CHECK(waiter.byte == 42);
+  CHECK(waiter.closeResult == 0);
+  CHECK(waiter.closed);
+
+  // The other process kept executing while the process waited.
+  CHECK(spinner.executions > 0);
+
+  printf("waited %lu ms for data while the other process executed %lu times\n", waiter.dataWait, spinner.executions);
+
+  ::close(listener);
+
+  return testResult();
+}
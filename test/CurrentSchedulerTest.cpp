@@ -0,0 +1,131 @@
+/*
+ * CurrentSchedulerTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <thread>
+
+#include <Arduino.h>
+
+#include "../lib/infrastructure/DCP/DCPCompletion.h"
+#include "../lib/infrastructure/DCP/DCPMailbox.h"
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The number of Schedulers running side by side, each on its own thread.
+#define SCHEDULER_COUNT 2
+
+// The longest time, in milliseconds, each Scheduler is given to execute its processes.
+#define RUN_TIME 1000
+
+/**
+ * Wakeup records the Scheduler that executed it each time it was woken.
+ */
+class Wakeup: public Runnable {
+  public:
+    int run() {
+      executions++;
+
+      if(&Scheduler::current() != expected) {
+        wrongScheduler++;
+      }
+
+      return 0;
+    }
+
+    Scheduler *expected = NULL;
+    unsigned long executions = 0;
+    unsigned long wrongScheduler = 0;
+};
+
+/**
+ * Requester stands in for a process that sends a request and subscribes to pushed messages.  It creates a DCPCompletion and a
+ * DCPMailbox without naming a Scheduler, then completes the request and delivers a message, as the Coordinator would once the
+ * Master node answers.
+ */
+class Requester: public Runnable {
+  public:
+    Requester(Scheduler &scheduler): scheduler(scheduler) {
+      callback.expected = &scheduler;
+      handler.expected = &scheduler;
+    }
+
+    ~Requester() {
+      delete completion;
+      delete mailbox;
+    }
+
+    int run() {
+      completion = new DCPCompletion(callback);
+      mailbox = new DCPMailbox(handler);
+
+      completion->complete(DCPResponse(SUCCESS), 1);
+      mailbox->deliver(DCPResponse(SUCCESS));
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    Wakeup callback;
+    Wakeup handler;
+    DCPCompletion *completion = NULL;
+    DCPMailbox *mailbox = NULL;
+};
+
+/**
+ * Runs a Requester on its own Scheduler until the callback and the handler have executed or RUN_TIME has elapsed.
+ *
+ * @param requester (Requester &) - the process to run
+ */
+static void runRequester(Requester &requester) {
+  const unsigned long start = millis();
+
+  requester.scheduler.schedule(requester, 1);
+
+  while((requester.callback.executions == 0 || requester.handler.executions == 0) && millis() - start < RUN_TIME) {
+    requester.scheduler.step();
+  }
+}
+
+/**
+ * Runs SCHEDULER_COUNT Schedulers side by side, each on its own thread.  A DCPCompletion or DCPMailbox created by a process
+ * without naming a Scheduler must wake its callback or handler on the Scheduler executing that process rather than on the
+ * default instance, which nothing executes here.
+ */
+int main() {
+  Scheduler schedulers[SCHEDULER_COUNT];
+  Requester *requesters[SCHEDULER_COUNT];
+  std::thread *threads[SCHEDULER_COUNT];
+
+  for(int index = 0; index < SCHEDULER_COUNT; index++) {
+    requesters[index] = new Requester(schedulers[index]);
+    threads[index] = new std::thread(runRequester, std::ref(*requesters[index]));
+  }
+
+  for(int index = 0; index < SCHEDULER_COUNT; index++) {
+    threads[index]->join();
+
+    const Requester &requester = *requesters[index];
+
+    printf("scheduler %d: callback executed %lu times, handler %lu times\n", index, requester.callback.executions,
+        requester.handler.executions);
+
+    CHECK(requester.completion != NULL && requester.completion->isComplete());
+    CHECK(requester.mailbox != NULL && requester.mailbox->count() == 1);
+    CHECK(requester.callback.executions == 1);
+    CHECK(requester.handler.executions == 1);
+    CHECK(requester.callback.wrongScheduler == 0);
+    CHECK(requester.handler.wrongScheduler == 0);
+
+    delete threads[index];
+  }
+
+  for(int index = 0; index < SCHEDULER_COUNT; index++) {
+    delete requesters[index];
+  }
+
+  return testResult();
+}
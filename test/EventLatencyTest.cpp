@@ -0,0 +1,160 @@
+/*
+ * EventLatencyTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "HostTest.h"
+#include "StandInMaster.h"
+
+// The number of events sent in each run.
+#define EVENTS 100
+
+// The time, in milliseconds, between events.
+#define EVENT_INTERVAL 10
+
+// The size, in bytes, of each bulk update sent alongside the events.
+#define BULK_SIZE 1000
+
+// The time, in microseconds, the stand-in Master node spends on each byte of a request, so a bulk update takes 20ms.
+#define BYTE_COST 20
+
+/**
+ * EventResult is the outcome of one run of events.
+ */
+struct EventResult {
+  std::vector<unsigned long> latencies; // The time, in microseconds, from sending each answered event to its response.
+  int unanswered;                       // The number of events that were not answered.
+};
+
+/**
+ * Sends EVENTS motion events, EVENT_INTERVAL milliseconds apart, and measures how long each takes to be answered.  With
+ * `bulk`, a bulk update is kept in flight on the persistent connection the whole time, the way a telemetry upload would be.
+ *
+ * @param coordinator (Coordinator &) - the Coordinator
+ * @param datagram (bool) - whether the events are sent as datagrams, with `sendEvent()`, or on the persistent connection, in the
+ *  urgent lane
+ * @param bulk (bool) - whether bulk updates are sent at the same time
+ *
+ * @return (EventResult) the latencies of the events
+ */
+static EventResult measure(Coordinator &coordinator, bool datagram, bool bulk) {
+  std::vector<DCPCompletion> completions(EVENTS);
+  std::vector<unsigned long> sentAt(EVENTS, 0);
+  std::vector<bool> answered(EVENTS, false);
+  EventResult result = { std::vector<unsigned long>(), 0 };
+
+  const std::string filler(BULK_SIZE, 'x');
+  const String bulkData(filler.c_str());
+  const unsigned long start = millis();
+  int sent = 0;
+
+  while(millis() - start < EVENTS * EVENT_INTERVAL + 1000) {
+    if(sent < EVENTS && millis() - start >= (unsigned long) sent * EVENT_INTERVAL) {
+      sentAt[sent] = micros();
+
+      if(datagram) {
+        coordinator.sendEvent(1, "motion=1", &completions[sent]);
+      } else {
+        coordinator.sendUpdate(1, "motion=1", &completions[sent], LANE_URGENT);
+      }
+
+      sent++;
+    }
+
+    if(bulk && sent < EVENTS && coordinator.getLaneDepth(LANE_BULK) == 0) {
+      coordinator.sendUpdate(2, bulkData, NULL, LANE_BULK);
+    }
+
+    coordinator.run();
+
+    for(int index = 0; index < sent; index++) {
+      if(!answered[index] && completions[index].isComplete()) {
+        answered[index] = true;
+
+        if(completions[index].getResponse().statusCode == SUCCESS_NOCONTENT) {
+          result.latencies.push_back(micros() - sentAt[index]);
+        }
+      }
+    }
+
+    yield();
+  }
+
+  result.unanswered = EVENTS - result.latencies.size();
+
+  // Let the last bulk update finish so the next run starts from an idle connection.
+  runUntil(coordinator, 1000, [&]() { return coordinator.getLaneDepth(LANE_BULK) == 0; });
+
+  return result;
+}
+
+/**
+ * Reports the latencies of a run.
+ *
+ * @param label (const char *) - what was measured
+ * @param result (const EventResult &) - the run
+ */
+static void report(const char *label, const EventResult &result) {
+  printf("%-26s p50 %6lu us   p99 %6lu us   unanswered %d\n", label, percentile(result.latencies, 50),
+      percentile(result.latencies, 99), result.unanswered);
+}
+
+/**
+ * Compares the latency of motion events sent as datagrams with events sent on the persistent connection, against a stand-in
+ * Master node on the loopback interface, both on an idle connection and behind bulk transfers.  Datagrams do not wait for the
+ * bulk update ahead of them on the connection, so they must be faster under load.
+ */
+int main() {
+  EEPROM.begin(EEPROM_SIZE);
+  WiFi.begin("host", "test");
+
+  StandInMaster master;
+
+  if(!CHECK(master.start())) {
+    return testResult();
+  }
+
+  master.setHandlingTime(0, BYTE_COST);
+
+  Coordinator coordinator;
+
+  coordinator.addMaster("127.0.0.1", master.getPort(), master.getDatagramPort());
+  coordinator.registerSensor(INFRARED_MOTION);
+  coordinator.setRateLimit(1000, 64);
+  coordinator.setBatching(0, BULK_SIZE, LANE_BULK);
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.isRegistered(); }));
+
+  const EventResult idleConnection = measure(coordinator, false, false);
+  const EventResult idleDatagram = measure(coordinator, true, false);
+  const EventResult loadedConnection = measure(coordinator, false, true);
+  const EventResult loadedDatagram = measure(coordinator, true, true);
+
+  report("connection, idle", idleConnection);
+  report("datagram, idle", idleDatagram);
+  report("connection, behind bulk", loadedConnection);
+  report("datagram, behind bulk", loadedDatagram);
+
+  CHECK(idleConnection.unanswered == 0);
+  CHECK(idleDatagram.unanswered == 0);
+  CHECK(loadedConnection.unanswered == 0);
+  CHECK(loadedDatagram.unanswered == 0);
+
+  // Every event meant for a datagram went out as one.
+  CHECK(coordinator.getDatagramTransport().getStats().answered == 2 * EVENTS);
+
+  // Behind a 20ms bulk update, an event on the connection waits for it; a datagram does not.
+  CHECK(percentile(loadedDatagram.latencies, 50) < percentile(loadedConnection.latencies, 50));
+  CHECK(percentile(loadedDatagram.latencies, 99) < percentile(loadedConnection.latencies, 99));
+  CHECK(percentile(loadedConnection.latencies, 50) >= 1000);
+
+  return testResult();
+}
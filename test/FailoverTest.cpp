@@ -0,0 +1,165 @@
+/*
+ * FailoverTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "HostTest.h"
+#include "StandInMaster.h"
+
+// The number of updates sent in each phase.
+#define PHASE_UPDATES 10
+
+// The time, in microseconds, the backup Master node takes to answer, so it is measurably slower than the primary.
+#define BACKUP_HANDLING_TIME 20000
+
+/**
+ * Sends updates and runs the Coordinator until they have all been acknowledged.
+ *
+ * @param coordinator (Coordinator &) - the Coordinator
+ * @param first (int) - the number of the first update, which is also the sub device it goes to
+ *
+ * @return (bool) true iff every update was acknowledged
+ */
+static bool deliver(Coordinator &coordinator, int first) {
+  for(int sequence = first; sequence < first + PHASE_UPDATES; sequence++) {
+    coordinator.sendUpdate(1 + sequence, String("seq=") + String(sequence));
+  }
+
+  return runUntil(coordinator, 10000, [&]() { return coordinator.getLaneDepth(LANE_NORMAL) == 0; });
+}
+
+/**
+ * Counts the updates of a phase among those the stand-in Master nodes received.
+ *
+ * @param updates (const std::vector<ReceivedUpdate> &) - the updates the stand-in Master nodes received
+ * @param first (int) - the number of the first update of the phase
+ *
+ * @return (int) the number of updates of the phase received, counting copies once
+ */
+static int received(const std::vector<ReceivedUpdate> &updates, int first) {
+  std::vector<bool> seen(PHASE_UPDATES, false);
+  int count = 0;
+
+  for(size_t index = 0; index < updates.size(); index++) {
+    const int offset = atoi(updates[index].data.c_str() + 4) - first;
+
+    if(offset >= 0 && offset < PHASE_UPDATES && !seen[offset]) {
+      seen[offset] = true;
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Runs a device against a fast primary and a slow backup stand-in Master node, both added by hostname.  The device must fail
+ * over to the backup when the primary goes down, fail back to the primary once it has recovered, and reconnect to a restarted
+ * Master node from its cached address without looking the hostname up again.
+ */
+int main() {
+  EEPROM.begin(EEPROM_SIZE);
+  WiFi.begin("host", "test");
+
+  StandInMaster primary;
+  StandInMaster backup;
+
+  if(!CHECK(primary.start()) || !CHECK(backup.start())) {
+    return testResult();
+  }
+
+  backup.setHandlingTime(BACKUP_HANDLING_TIME, 0);
+
+  Coordinator coordinator;
+
+  coordinator.addMaster("localhost", primary.getPort(), primary.getDatagramPort());
+  coordinator.addMaster("localhost", backup.getPort(), backup.getDatagramPort());
+  coordinator.registerSensor(INFRARED_MOTION);
+  coordinator.setRateLimit(1000, 64);
+
+  const MasterEndpoints &endpoints = coordinator.getEndpoints();
+  const ConnectionStats &connection = coordinator.getConnection().getStats();
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.isRegistered(); }));
+  CHECK(deliver(coordinator, 0));
+  CHECK(endpoints.getCurrent() == 0);
+  CHECK(received(primary.getUpdates(), 0) == PHASE_UPDATES);
+
+  // The primary goes down.  The device fails over to the backup and delivers its updates there.
+  primary.goDown();
+
+  const unsigned long outageStart = millis();
+
+  CHECK(deliver(coordinator, PHASE_UPDATES));
+
+  const unsigned long failoverTime = millis() - outageStart;
+
+  CHECK(endpoints.getCurrent() == 1);
+  CHECK(connection.failovers >= 1);
+  CHECK(received(backup.getUpdates(), PHASE_UPDATES) == PHASE_UPDATES);
+
+  // The primary comes back.  Once its probation is over, the idle connection moves back to it since it is faster.
+  primary.comeUp();
+
+  const unsigned long recoveryStart = millis();
+
+  CHECK(runUntil(coordinator, 10000, [&]() {
+    return endpoints.getCurrent() == 0 && coordinator.getConnection().getState() == CONNECTION_CONNECTED;
+  }));
+
+  const unsigned long failbackTime = millis() - recoveryStart;
+
+  CHECK(deliver(coordinator, 2 * PHASE_UPDATES));
+  CHECK(received(primary.getUpdates(), 2 * PHASE_UPDATES) == PHASE_UPDATES);
+  CHECK(endpoints.getStats(0).smoothedRtt < endpoints.getStats(1).smoothedRtt);
+
+  // The primary restarts.  Its health has not recovered from the outage yet, so the device may reconnect to it or fail over to
+  // the backup again, but either way it uses the address it already resolved.
+  const unsigned long lookups = endpoints.getStats(0).lookups + endpoints.getStats(1).lookups;
+  const unsigned long connects = connection.connects;
+
+  primary.goDown();
+  primary.comeUp();
+
+  const unsigned long restartStart = millis();
+
+  CHECK(runUntil(coordinator, 5000, [&]() {
+    return connection.connects > connects && coordinator.getConnection().getState() == CONNECTION_CONNECTED;
+  }));
+
+  const unsigned long reconnectTime = millis() - restartStart;
+
+  CHECK(deliver(coordinator, 3 * PHASE_UPDATES));
+
+  std::vector<ReceivedUpdate> updates = primary.getUpdates();
+  const std::vector<ReceivedUpdate> backupUpdates = backup.getUpdates();
+
+  updates.insert(updates.end(), backupUpdates.begin(), backupUpdates.end());
+
+  CHECK(received(updates, 3 * PHASE_UPDATES) == PHASE_UPDATES);
+  CHECK(endpoints.getStats(0).lookups + endpoints.getStats(1).lookups == lookups);
+
+  // Each hostname was only looked up when the endpoint was first used.
+  CHECK(endpoints.getStats(0).lookups == 1);
+  CHECK(endpoints.getStats(1).lookups == 1);
+
+  for(int index = 0; index < endpoints.count(); index++) {
+    const EndpointStats &stats = endpoints.getStats(index);
+
+    printf("endpoint %d: srtt %lu ms, health %d, %lu successes, %lu failures, %lu lookups\n", index, stats.smoothedRtt,
+        stats.health, stats.successes, stats.failures, stats.lookups);
+  }
+
+  printf("failover in %lu ms, failback in %lu ms, reconnect after restart in %lu ms; %lu failovers, %lu connects\n",
+      failoverTime, failbackTime, reconnectTime, connection.failovers, connection.connects);
+
+  return testResult();
+}
@@ -0,0 +1,48 @@
+/*
+ * HostTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "HostTest.h"
+
+static int checks = 0;
+static int failures = 0;
+
+bool checkCondition(bool passed, const char *expression, const char *file, int line) {
+  checks++;
+
+  if(!passed) {
+    failures++;
+
+    printf("FAILED %s:%d: %s\n", file, line, expression);
+  }
+
+  return passed;
+}
+
+int testResult() {
+  printf("%d of %d checks passed\n", checks - failures, checks);
+
+  return (failures == 0 && checks > 0) ? 0 : 1;
+}
+
+unsigned long percentile(std::vector<unsigned long> samples, int percentile) {
+  if(samples.empty()) {
+    return 0;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  // Nearest rank: the smallest sample at least `percentile` percent of the samples are no larger than.
+  size_t rank = (samples.size() * percentile + 99) / 100;
+
+  if(rank > 0) {
+    rank--;
+  }
+
+  return samples[std::min(rank, samples.size() - 1)];
+}
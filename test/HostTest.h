@@ -0,0 +1,89 @@
+/*
+ * HostTest.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_HOSTTEST
+  #define _C1MOORE_TEST_HOSTTEST
+
+  #include <vector>
+
+  #include <Arduino.h>
+
+  #include "../lib/infrastructure/Coordinator.h"
+
+  /**
+   * Checks a condition the test expects to hold, reporting it if it does not.  The test keeps going either way so a single run
+   * reports every failure.
+   */
+  #define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+  /**
+   * Records the result of a CHECK.
+   *
+   * @param passed (bool) - whether the condition held
+   * @param expression (const char *) - the condition
+   * @param file (const char *) - the file of the check
+   * @param line (int) - the line of the check
+   *
+   * @return (bool) `passed`
+   */
+  bool checkCondition(bool passed, const char *expression, const char *file, int line);
+
+  /**
+   * Reports the outcome of the test.
+   *
+   * @return (int) the exit status of the test: 0 iff every check passed
+   */
+  int testResult();
+
+  /**
+   * Runs the Coordinator, as its process would on the device, until `done()` holds or `timeout` milliseconds have passed.
+   *
+   * @param coordinator (Coordinator &) - the Coordinator
+   * @param timeout (unsigned long) - the longest time, in milliseconds, to run it
+   * @param done (Condition) - a callable returning true once the test can go on
+   *
+   * @return (bool) true iff `done()` held before the timeout
+   */
+  template<typename Condition> bool runUntil(Coordinator &coordinator, unsigned long timeout, Condition done) {
+    const unsigned long start = millis();
+
+    while(!done()) {
+      if(millis() - start >= timeout) {
+        return false;
+      }
+
+      coordinator.run();
+
+      // The stand-in Master node runs on other threads of the same host.
+      yield();
+    }
+
+    return true;
+  }
+
+  /**
+   * Runs the Coordinator for a fixed time.
+   *
+   * @param coordinator (Coordinator &) - the Coordinator
+   * @param duration (unsigned long) - the time, in milliseconds, to run it
+   */
+  inline void runFor(Coordinator &coordinator, unsigned long duration) {
+    const unsigned long start = millis();
+
+    runUntil(coordinator, duration, [&]() { return millis() - start >= duration; });
+  }
+
+  /**
+   * Returns a percentile of a set of samples.
+   *
+   * @param samples (std::vector<unsigned long>) - the samples, in any order
+   * @param percentile (int) - the percentile, from 0 to 100
+   *
+   * @return (unsigned long) the sample at the percentile or 0 if there are none
+   */
+  unsigned long percentile(std::vector<unsigned long> samples, int percentile);
+
+#endif /* _C1MOORE_TEST_HOSTTEST */
@@ -0,0 +1,140 @@
+/*
+ * LoopbackBenchmark.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <Arduino.h>
+
+#include "../lib/infrastructure/DCP/DCPRequest.h"
+#include "../lib/infrastructure/DCP/LoopbackTransport.h"
+#include "../lib/infrastructure/DCP/SocketTransport.h"
+#include "HostTest.h"
+
+// The number of requests timed over each transport.
+#define ROUND_TRIPS 20000
+
+// The body of each request, the size of a typical sensor update.
+#define REQUEST_BODY "lux=512"
+
+/**
+ * Answers the request waiting on the Master node's end of a connection, as a Master node would, with an acknowledgement that
+ * echoes its SESSION_ID:SESSION_TIMESTAMP.
+ *
+ * @param transport (DCPTransport &) - the Master node's end of the connection
+ *
+ * @return (bool) true iff a whole request was read and answered
+ */
+static bool answer(DCPTransport &transport) {
+  const uint8_t *data;
+  const size_t length = transport.peek(&data);
+  const std::string bytes((const char *) data, length);
+
+  // METHOD RESOURCE, SESSION_ID:SESSION_TIMESTAMP and CONTENT_LENGTH are each on their own line, followed by the body.
+  const size_t first = bytes.find('\n');
+  const size_t second = (first == std::string::npos) ? first : bytes.find('\n', first + 1);
+  const size_t third = (second == std::string::npos) ? second : bytes.find('\n', second + 1);
+
+  if(third == std::string::npos) {
+    return false;
+  }
+
+  const size_t requestLength = third + 1 + strtoul(bytes.c_str() + second + 1, NULL, 10);
+
+  if(requestLength > length) {
+    return false;
+  }
+
+  const std::string response = "STANDIN:0\n" + bytes.substr(first + 1, second - first - 1) + "\n24\n";
+  const DCPSegment segment = { (const uint8_t *) response.data(), response.size() };
+
+  transport.consume(requestLength);
+
+  return transport.write(&segment, 1) == response.size();
+}
+
+/**
+ * Sends ROUND_TRIPS requests over a connection and parses each response, answering each request from the other end.
+ *
+ * @param device (DCPTransport &) - the device's end of the connection
+ * @param master (DCPTransport &) - the Master node's end of the connection
+ * @param name (const char *) - the name of the transport, for the report
+ *
+ * @return (float) the mean time, in microseconds, of a round trip
+ */
+static float measure(DCPTransport &device, DCPTransport &master, const char *name) {
+  int answered = 0;
+  int acknowledged = 0;
+  const unsigned long start = micros();
+
+  for(int index = 0; index < ROUND_TRIPS; index++) {
+    DCPRequest request(POST, "/update", "BENCH");
+
+    request.setMessage(REQUEST_BODY);
+
+    if(!request.write(device) || !answer(master)) {
+      continue;
+    }
+
+    answered++;
+
+    DCPResponse response(device);
+
+    if(response.statusCode == SUCCESS_NOCONTENT && response.sessionTimestamp == request.getTimestamp()) {
+      acknowledged++;
+    }
+  }
+
+  const float roundTrip = (float) (micros() - start) / ROUND_TRIPS;
+
+  printf("%-8s %d round trips, %.2f us each\n", name, ROUND_TRIPS, roundTrip);
+
+  CHECK(answered == ROUND_TRIPS);
+  CHECK(acknowledged == ROUND_TRIPS);
+  CHECK(device.available() == 0);
+  CHECK(master.available() == 0);
+
+  return roundTrip;
+}
+
+/**
+ * Times the DCP request/response path in process: each request is written, answered by a stand-in for the Master node on the
+ * other end of the connection, and its response parsed.  Over a pair of LoopbackTransports, the path runs at memory speed, so
+ * the time is the cost of building and parsing the messages.  The same path over a socketpair with SocketTransports adds the
+ * cost of the system calls.
+ */
+int main() {
+  LoopbackTransport device;
+  LoopbackTransport master;
+
+  device.pair(master);
+
+  const float loopback = measure(device, master, "loopback");
+
+  int sockets[2];
+
+  if(!CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0)) {
+    return testResult();
+  }
+
+  {
+    SocketTransport deviceSocket(sockets[0]);
+    SocketTransport masterSocket(sockets[1]);
+
+    const float socket = measure(deviceSocket, masterSocket, "socket");
+
+    // Without system calls, a round trip must be cheaper in memory.
+    CHECK(loopback < socket);
+  }
+
+  ::close(sockets[0]);
+  ::close(sockets[1]);
+
+  return testResult();
+}
@@ -0,0 +1,170 @@
+/*
+ * OutageReplayTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <malloc.h>
+#include <stdio.h>
+
+#include <set>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "HostTest.h"
+#include "StandInMaster.h"
+
+// The number of updates made while the Master node is down.  This is several times what the queue can hold.
+#define OUTAGE_UPDATES 2000
+
+// The number of updates made before and after the outage.
+#define STEADY_UPDATES 50
+
+/**
+ * Returns the heap in use by the device.  The device runs on the main thread, which allocates from the main arena; the
+ * stand-in Master node's threads allocate from their own.
+ *
+ * @return (size_t) the bytes allocated from the main arena
+ */
+static size_t heapInUse() {
+  return mallinfo2().uordblks;
+}
+
+/**
+ * Makes an update whose data identifies it, so the stand-in Master node's log can be checked against what was sent.  Each
+ * update goes to its own sub device, so no two updates are merged into one batch record.
+ *
+ * @param coordinator (Coordinator &) - the Coordinator
+ * @param sequence (int) - the number of the update
+ */
+static void update(Coordinator &coordinator, int sequence) {
+  coordinator.sendUpdate(1 + sequence, String("seq=") + String(sequence));
+}
+
+/**
+ * Takes the stand-in Master node down while a device keeps making updates, then brings it back.  The queue must stay within
+ * its RAM records and EEPROM region however long the outage lasts, dropping the oldest updates once both are full, and every
+ * update it kept must reach the Master node, in the order it was made, once the Master node is back.
+ */
+int main() {
+  EEPROM.begin(EEPROM_SIZE);
+  WiFi.begin("host", "test");
+
+  StandInMaster master;
+
+  if(!CHECK(master.start())) {
+    return testResult();
+  }
+
+  Coordinator coordinator;
+
+  coordinator.addMaster("127.0.0.1", master.getPort(), master.getDatagramPort());
+  coordinator.registerSensor(INFRARED_MOTION);
+  coordinator.setRateLimit(1000, 64);
+  coordinator.setOverflowPolicy(QUEUE_DROP_OLDEST);
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.isRegistered(); }));
+
+  int sequence = 0;
+
+  for(; sequence < STEADY_UPDATES; sequence++) {
+    update(coordinator, sequence);
+  }
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.getLaneDepth(LANE_NORMAL) == 0; }));
+  CHECK(master.getUpdates().size() == STEADY_UPDATES);
+
+  // The outage.  The device finds out from the closed connection and keeps trying to reconnect while it queues updates.
+  const unsigned long outageStart = millis();
+
+  master.goDown();
+  runFor(coordinator, 100);
+
+  const int firstOutageUpdate = sequence;
+  size_t heapWhenFull = 0;
+  size_t heapPeak = 0;
+
+  for(; sequence < firstOutageUpdate + OUTAGE_UPDATES; sequence++) {
+    update(coordinator, sequence);
+
+    if(heapWhenFull == 0 && coordinator.getQueueStats().dropped > 0) {
+      heapWhenFull = heapInUse();
+    }
+
+    heapPeak = max(heapPeak, heapInUse());
+
+    if(sequence % 20 == 0) {
+      coordinator.run();
+    }
+  }
+
+  runFor(coordinator, 300);
+
+  const QueueStats &stats = coordinator.getQueueStats();
+  const int peakDepth = stats.maxDepth;
+  const unsigned long dropped = stats.dropped;
+
+  CHECK(coordinator.getConnection().getState() != CONNECTION_CONNECTED);
+  CHECK(dropped > 0);
+  CHECK(stats.spilled > 0);
+  CHECK(peakDepth < OUTAGE_UPDATES / 2);
+  CHECK(heapWhenFull > 0);
+
+  // Once the queue is full, further updates replace older ones instead of growing the heap.
+  CHECK(heapPeak - heapWhenFull < 4096);
+
+  // The Master node comes back.  The queue is replayed in batches and drains completely.
+  master.comeUp();
+
+  const unsigned long recoveryStart = millis();
+
+  CHECK(runUntil(coordinator, 20000, [&]() { return coordinator.getLaneDepth(LANE_NORMAL) == 0; }));
+
+  const unsigned long recoveryTime = millis() - recoveryStart;
+
+  for(int steady = 0; steady < STEADY_UPDATES; steady++, sequence++) {
+    update(coordinator, sequence);
+  }
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.getLaneDepth(LANE_NORMAL) == 0; }));
+
+  // Every update that was not dropped arrived, and the first copy of each arrived in order.  A request the Master node
+  // handled just before it went down may have been sent again, so copies are allowed.
+  const std::vector<ReceivedUpdate> received = master.getUpdates();
+  std::set<int> seen;
+  int last = -1;
+  bool ordered = true;
+
+  for(size_t index = 0; index < received.size(); index++) {
+    const int value = atoi(received[index].data.c_str() + 4);
+
+    if(!seen.insert(value).second) {
+      continue;
+    }
+
+    ordered = ordered && value > last;
+    last = value;
+  }
+
+  const int kept = OUTAGE_UPDATES - (int) dropped;
+
+  CHECK(ordered);
+  CHECK((int) seen.size() == 2 * STEADY_UPDATES + kept);
+  CHECK(stats.delivered == (unsigned long) (2 * STEADY_UPDATES + kept));
+
+  // With QUEUE_DROP_OLDEST, the updates that survived the outage are the most recent ones.
+  CHECK(seen.count(firstOutageUpdate + OUTAGE_UPDATES - 1) == 1);
+  CHECK(seen.count(firstOutageUpdate + (int) dropped) == 1);
+  CHECK(seen.count(firstOutageUpdate + (int) dropped - 1) == 0);
+
+  printf("outage of %lu ms: %d updates, peak depth %d (%d in RAM), %lu spilled, %lu dropped, heap +%zu bytes once full\n",
+      recoveryStart - outageStart, OUTAGE_UPDATES, peakDepth, OUTBOUND_RAM_RECORDS, stats.spilled, dropped,
+      heapPeak - heapWhenFull);
+  printf("recovery: %d updates replayed in %lu ms, %lu requests, %zu copies received\n", kept, recoveryTime,
+      coordinator.getLaneStats(LANE_NORMAL).requests, received.size() - seen.size());
+
+  return testResult();
+}
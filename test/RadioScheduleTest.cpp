@@ -0,0 +1,254 @@
+/*
+ * RadioScheduleTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "../lib/infrastructure/RadioScheduler.h"
+#include "HostTest.h"
+#include "StandInMaster.h"
+
+// The time, in milliseconds, each schedule is measured for.
+#define RUN_TIME 3000
+
+// The time, in milliseconds, between telemetry updates, which can wait for the next burst.
+#define UPDATE_INTERVAL 37
+
+// The time, in milliseconds, between motion events, which break through.
+#define EVENT_INTERVAL 500
+
+// The time, in milliseconds, the radio stays on for each burst.
+#define BURST_LENGTH 20
+
+// The energy, in millijoules, the simulated radio takes to wake.
+#define WAKE_ENERGY 5
+
+/**
+ * SimulatedRadio stands in for the ESP8266's modem sleep, so a schedule can be measured without hardware.  The loopback
+ * interface stays up either way; the RadioScheduler's bookkeeping and the Coordinator holding traffic back are what is measured.
+ */
+class SimulatedRadio: public Radio {
+  public:
+    void wake() { }
+    void sleep() { }
+};
+
+/**
+ * Timings tracks how long a series of requests took to be answered, from the moment each was handed to the Coordinator.
+ */
+class Timings {
+  public:
+    /**
+     * Creates a new Timings.
+     *
+     * @param capacity (int) - the number of requests that will be tracked
+     */
+    Timings(int capacity): completions(capacity), sentAt(capacity, 0), answered(capacity, false) { }
+
+    /**
+     * Returns the handle for the next request and records when it was made.
+     *
+     * @return (DCPCompletion *) the handle to pass to the Coordinator or NULL if every handle is in use
+     */
+    DCPCompletion *next() {
+      if(sent >= (int) completions.size()) {
+        return NULL;
+      }
+
+      sentAt[sent] = millis();
+
+      return &completions[sent++];
+    }
+
+    /**
+     * Records the latency of every request answered since the last call.
+     */
+    void poll() {
+      for(int index = 0; index < sent; index++) {
+        if(!answered[index] && completions[index].isComplete()) {
+          answered[index] = true;
+
+          if(completions[index].getResponse().statusCode == SUCCESS_NOCONTENT) {
+            latencies.push_back(millis() - sentAt[index]);
+          }
+        }
+      }
+    }
+
+    int sent = 0;
+    std::vector<unsigned long> latencies; // The time, in milliseconds, each answered request took.
+
+  private:
+    std::vector<DCPCompletion> completions;
+    std::vector<unsigned long> sentAt;
+    std::vector<bool> answered;
+};
+
+/**
+ * Returns the mean of a set of samples.
+ *
+ * @param samples (const std::vector<unsigned long> &) - the samples
+ *
+ * @return (float) the mean of the samples or 0 if there are none
+ */
+static float mean(const std::vector<unsigned long> &samples) {
+  unsigned long total = 0;
+
+  for(size_t index = 0; index < samples.size(); index++) {
+    total += samples[index];
+  }
+
+  return samples.empty() ? 0 : (float) total / samples.size();
+}
+
+/**
+ * ScheduleResult is the outcome of running a device with one burst schedule.
+ */
+struct ScheduleResult {
+  unsigned long interval;                     // The time, in milliseconds, between bursts, or 0 if the radio was always on.
+  std::vector<unsigned long> updateLatencies; // The time, in milliseconds, from queuing each update to its acknowledgement.
+  std::vector<unsigned long> eventLatencies;  // The time, in milliseconds, from sending each event to its response.
+  float dutyCycle;
+  float energyPerHour;                        // The estimated energy, in joules per hour, the radio used.
+  unsigned long breakthroughs;
+};
+
+/**
+ * Runs the Coordinator for RUN_TIME milliseconds, queuing a telemetry update every UPDATE_INTERVAL milliseconds and sending a
+ * motion event every EVENT_INTERVAL milliseconds, and measures how long each took to be answered.
+ *
+ * @param coordinator (Coordinator &) - the Coordinator
+ * @param interval (unsigned long) - the time, in milliseconds, between bursts, or 0 to leave the radio on
+ *
+ * @return (ScheduleResult) the latencies and radio statistics of the run
+ */
+static ScheduleResult measure(Coordinator &coordinator, unsigned long interval) {
+  SimulatedRadio radio;
+  ConstantPowerModel model(184.8, 49.5, WAKE_ENERGY);
+  RadioScheduler scheduler(radio, model, interval, BURST_LENGTH);
+
+  coordinator.setRadioScheduler(interval > 0 ? &scheduler : NULL);
+
+  Timings updates(RUN_TIME / UPDATE_INTERVAL);
+  Timings events(RUN_TIME / EVENT_INTERVAL);
+  const unsigned long start = millis();
+
+  while(millis() - start < RUN_TIME) {
+    const unsigned long elapsed = millis() - start;
+
+    if(elapsed >= (unsigned long) updates.sent * UPDATE_INTERVAL) {
+      DCPCompletion *completion = updates.next();
+
+      if(completion != NULL) {
+        coordinator.sendUpdate(2, "lux=" + String(updates.sent), completion);
+      }
+    }
+
+    // Events are offset from the bursts so they find the radio asleep.
+    if(elapsed >= (unsigned long) events.sent * EVENT_INTERVAL + EVENT_INTERVAL / 2 - 7) {
+      DCPCompletion *completion = events.next();
+
+      if(completion != NULL) {
+        coordinator.sendEvent(1, "motion=1", completion);
+      }
+    }
+
+    coordinator.run();
+    updates.poll();
+    events.poll();
+    yield();
+  }
+
+  // Let the updates queued last catch the next burst.
+  runUntil(coordinator, interval + 1000, [&]() {
+    updates.poll();
+    events.poll();
+
+    return coordinator.getLaneDepth(LANE_NORMAL) == 0 && coordinator.getDatagramTransport().getOutstanding() == 0;
+  });
+
+  updates.poll();
+  events.poll();
+
+  ScheduleResult result = { interval, updates.latencies, events.latencies, 1, model.getPower(RADIO_ON) * 3600 / 1000, 0 };
+
+  if(interval > 0) {
+    result.dutyCycle = scheduler.getDutyCycle();
+    result.energyPerHour = scheduler.getEnergyPerHour();
+    result.breakthroughs = scheduler.getStats().breakthroughs;
+  }
+
+  coordinator.setRadioScheduler(NULL);
+
+  return result;
+}
+
+/**
+ * Measures the tradeoff between radio-on time and latency.  A device sends telemetry and motion events to a stand-in Master node
+ * with the radio always on and with bursts further and further apart.  Longer intervals must keep the radio off for longer and
+ * delay telemetry for longer, while motion events keep breaking through without waiting for a burst.
+ */
+int main() {
+  EEPROM.begin(EEPROM_SIZE);
+  WiFi.begin("host", "test");
+
+  StandInMaster master;
+
+  if(!CHECK(master.start())) {
+    return testResult();
+  }
+
+  Coordinator coordinator;
+
+  coordinator.addMaster("127.0.0.1", master.getPort(), master.getDatagramPort());
+  coordinator.registerSensor(INFRARED_MOTION);
+  coordinator.setRateLimit(1000, 64);
+  coordinator.setBatching(0, 1000, LANE_NORMAL);
+
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.isRegistered(); }));
+
+  const unsigned long intervals[] = { 0, 100, 300, 1000 };
+  const int schedules = sizeof(intervals) / sizeof(intervals[0]);
+  std::vector<ScheduleResult> results;
+
+  for(int index = 0; index < schedules; index++) {
+    results.push_back(measure(coordinator, intervals[index]));
+
+    const ScheduleResult &result = results.back();
+
+    printf("interval %4lu ms: radio on %5.1f%%, %6.1f J/h, %2lu breakthroughs; telemetry mean %5.1f ms p99 %4lu ms; "
+        "events p99 %2lu ms\n", result.interval, result.dutyCycle * 100, result.energyPerHour, result.breakthroughs,
+        mean(result.updateLatencies), percentile(result.updateLatencies, 99), percentile(result.eventLatencies, 99));
+  }
+
+  for(int index = 0; index < schedules; index++) {
+    const ScheduleResult &result = results[index];
+
+    CHECK(result.updateLatencies.size() == RUN_TIME / UPDATE_INTERVAL);
+    CHECK(result.eventLatencies.size() == RUN_TIME / EVENT_INTERVAL);
+
+    // Events never wait for a burst.
+    CHECK(percentile(result.eventLatencies, 99) < 50);
+
+    if(index == 0) {
+      continue;
+    }
+
+    const ScheduleResult &previous = results[index - 1];
+
+    // Bursts further apart keep the radio off for longer and cost less energy, but telemetry waits longer for them.
+    CHECK(result.dutyCycle < previous.dutyCycle);
+    CHECK(result.energyPerHour < previous.energyPerHour);
+    CHECK(mean(result.updateLatencies) > mean(previous.updateLatencies));
+    CHECK(result.breakthroughs > 0);
+  }
+
+  return testResult();
+}
@@ -0,0 +1,147 @@
+/*
+ * SchedulerIdleTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The time, in milliseconds, each schedule is run for.  This spans two load windows, so the last one is complete.
+#define RUN_TIME (2 * LOAD_WINDOW + 200)
+
+// The time, in milliseconds, the polled process sleeps between runs.
+#define POLL_INTERVAL 8
+
+// The time, in microseconds, the polled process works every time it executes.
+#define WORK_TIME 2000
+
+/**
+ * PolledProcess stands in for a process that is polled, such as the Coordinator or the sensors.  Each time it executes, it works
+ * for WORK_TIME microseconds.  If it is busy, it readies itself to execute again right away, as the sketch's processes used to;
+ * otherwise, it is scheduled with an interval and sleeps until it is due again.
+ */
+class PolledProcess: public Runnable {
+  public:
+    PolledProcess(Scheduler &scheduler, bool busy): scheduler(scheduler), busy(busy) { }
+
+    int run() {
+      const unsigned long start = micros();
+
+      while(micros() - start < WORK_TIME) { }
+
+      executions++;
+
+      if(busy) {
+        scheduler.ready(pid);
+      }
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    const bool busy;
+    int pid = -1;
+    unsigned long executions = 0;
+};
+
+/**
+ * IdleTask counts how often the Scheduler had nothing to do.  While an idle task executes, `shouldYield()` is true iff a process
+ * is READY, which must never be the case when it starts.
+ */
+class IdleTask: public Runnable {
+  public:
+    IdleTask(Scheduler &scheduler): scheduler(scheduler) { }
+
+    int run() {
+      executions++;
+
+      if(scheduler.shouldYield()) {
+        startedWhileReady++;
+      }
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    unsigned long executions = 0;
+    unsigned long startedWhileReady = 0;
+};
+
+/**
+ * IdleResult is the outcome of running a polled process with one schedule.
+ */
+struct IdleResult {
+  unsigned long executions;         // The number of times the polled process executed.
+  unsigned long idleExecutions;     // The number of times the idle task executed.
+  unsigned long startedWhileReady;  // The number of times the idle task executed while a process was READY.
+  int cpuLoad;
+};
+
+/**
+ * Runs a polled process and an idle task on a new Scheduler for RUN_TIME milliseconds.
+ *
+ * @param busy (bool) - whether the process readies itself on every pass instead of sleeping between runs
+ *
+ * @return (IdleResult) how often the process and the idle task executed and the CPU load
+ */
+static IdleResult measure(bool busy) {
+  Scheduler scheduler;
+  PolledProcess process(scheduler, busy);
+  IdleTask idleTask(scheduler);
+
+  if(busy) {
+    process.pid = scheduler.scheduleSuspended(process);
+
+    CHECK(scheduler.ready(process.pid) == 0);
+  } else {
+    process.pid = scheduler.scheduleInterval(process, POLL_INTERVAL, -1);
+  }
+
+  CHECK(process.pid >= 0);
+  CHECK(scheduler.registerIdleTask(idleTask) == 0);
+
+  const unsigned long start = millis();
+
+  while(millis() - start < RUN_TIME) {
+    scheduler.step();
+  }
+
+  const IdleResult result = { process.executions, idleTask.executions, idleTask.startedWhileReady, scheduler.getCpuLoad() };
+
+  printf("%-8s process executed %4lu times, idle task %8lu times, CPU load %3d%%\n", busy ? "busy:" : "polled:",
+      result.executions, result.idleExecutions, result.cpuLoad);
+
+  return result;
+}
+
+/**
+ * Runs a polled process that sleeps between runs alongside an idle task.  The idle task must only execute while no process is
+ * READY, and the CPU load must reflect the time the process actually works.  A process that readies itself on every pass
+ * instead keeps the Scheduler from ever being idle.
+ */
+int main() {
+  const IdleResult polled = measure(false);
+  const IdleResult busy = measure(true);
+
+  // The polled process sleeps for an interval after each run and works for a fraction of the period; the rest is idle.
+  const int period = POLL_INTERVAL + WORK_TIME / 1000;
+  const int expectedLoad = 100 * (WORK_TIME / 1000) / period;
+
+  CHECK(polled.executions >= RUN_TIME / period / 2);
+  CHECK(polled.executions <= RUN_TIME / period + 1);
+  CHECK(polled.idleExecutions > 0);
+  CHECK(polled.startedWhileReady == 0);
+  CHECK(polled.cpuLoad > expectedLoad / 2);
+  CHECK(polled.cpuLoad < expectedLoad * 2);
+
+  // A process that is always READY leaves no idle time at all.
+  CHECK(busy.idleExecutions == 0);
+  CHECK(busy.cpuLoad > 90);
+
+  return testResult();
+}
@@ -0,0 +1,110 @@
+/*
+ * SchedulerPolicyTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The time, in milliseconds, the processes compete for the MCU.
+#define RUN_TIME 1000
+
+// The time, in microseconds, each process keeps the MCU every time it executes.
+#define BURST_TIME 200
+
+/**
+ * BusyProcess stands in for a process that always has more work to do, such as a sensor sampled as fast as possible or a
+ * metrics upload that never catches up.  Each time it executes, it keeps the MCU for BURST_TIME microseconds and readies itself
+ * to execute again.
+ */
+class BusyProcess: public Runnable {
+  public:
+    BusyProcess(Scheduler &scheduler, const char *name, int priority): scheduler(scheduler), name(name), priority(priority) { }
+
+    int run() {
+      const unsigned long start = micros();
+
+      while(micros() - start < BURST_TIME) { }
+
+      runtime += micros() - start;
+      executions++;
+
+      scheduler.ready(pid);
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    const char *name;
+    int priority;
+    int pid = -1;
+    unsigned long runtime = 0;    // The time, in microseconds, the process has executed.
+    unsigned long executions = 0;
+};
+
+/**
+ * Runs a busy priority 5 sensor process against two busy priority 1 background processes and reports the share of the MCU each
+ * received.  With strict priorities (the default), the sensor starves the background processes.  With
+ * SCHEDULER_POLICY_FAIR_SHARE defined, every process makes progress and the sensor still receives the largest share.
+ */
+int main() {
+  Scheduler scheduler;
+  BusyProcess sensor(scheduler, "sensor", 5);
+  BusyProcess metrics(scheduler, "metrics upload", 1);
+  BusyProcess sync(scheduler, "configuration sync", 1);
+  BusyProcess *processes[] = { &sensor, &metrics, &sync };
+  const int count = sizeof(processes) / sizeof(processes[0]);
+
+  for(int index = 0; index < count; index++) {
+    processes[index]->pid = scheduler.scheduleSuspended(*processes[index], processes[index]->priority);
+
+    CHECK(processes[index]->pid >= 0);
+    CHECK(scheduler.ready(processes[index]->pid) == 0);
+  }
+
+  const unsigned long start = millis();
+
+  while(millis() - start < RUN_TIME) {
+    scheduler.step();
+  }
+
+  unsigned long total = 0;
+
+  for(int index = 0; index < count; index++) {
+    total += processes[index]->runtime;
+  }
+
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    printf("fair share:\n");
+  #else
+    printf("strict priority:\n");
+  #endif
+
+  for(int index = 0; index < count; index++) {
+    const BusyProcess &process = *processes[index];
+
+    printf("  %-20s priority %2d: %5.1f%% of the MCU, %lu executions\n", process.name, process.priority,
+        100.0 * process.runtime / max(total, 1UL), process.executions);
+  }
+
+  CHECK(total > 0);
+
+  #ifdef SCHEDULER_POLICY_FAIR_SHARE
+    // Waiting processes age, so the background processes get a guaranteed share.  Priority 5 weighs about 2.4 times priority 1.
+    CHECK(metrics.runtime > total / 10);
+    CHECK(sync.runtime > total / 10);
+    CHECK(sensor.runtime > 3 * metrics.runtime / 2);
+    CHECK(sensor.runtime > 3 * sync.runtime / 2);
+  #else
+    CHECK(sensor.runtime == total);
+    CHECK(metrics.executions == 0);
+    CHECK(sync.executions == 0);
+  #endif
+
+  return testResult();
+}
@@ -0,0 +1,113 @@
+/*
+ * SchedulerYieldTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <Arduino.h>
+
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The time, in milliseconds, the processes compete for the MCU.
+#define RUN_TIME 500
+
+// The time, in microseconds, each process works every time it executes.  This is several quanta of a priority 1 process.
+#define WORK_TIME 5000
+
+/**
+ * CooperativeProcess stands in for a long running process that checks `shouldYield()` as it works, such as a process parsing a
+ * large response.  Each time it executes, it works for WORK_TIME microseconds, yielding whenever its quantum has expired and
+ * another process is waiting, and readies itself to execute again.
+ */
+class CooperativeProcess: public Runnable {
+  public:
+    CooperativeProcess(Scheduler &scheduler, int &depth): scheduler(scheduler), depth(depth) { }
+
+    int run() {
+      if(executing) {
+        reentries++;
+      }
+
+      executing = true;
+      depth++;
+      maxDepth = max(maxDepth, depth);
+
+      // The quantum has only just started, so nothing can preempt the process yet.
+      if(scheduler.shouldYield()) {
+        earlyYields++;
+      }
+
+      const unsigned long start = micros();
+
+      while(micros() - start < WORK_TIME) {
+        if(scheduler.shouldYield()) {
+          yields++;
+          scheduler.yield();
+        }
+      }
+
+      executions++;
+      depth--;
+      executing = false;
+
+      scheduler.ready(pid);
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    int &depth;               // The number of processes on the stack, shared by every CooperativeProcess.
+    int pid = -1;
+    bool executing = false;
+    int maxDepth = 0;         // The most processes that were on the stack while this process executed.
+    unsigned long executions = 0;
+    unsigned long yields = 0;
+    unsigned long reentries = 0;
+    unsigned long earlyYields = 0;
+};
+
+/**
+ * Runs two priority 1 processes that yield once their quanta expire.  Each yield must dispatch the other process, and the
+ * yielding process must resume once the other returns, without ever being dispatched again while it is still on the stack.
+ */
+int main() {
+  Scheduler scheduler;
+  int depth = 0;
+  CooperativeProcess first(scheduler, depth);
+  CooperativeProcess second(scheduler, depth);
+  CooperativeProcess *processes[] = { &first, &second };
+  const int count = sizeof(processes) / sizeof(processes[0]);
+
+  for(int index = 0; index < count; index++) {
+    processes[index]->pid = scheduler.scheduleSuspended(*processes[index], 1);
+
+    CHECK(processes[index]->pid >= 0);
+    CHECK(scheduler.ready(processes[index]->pid) == 0);
+  }
+
+  const unsigned long start = millis();
+
+  while(millis() - start < RUN_TIME) {
+    scheduler.step();
+  }
+
+  for(int index = 0; index < count; index++) {
+    const CooperativeProcess &process = *processes[index];
+
+    printf("process %d: %lu executions, %lu yields, %lu reentries, at most %d deep\n", index, process.executions,
+        process.yields, process.reentries, process.maxDepth);
+
+    CHECK(process.executions > 0);
+    CHECK(process.yields > 0);
+    CHECK(process.reentries == 0);
+    CHECK(process.earlyYields == 0);
+    CHECK(process.maxDepth <= count);
+  }
+
+  CHECK(depth == 0);
+
+  return testResult();
+}
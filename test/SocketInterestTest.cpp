@@ -0,0 +1,180 @@
+/*
+ * SocketInterestTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <dlfcn.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <map>
+#include <thread>
+
+#include <Arduino.h>
+
+#include "../lib/infrastructure/SocketInterest.h"
+#include "../lib/scheduler/Runnable.h"
+#include "../lib/scheduler/Scheduler.h"
+#include "HostTest.h"
+
+// The number of processes waiting on a socket at once.
+#define SOCKET_COUNT 20
+
+// The time, in milliseconds, before the first socket becomes readable, so every process is waiting by then.
+#define FIRST_WRITE 100
+
+// The time, in milliseconds, between sockets becoming readable.
+#define WRITE_INTERVAL 5
+
+// The time, in milliseconds, the process waiting on a socket that never becomes readable waits.
+#define SILENT_TIMEOUT 50
+
+// The number of poll(2) calls made in each pass of the Scheduler over its waiting processes, and the most sockets any checked.
+static std::map<long, int> pollsPerPass;
+static nfds_t mostSockets = 0;
+
+/**
+ * Counts the calls SocketInterest makes to poll(2) in each pass of the Scheduler, then makes the call.
+ */
+extern "C" int poll(struct pollfd *descriptors, nfds_t count, int timeout) {
+  typedef int (*PollFunction)(struct pollfd *, nfds_t, int);
+  static PollFunction systemPoll = (PollFunction) dlsym(RTLD_NEXT, "poll");
+  const long pass = Scheduler::current().getPollPass();
+
+  if(pass >= 0) {
+    pollsPerPass[pass]++;
+
+    if(count > mostSockets) {
+      mostSockets = count;
+    }
+  }
+
+  return systemPoll(descriptors, count, timeout);
+}
+
+/**
+ * SocketReader waits for its socket to become readable, then reads what arrived.
+ */
+class SocketReader: public Runnable {
+  public:
+    SocketReader(Scheduler &scheduler, int fd, int timeout): scheduler(scheduler), fd(fd), timeout(timeout) { }
+
+    int run() {
+      SocketInterest readable(fd, SOCKET_READABLE);
+
+      result = scheduler.await(readable, timeout);
+
+      if(result == 0) {
+        received = (::recv(fd, &byte, 1, MSG_DONTWAIT) == 1);
+        waited = millis() - start;
+      }
+
+      finished = true;
+
+      return 0;
+    }
+
+    Scheduler &scheduler;
+    const int fd;
+    const int timeout;
+    unsigned long start = 0;
+    unsigned long waited = 0;   // The time, in milliseconds, the process waited for its socket.
+    int result = 1;
+    uint8_t byte = 0;
+    bool received = false;
+    bool finished = false;
+};
+
+/**
+ * Runs SOCKET_COUNT processes that each wait for one end of a socketpair to become readable while another thread writes to the
+ * other ends one after the other.  Every pass of the Scheduler over its waiting processes must check all of their sockets with a
+ * single poll(2), and each process must resume once its socket becomes readable.  A process waiting on a socket that never
+ * becomes readable must time out.
+ */
+int main() {
+  Scheduler scheduler;
+  int pairs[SOCKET_COUNT + 1][2];
+  std::vector<SocketReader *> readers;
+
+  for(int index = 0; index <= SOCKET_COUNT; index++) {
+    if(!CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[index]) == 0)) {
+      return testResult();
+    }
+
+    // The last socket never becomes readable.
+    readers.push_back(new SocketReader(scheduler, pairs[index][0], (index < SOCKET_COUNT) ? 2000 : SILENT_TIMEOUT));
+
+    CHECK(scheduler.schedule(*readers.back(), 1) >= 0);
+  }
+
+  // A socket that can accept more data is writable right away.
+  {
+    SocketInterest writable(pairs[0][1], SOCKET_WRITABLE);
+
+    CHECK(writable.poll());
+  }
+
+  const unsigned long start = millis();
+
+  for(size_t index = 0; index < readers.size(); index++) {
+    readers[index]->start = start;
+  }
+
+  std::thread writer([&]() {
+    ::delay(FIRST_WRITE);
+
+    for(int index = 0; index < SOCKET_COUNT; index++) {
+      const uint8_t byte = (uint8_t) index;
+
+      ::write(pairs[index][1], &byte, 1);
+      ::delay(WRITE_INTERVAL);
+    }
+  });
+
+  // The first process dispatched waits on top of the others, so the pass only returns once every process has finished.
+  scheduler.step();
+
+  writer.join();
+
+  int repeatedPolls = 0;
+
+  for(std::map<long, int>::const_iterator pass = pollsPerPass.begin(); pass != pollsPerPass.end(); pass++) {
+    repeatedPolls += pass->second - 1;
+  }
+
+  // However many processes were waiting, each pass checked their sockets with a single poll(2).
+  CHECK(!pollsPerPass.empty());
+  CHECK(repeatedPolls == 0);
+
+  for(int index = 0; index <= SOCKET_COUNT; index++) {
+    const SocketReader &reader = *readers[index];
+
+    CHECK(reader.finished);
+
+    if(index < SOCKET_COUNT) {
+      CHECK(reader.result == 0);
+      CHECK(reader.received);
+      CHECK(reader.byte == index);
+      CHECK(reader.waited >= FIRST_WRITE);
+    } else {
+      CHECK(reader.result == -2);
+    }
+  }
+
+  // Once every process was waiting, a single poll(2) checked all of their sockets.
+  CHECK(mostSockets == SOCKET_COUNT + 1);
+
+  printf("%d sockets: %zu passes over the waiting processes, one poll(2) each, at most %d sockets per poll(2)\n",
+      SOCKET_COUNT + 1, pollsPerPass.size(), (int) mostSockets);
+
+  for(int index = 0; index <= SOCKET_COUNT; index++) {
+    delete readers[index];
+
+    ::close(pairs[index][0]);
+    ::close(pairs[index][1]);
+  }
+
+  return testResult();
+}
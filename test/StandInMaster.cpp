@@ -0,0 +1,461 @@
+/*
+ * StandInMaster.cpp
+ *
+ *      Author: c1moore
+ */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "StandInMaster.h"
+
+// The session the stand-in hands out and the device ID it assigns.
+#define STAND_IN_SESSION  "standin"
+#define STAND_IN_DEVICE   "7"
+
+// How far, in milliseconds, the stand-in's clock is ahead of the device's, so clock synchronization has something to find.
+#define STAND_IN_CLOCK_OFFSET 1000000UL
+
+/**
+ * Request is a DCP request as the stand-in parsed it.
+ */
+struct Request {
+  std::string method;
+  std::string resource;
+  std::string sessionId;
+  std::string timestamp;
+  std::string body;
+};
+
+/**
+ * Connection is a connection accepted by the stand-in and the bytes received on it that have not been handled yet.
+ */
+struct Connection {
+  int fd;
+  std::string pending;
+};
+
+class StandInMaster::Implementation {
+  public:
+    int listener = -1;
+    int datagrams = -1;
+    uint16_t port = 0;
+    uint16_t datagramPort = 0;
+    std::vector<Connection> connections;
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> wantUp{true};
+    std::atomic<bool> up{false};
+    std::atomic<unsigned long> fixedTime{0};
+    std::atomic<unsigned long> byteTime{0};
+
+    std::thread connectionThread;
+    std::thread datagramThread;
+
+    mutable std::mutex lock;
+    std::vector<ReceivedUpdate> updates;
+    MasterStats stats = { 0, 0, 0 };
+
+    /**
+     * Returns the stand-in's clock.
+     *
+     * @return (unsigned long) the time, in milliseconds
+     */
+    static unsigned long now() {
+      const unsigned long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+
+      return elapsed + STAND_IN_CLOCK_OFFSET;
+    }
+
+    /**
+     * Opens a socket bound to the loopback interface.
+     *
+     * @param type (int) - SOCK_STREAM or SOCK_DGRAM
+     * @param port (uint16_t &) - the port to bind, or 0 for an ephemeral port; set to the port that was bound
+     *
+     * @return (int) the socket or -1 if it could not be opened
+     */
+    static int open(int type, uint16_t &port) {
+      const int fd = ::socket(AF_INET, type, 0);
+      const int reuse = 1;
+
+      if(fd < 0) {
+        return -1;
+      }
+
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+      struct sockaddr_in local = {};
+      socklen_t length = sizeof(local);
+
+      local.sin_family = AF_INET;
+      local.sin_port = htons(port);
+      local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+      if(::bind(fd, (struct sockaddr *) &local, sizeof(local)) < 0 || (type == SOCK_STREAM && ::listen(fd, 8) < 0) ||
+          ::getsockname(fd, (struct sockaddr *) &local, &length) < 0) {
+        ::close(fd);
+
+        return -1;
+      }
+
+      port = ntohs(local.sin_port);
+
+      return fd;
+    }
+
+    /**
+     * Parses the first request in `bytes`.
+     *
+     * @param bytes (const std::string &) - the bytes received
+     * @param request (Request &) - set to the request
+     *
+     * @return (size_t) the length of the request or 0 if it has not fully arrived
+     */
+    static size_t parse(const std::string &bytes, Request &request) {
+      const size_t first = bytes.find('\n');
+      const size_t second = (first == std::string::npos) ? first : bytes.find('\n', first + 1);
+      const size_t third = (second == std::string::npos) ? second : bytes.find('\n', second + 1);
+
+      if(third == std::string::npos) {
+        return 0;
+      }
+
+      const size_t length = strtoul(bytes.c_str() + second + 1, NULL, 10);
+
+      if(bytes.size() < third + 1 + length) {
+        return 0;
+      }
+
+      const std::string line = bytes.substr(0, first);
+      const std::string session = bytes.substr(first + 1, second - first - 1);
+      const size_t space = line.find(' ');
+      const size_t colon = session.rfind(':');
+
+      request.method = line.substr(0, space);
+      request.resource = (space == std::string::npos) ? "" : line.substr(space + 1);
+      request.sessionId = session.substr(0, colon);
+      request.timestamp = (colon == std::string::npos) ? "" : session.substr(colon + 1);
+      request.body = bytes.substr(third + 1, length);
+
+      return third + 1 + length;
+    }
+
+    /**
+     * Records the updates a request carries.
+     *
+     * @param request (const Request &) - the request
+     * @param datagram (bool) - whether the request arrived in a datagram
+     */
+    void record(const Request &request, bool datagram) {
+      std::lock_guard<std::mutex> guard(lock);
+
+      if(request.resource.compare(0, 8, "/update/") == 0) {
+        updates.push_back({ (uint16_t) atoi(request.resource.c_str() + 8), request.body, datagram });
+
+        return;
+      }
+
+      // A batch is a sequence of `SUBDEVICE_ID:LENGTH\nDATA` records (see UpdateBatch).
+      size_t position = 0;
+
+      while(position < request.body.size()) {
+        const size_t colon = request.body.find(':', position);
+        const size_t newline = request.body.find('\n', position);
+
+        if(colon == std::string::npos || newline == std::string::npos) {
+          break;
+        }
+
+        const size_t length = strtoul(request.body.c_str() + colon + 1, NULL, 10);
+
+        updates.push_back({ (uint16_t) atoi(request.body.c_str() + position), request.body.substr(newline + 1, length), datagram });
+
+        position = newline + 1 + length;
+      }
+    }
+
+    /**
+     * Handles a request and builds the response.
+     *
+     * @param request (const Request &) - the request
+     * @param datagram (bool) - whether the request arrived in a datagram
+     *
+     * @return (std::string) the response
+     */
+    std::string handle(const Request &request, bool datagram) {
+      const unsigned long received = now();
+      const unsigned long cost = fixedTime + byteTime * request.body.size();
+
+      if(cost > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(cost));
+      }
+
+      int status = 24;
+      std::string body;
+
+      if(request.resource == "/register") {
+        status = 20;
+        body = STAND_IN_SESSION;
+      } else if(request.resource == "/session") {
+        status = (request.sessionId == STAND_IN_SESSION) ? 24 : 44;
+      } else if(request.resource == "/time") {
+        status = 20;
+        body = std::to_string(received) + ":" + std::to_string(now());
+      } else if(request.resource == "/updates" || request.resource.compare(0, 8, "/update/") == 0) {
+        record(request, datagram);
+      }
+
+      std::string response = std::string(STAND_IN_DEVICE) + ":0\n" + request.sessionId + ":" + request.timestamp + "\n" +
+          std::to_string(status) + "\n";
+
+      if(status != 24) {
+        response += std::to_string(body.size()) + "\n" + body;
+      }
+
+      return response;
+    }
+
+    /**
+     * Closes the listening socket and every connection.
+     */
+    void closeConnections() {
+      for(size_t index = 0; index < connections.size(); index++) {
+        ::close(connections[index].fd);
+      }
+
+      connections.clear();
+
+      if(listener >= 0) {
+        ::close(listener);
+      }
+
+      listener = -1;
+    }
+
+    /**
+     * Accepts connections and answers the requests that arrive on them until the stand-in is destroyed.
+     */
+    void serveConnections() {
+      while(running) {
+        if(!wantUp && up) {
+          closeConnections();
+          up = false;
+        } else if(wantUp && !up) {
+          listener = open(SOCK_STREAM, port);
+          up = (listener >= 0);
+        }
+
+        std::vector<struct pollfd> descriptors;
+
+        if(listener >= 0) {
+          descriptors.push_back({ listener, POLLIN, 0 });
+        }
+
+        for(size_t index = 0; index < connections.size(); index++) {
+          descriptors.push_back({ connections[index].fd, POLLIN, 0 });
+        }
+
+        if(::poll(descriptors.data(), descriptors.size(), 1) <= 0) {
+          continue;
+        }
+
+        size_t next = 0;
+
+        if(listener >= 0 && (descriptors[next++].revents & POLLIN)) {
+          const int fd = ::accept(listener, NULL, NULL);
+
+          if(fd >= 0) {
+            // Responses are small and sent back to back, so without this the second waits for the device to acknowledge the first.
+            const int noDelay = 1;
+
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            connections.push_back({ fd, "" });
+
+            std::lock_guard<std::mutex> guard(lock);
+            stats.connections++;
+          }
+        }
+
+        for(size_t index = 0; next < descriptors.size(); next++) {
+          if(descriptors[next].revents == 0) {
+            index++;
+
+            continue;
+          }
+
+          if(!receive(connections[index])) {
+            ::close(connections[index].fd);
+            connections.erase(connections.begin() + index);
+
+            continue;
+          }
+
+          index++;
+        }
+      }
+
+      closeConnections();
+    }
+
+    /**
+     * Reads what arrived on a connection and answers every request that has fully arrived.
+     *
+     * @param connection (Connection &) - the connection
+     *
+     * @return (bool) true iff the connection is still open
+     */
+    bool receive(Connection &connection) {
+      char buffer[4096];
+      const ssize_t length = ::recv(connection.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+      if(length <= 0) {
+        return false;
+      }
+
+      connection.pending.append(buffer, length);
+
+      Request request;
+      size_t used;
+
+      while((used = parse(connection.pending, request)) > 0) {
+        connection.pending.erase(0, used);
+
+        const std::string response = handle(request, false);
+
+        if(::send(connection.fd, response.data(), response.size(), MSG_NOSIGNAL) != (ssize_t) response.size()) {
+          return false;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        stats.requests++;
+      }
+
+      return true;
+    }
+
+    /**
+     * Answers datagrams until the stand-in is destroyed.  Datagrams that arrive while the stand-in is down are dropped.
+     */
+    void serveDatagrams() {
+      while(running) {
+        struct pollfd descriptor = { datagrams, POLLIN, 0 };
+
+        if(::poll(&descriptor, 1, 1) <= 0) {
+          continue;
+        }
+
+        char buffer[2048];
+        struct sockaddr_in peer = {};
+        socklen_t peerLength = sizeof(peer);
+        const ssize_t length = ::recvfrom(datagrams, buffer, sizeof(buffer), 0, (struct sockaddr *) &peer, &peerLength);
+
+        Request request;
+
+        if(length <= 0 || !up || parse(std::string(buffer, length), request) == 0) {
+          continue;
+        }
+
+        const std::string response = handle(request, true);
+
+        ::sendto(datagrams, response.data(), response.size(), 0, (struct sockaddr *) &peer, peerLength);
+
+        std::lock_guard<std::mutex> guard(lock);
+        stats.datagrams++;
+      }
+    }
+
+    /**
+     * Waits until the threads have acted on `wantUp`.
+     */
+    void settle() {
+      while(up != wantUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+};
+
+StandInMaster::StandInMaster() {
+  implementation = new Implementation();
+}
+
+StandInMaster::~StandInMaster() {
+  implementation->running = false;
+
+  if(implementation->connectionThread.joinable()) {
+    implementation->connectionThread.join();
+  }
+
+  if(implementation->datagramThread.joinable()) {
+    implementation->datagramThread.join();
+  }
+
+  if(implementation->datagrams >= 0) {
+    ::close(implementation->datagrams);
+  }
+
+  delete implementation;
+}
+
+bool StandInMaster::start() {
+  implementation->datagrams = Implementation::open(SOCK_DGRAM, implementation->datagramPort);
+
+  // Bind the listening port here so it is known once this returns.
+  implementation->listener = Implementation::open(SOCK_STREAM, implementation->port);
+
+  if(implementation->datagrams < 0 || implementation->listener < 0) {
+    return false;
+  }
+
+  implementation->up = true;
+  implementation->running = true;
+  implementation->connectionThread = std::thread(&Implementation::serveConnections, implementation);
+  implementation->datagramThread = std::thread(&Implementation::serveDatagrams, implementation);
+
+  return true;
+}
+
+void StandInMaster::goDown() {
+  implementation->wantUp = false;
+  implementation->settle();
+}
+
+void StandInMaster::comeUp() {
+  implementation->wantUp = true;
+  implementation->settle();
+}
+
+void StandInMaster::setHandlingTime(unsigned long fixed, unsigned long perByte) {
+  implementation->fixedTime = fixed;
+  implementation->byteTime = perByte;
+}
+
+uint16_t StandInMaster::getPort() const {
+  return implementation->port;
+}
+
+uint16_t StandInMaster::getDatagramPort() const {
+  return implementation->datagramPort;
+}
+
+std::vector<ReceivedUpdate> StandInMaster::getUpdates() const {
+  std::lock_guard<std::mutex> guard(implementation->lock);
+
+  return implementation->updates;
+}
+
+MasterStats StandInMaster::getStats() const {
+  std::lock_guard<std::mutex> guard(implementation->lock);
+
+  return implementation->stats;
+}
@@ -0,0 +1,100 @@
+/*
+ * StandInMaster.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_STANDINMASTER
+  #define _C1MOORE_TEST_STANDINMASTER
+
+  #include <stdint.h>
+
+  #include <string>
+  #include <vector>
+
+  /**
+   * ReceivedUpdate is an update a StandInMaster accepted, in the order it arrived.
+   */
+  struct ReceivedUpdate {
+    uint16_t subDeviceId;
+    std::string data;
+    bool datagram;      // Whether the update arrived in a datagram rather than on a connection.
+  };
+
+  /**
+   * MasterStats counts what a StandInMaster has handled.
+   */
+  struct MasterStats {
+    unsigned long connections;  // The number of connections accepted.
+    unsigned long requests;     // The number of requests answered on a connection.
+    unsigned long datagrams;    // The number of requests answered in a datagram.
+  };
+
+  /**
+   * StandInMaster is a Master node for host tests.  It listens on an ephemeral TCP port and an ephemeral UDP port of the
+   * loopback interface and answers DCP requests from its own threads, so the device under test runs unmodified on the test's
+   * thread and talks to it over real sockets.  It understands the requests the Coordinator sends:
+   *
+   *    POST /register        -> SUCCESS with a session ID
+   *    POST /session         -> SUCCESS_NOCONTENT if the session is the one it handed out, NOT_FOUND otherwise
+   *    POST /time            -> SUCCESS with `T2:T3` from its clock
+   *    POST /update/ID       -> SUCCESS_NOCONTENT, recording the update
+   *    POST /updates         -> SUCCESS_NOCONTENT, recording every update in the batch
+   *    anything else         -> SUCCESS_NOCONTENT
+   *
+   * Requests on a connection are handled one at a time, in order, as a single-threaded Master node would.  Datagrams are handled
+   * on their own thread.  Handling a request can be made to take time, in proportion to its size, so large transfers hold up
+   * the requests behind them.
+   *
+   * The Master node can be taken down, which closes its sockets, and brought back on the same ports.
+   */
+  class StandInMaster {
+    public:
+      StandInMaster();
+      ~StandInMaster();
+
+      /**
+       * Opens the sockets and starts answering requests.
+       *
+       * @return (bool) true iff the Master node is up
+       */
+      bool start();
+
+      /**
+       * Closes every connection and the listening socket, and ignores datagrams, until `comeUp()`.  This returns once the
+       * Master node is down.
+       */
+      void goDown();
+
+      /**
+       * Listens again on the same ports.  This returns once the Master node is up.
+       */
+      void comeUp();
+
+      /**
+       * Sets how long handling a request takes.
+       *
+       * @param fixed (unsigned long) - the time, in microseconds, every request takes
+       * @param perByte (unsigned long) - the time, in microseconds, each byte of the body adds
+       */
+      void setHandlingTime(unsigned long fixed, unsigned long perByte);
+
+      uint16_t getPort() const;
+      uint16_t getDatagramPort() const;
+
+      /**
+       * Returns the updates accepted so far.
+       *
+       * @return (std::vector<ReceivedUpdate>) the updates, in the order they arrived
+       */
+      std::vector<ReceivedUpdate> getUpdates() const;
+
+      MasterStats getStats() const;
+
+    private:
+      class Implementation;
+
+      Implementation *implementation;
+  };
+
+#endif /* _C1MOORE_TEST_STANDINMASTER */
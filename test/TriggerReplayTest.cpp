@@ -0,0 +1,172 @@
+/*
+ * TriggerReplayTest.cpp
+ *
+ *      Author: c1moore
+ */
+#include <stdio.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <ESP8266WiFi.h>
+
+#include "../lib/infrastructure/Coordinator.h"
+#include "../lib/infrastructure/PersistentLayout.h"
+#include "../lib/infrastructure/ZoneAggregator.h"
+#include "HostTest.h"
+#include "StandInMaster.h"
+
+// The number of rooms in the trace and the number of motion sensors in each.
+#define TRACE_ZONES 3
+#define SENSORS_PER_ZONE 4
+
+// The length, in seconds, of the trace.
+#define TRACE_LENGTH 600
+
+// The time, in milliseconds, a second of the trace takes to replay, so ten minutes of triggers replay in six seconds.
+#define TRACE_SCALE 10
+
+// The time, in seconds, a room stays occupied after the last motion in it.
+#define ZONE_HOLD_OFF 60
+
+/**
+ * Trigger is a single motion trigger in a trace.
+ */
+struct Trigger {
+  unsigned long at; // The time, in milliseconds from the start of the replay, of the trigger.
+  int sensorId;     // The sensor that triggered.
+
+  bool operator<(const Trigger &other) const {
+    return at < other.at;
+  }
+};
+
+/**
+ * Records the triggers of a multi-sensor home.  Each room alternates between vacant and occupied spells; while it is occupied,
+ * each of its PIR sensors retriggers every few seconds whenever it can see the occupant.  The trace is seeded, so every run
+ * replays the same triggers.
+ *
+ * @return (std::vector<Trigger>) the triggers, in the order they happened
+ */
+static std::vector<Trigger> record() {
+  std::minstd_rand generator(35);
+  std::uniform_int_distribution<int> vacant(20, 120);
+  std::uniform_int_distribution<int> occupied(30, 300);
+  std::uniform_int_distribution<int> retrigger(2, 8);
+  std::bernoulli_distribution sees(0.7);
+  std::vector<Trigger> trace;
+
+  for(int zone = 0; zone < TRACE_ZONES; zone++) {
+    int time = vacant(generator);
+
+    while(time < TRACE_LENGTH) {
+      const int end = min(time + occupied(generator), TRACE_LENGTH);
+
+      for(int sensor = 0; sensor < SENSORS_PER_ZONE; sensor++) {
+        for(int at = time + retrigger(generator) / 2; at < end; at += retrigger(generator)) {
+          if(sees(generator)) {
+            trace.push_back({ (unsigned long) at * TRACE_SCALE, zone * SENSORS_PER_ZONE + sensor });
+          }
+        }
+      }
+
+      time = end + vacant(generator);
+    }
+  }
+
+  std::stable_sort(trace.begin(), trace.end());
+
+  return trace;
+}
+
+/**
+ * Replays a recorded trace of motion triggers from several sensors per room through a ZoneAggregator against a stand-in Master
+ * node, and reports how many requests aggregation saved over sending an update for every trigger.  The Master node must end up
+ * with the same occupancy the device has.
+ */
+int main() {
+  EEPROM.begin(EEPROM_SIZE);
+  WiFi.begin("host", "test");
+
+  StandInMaster master;
+
+  if(!CHECK(master.start())) {
+    return testResult();
+  }
+
+  Coordinator coordinator;
+
+  coordinator.addMaster("127.0.0.1", master.getPort(), master.getDatagramPort());
+  const int motionId = coordinator.registerSensor(INFRARED_MOTION);
+  coordinator.setRateLimit(1000, 64);
+
+  // The zones are registered along with the other sub devices, so each has an ID of its own.
+  ZoneAggregator zones(coordinator);
+  std::set<int> zoneIds;
+
+  for(int zone = 0; zone < TRACE_ZONES; zone++) {
+    CHECK(zones.addZone(ZONE_HOLD_OFF * TRACE_SCALE) == zone);
+    CHECK(zones.getZoneId(zone) >= 0 && zones.getZoneId(zone) != motionId);
+
+    zoneIds.insert(zones.getZoneId(zone));
+
+    for(int sensor = 0; sensor < SENSORS_PER_ZONE; sensor++) {
+      CHECK(zones.assign(zone * SENSORS_PER_ZONE + sensor, zone) == 0);
+    }
+  }
+
+  CHECK((int) zoneIds.size() == TRACE_ZONES);
+  CHECK(runUntil(coordinator, 2000, [&]() { return coordinator.isRegistered(); }));
+
+  const std::vector<Trigger> trace = record();
+  const MasterStats before = master.getStats();
+  const unsigned long start = millis();
+  size_t next = 0;
+
+  // The trace is followed by a hold-off so every room is vacant again by the end.
+  while(millis() - start < (TRACE_LENGTH + 2 * ZONE_HOLD_OFF) * TRACE_SCALE) {
+    for(; next < trace.size() && trace[next].at <= millis() - start; next++) {
+      zones.reportMotion(trace[next].sensorId);
+    }
+
+    zones.run();
+    coordinator.run();
+    yield();
+  }
+
+  runFor(coordinator, 200);
+
+  const MasterStats after = master.getStats();
+  const unsigned long requests = (after.requests - before.requests) + (after.datagrams - before.datagrams);
+  const std::vector<ReceivedUpdate> updates = master.getUpdates();
+  std::map<uint16_t, std::string> occupancy;
+
+  for(size_t index = 0; index < updates.size(); index++) {
+    occupancy[updates[index].subDeviceId] = updates[index].data;
+  }
+
+  CHECK(zones.getReportCount() == trace.size());
+  CHECK(zones.getUpdateCount() > 0);
+
+  // Every change of occupancy reached the Master node, and it agrees every room is vacant again.
+  CHECK(updates.size() >= zones.getUpdateCount());
+  CHECK((int) occupancy.size() == TRACE_ZONES);
+
+  for(std::map<uint16_t, std::string>::const_iterator zone = occupancy.begin(); zone != occupancy.end(); zone++) {
+    CHECK(zoneIds.count(zone->first) == 1);
+    CHECK(zone->second == "0");
+  }
+
+  // Sending an update for every trigger would have taken an order of magnitude more requests.
+  CHECK(zones.getReportCount() >= 10 * zones.getUpdateCount());
+
+  printf("%d rooms, %d sensors each, %d s of triggers: %lu triggers, %lu updates, %lu requests (%.1fx fewer)\n", TRACE_ZONES,
+      SENSORS_PER_ZONE, TRACE_LENGTH, zones.getReportCount(), zones.getUpdateCount(), requests,
+      (double) zones.getReportCount() / max(requests, 1UL));
+
+  return testResult();
+}
@@ -0,0 +1,114 @@
+/*
+ * Arduino.cpp
+ *
+ *      Author: c1moore
+ */
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "Arduino.h"
+
+EspClass ESP;
+
+// The time the program started; `millis()` and `micros()` count from it like they count from boot on the device.
+static const std::chrono::steady_clock::time_point boot = std::chrono::steady_clock::now();
+
+static std::minstd_rand generator;
+
+static int pins[HOST_PIN_COUNT];
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+void delay(unsigned long ms) {
+  if(ms == 0) {
+    std::this_thread::yield();
+
+    return;
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void noInterrupts() { }
+
+void interrupts() { }
+
+long random(long howBig) {
+  if(howBig <= 0) {
+    return 0;
+  }
+
+  return generator() % howBig;
+}
+
+long random(long howSmall, long howBig) {
+  if(howSmall >= howBig) {
+    return howSmall;
+  }
+
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  generator.seed(seed);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if(pin < HOST_PIN_COUNT && mode == INPUT_PULLUP) {
+    pins[pin] = HIGH;
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if(pin < HOST_PIN_COUNT) {
+    pins[pin] = value;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return (pin < HOST_PIN_COUNT) ? pins[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  return (pin < HOST_PIN_COUNT) ? pins[pin] : 0;
+}
+
+int digitalPinToInterrupt(int pin) {
+  return (pin >= 0 && pin < HOST_PIN_COUNT) ? pin : -1;
+}
+
+// Pins only change when the program writes them, so no interrupt can fire.
+void attachInterrupt(int interrupt, void (*handler)(), int mode) { }
+
+void detachInterrupt(int interrupt) { }
+
+uint32_t EspClass::getCycleCount() {
+  return (uint32_t) (micros() * 80UL);
+}
+
+uint8_t EspClass::getCpuFreqMHz() {
+  return 80;
+}
+
+uint32_t EspClass::getChipId() {
+  return 0x00c0ffee;
+}
+
+void EspClass::restart() {
+  abort();
+}
@@ -0,0 +1,86 @@
+/*
+ * Arduino.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_ARDUINO
+  #define _C1MOORE_TEST_CORE_ARDUINO
+
+  #include <math.h>
+  #include <stddef.h>
+  #include <stdint.h>
+  #include <stdlib.h>
+  #include <string.h>
+
+  #include <algorithm>
+
+  #include "WString.h"
+
+  /**
+   * The host core implements the part of the ESP8266 Arduino core the libraries use, so they can be built and exercised on a
+   * host with the same configuration (ARDUINO and ESP8266 defined) as on the device.  Time is the host's monotonic clock,
+   * networking uses POSIX sockets on the host (see ESP8266WiFi.h and WiFiUdp.h) and EEPROM is kept in memory.  Pins hold
+   * whatever was last written to them.
+   */
+
+  #define HIGH 0x1
+  #define LOW  0x0
+
+  #define INPUT         0x00
+  #define INPUT_PULLUP  0x02
+  #define OUTPUT        0x01
+
+  #define RISING  0x01
+  #define FALLING 0x02
+  #define CHANGE  0x03
+
+  // The number of pins the host core simulates.
+  #define HOST_PIN_COUNT 32
+
+  #define ICACHE_RAM_ATTR
+  #define IRAM_ATTR
+
+  using std::min;
+  using std::max;
+
+  unsigned long millis();
+  unsigned long micros();
+  void delay(unsigned long ms);
+  void delayMicroseconds(unsigned int us);
+  void yield();
+
+  void noInterrupts();
+  void interrupts();
+
+  long random(long howBig);
+  long random(long howSmall, long howBig);
+  void randomSeed(unsigned long seed);
+
+  void pinMode(uint8_t pin, uint8_t mode);
+  void digitalWrite(uint8_t pin, uint8_t value);
+  int digitalRead(uint8_t pin);
+  int analogRead(uint8_t pin);
+  int digitalPinToInterrupt(int pin);
+  void attachInterrupt(int interrupt, void (*handler)(), int mode);
+  void detachInterrupt(int interrupt);
+
+  /**
+   * EspClass exposes the chip-specific functions of the ESP8266 core.
+   */
+  class EspClass {
+    public:
+      /**
+       * Returns the cycle counter of an 80MHz CPU, derived from `micros()`.
+       *
+       * @return (uint32_t) the cycle counter
+       */
+      uint32_t getCycleCount();
+      uint8_t getCpuFreqMHz();
+      uint32_t getChipId();
+      void restart();
+  };
+
+  extern EspClass ESP;
+
+#endif /* _C1MOORE_TEST_CORE_ARDUINO */
@@ -0,0 +1,51 @@
+/*
+ * EEPROM.cpp
+ *
+ *      Author: c1moore
+ */
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+// Erased flash reads as 0xff.
+EEPROMClass::EEPROMClass(): size(0), commits(0) {
+  memset(cache, 0xff, sizeof(cache));
+}
+
+void EEPROMClass::begin(size_t size) {
+  this->size = (size < EEPROM_CAPACITY) ? size : EEPROM_CAPACITY;
+}
+
+void EEPROMClass::end() {
+  commit();
+
+  size = 0;
+}
+
+bool EEPROMClass::commit() {
+  if(size == 0) {
+    return false;
+  }
+
+  commits++;
+
+  return true;
+}
+
+size_t EEPROMClass::length() const {
+  return size;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+  return (address >= 0 && (size_t) address < size) ? cache[address] : 0;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if(address >= 0 && (size_t) address < size) {
+    cache[address] = value;
+  }
+}
+
+unsigned long EEPROMClass::getCommits() const {
+  return commits;
+}
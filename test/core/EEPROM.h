@@ -0,0 +1,65 @@
+/*
+ * EEPROM.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_EEPROM
+  #define _C1MOORE_TEST_CORE_EEPROM
+
+  #include <stddef.h>
+  #include <stdint.h>
+  #include <string.h>
+
+  // The most bytes the emulated flash sector holds.
+  #define EEPROM_CAPACITY 4096
+
+  /**
+   * EEPROMClass emulates the ESP8266 core's EEPROM, which caches a flash sector in RAM and writes it back on `commit()`.  The
+   * sector is kept in memory for the life of the program, so it survives objects that are destroyed and created again the way
+   * it survives a restart on the device.  `getCommits()` counts the writes to flash.
+   */
+  class EEPROMClass {
+    public:
+      EEPROMClass();
+
+      void begin(size_t size);
+      void end();
+      bool commit();
+      size_t length() const;
+
+      uint8_t read(int address) const;
+      void write(int address, uint8_t value);
+
+      template<typename T> T &get(int address, T &value) const {
+        if(address >= 0 && address + sizeof(T) <= size) {
+          memcpy((void *) &value, cache + address, sizeof(T));
+        }
+
+        return value;
+      }
+
+      template<typename T> const T &put(int address, const T &value) {
+        if(address >= 0 && address + sizeof(T) <= size) {
+          memcpy(cache + address, &value, sizeof(T));
+        }
+
+        return value;
+      }
+
+      /**
+       * Returns the number of times the cache was written back to flash.
+       *
+       * @return (unsigned long) the number of commits
+       */
+      unsigned long getCommits() const;
+
+    private:
+      uint8_t cache[EEPROM_CAPACITY];
+      size_t size;
+      unsigned long commits;
+  };
+
+  extern EEPROMClass EEPROM;
+
+#endif /* _C1MOORE_TEST_CORE_EEPROM */
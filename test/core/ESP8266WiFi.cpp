@@ -0,0 +1,110 @@
+/*
+ * ESP8266WiFi.cpp
+ *
+ *      Author: c1moore
+ */
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "ESP8266WiFi.h"
+
+ESP8266WiFiClass WiFi;
+
+ESP8266WiFiClass::ESP8266WiFiClass(): state(WL_DISCONNECTED), sleepMode(WIFI_NONE_SLEEP), bssid{ 0x02, 0, 0, 0, 0, 1 } { }
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *password, int32_t channel, const uint8_t *bssid, bool connect) {
+  state = connect ? WL_CONNECTED : WL_DISCONNECTED;
+
+  return state;
+}
+
+bool ESP8266WiFiClass::config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns) {
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff) {
+  state = WL_DISCONNECTED;
+
+  return true;
+}
+
+wl_status_t ESP8266WiFiClass::status() {
+  return state;
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t mode) {
+  return true;
+}
+
+bool ESP8266WiFiClass::persistent(bool persistent) {
+  return true;
+}
+
+bool ESP8266WiFiClass::setAutoReconnect(bool autoReconnect) {
+  return true;
+}
+
+bool ESP8266WiFiClass::setSleepMode(WiFiSleepType_t type) {
+  sleepMode = type;
+
+  return true;
+}
+
+WiFiSleepType_t ESP8266WiFiClass::getSleepMode() {
+  return sleepMode;
+}
+
+bool ESP8266WiFiClass::forceSleepBegin(uint32_t sleepUs) {
+  return true;
+}
+
+bool ESP8266WiFiClass::forceSleepWake() {
+  return true;
+}
+
+int ESP8266WiFiClass::hostByName(const char *host, IPAddress &address) {
+  struct addrinfo hints = {};
+  struct addrinfo *results = NULL;
+
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  if(::getaddrinfo(host, NULL, &hints, &results) != 0 || results == NULL) {
+    return 0;
+  }
+
+  address = IPAddress((uint32_t) ((struct sockaddr_in *) results->ai_addr)->sin_addr.s_addr);
+
+  ::freeaddrinfo(results);
+
+  return 1;
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+  return IPAddress(127, 0, 0, 1);
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP() {
+  return IPAddress(127, 0, 0, 1);
+}
+
+IPAddress ESP8266WiFiClass::subnetMask() {
+  return IPAddress(255, 0, 0, 0);
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t index) {
+  return IPAddress(127, 0, 0, 1);
+}
+
+uint8_t *ESP8266WiFiClass::BSSID() {
+  return bssid;
+}
+
+int32_t ESP8266WiFiClass::channel() {
+  return 1;
+}
+
+int32_t ESP8266WiFiClass::RSSI() {
+  return -40;
+}
@@ -0,0 +1,77 @@
+/*
+ * ESP8266WiFi.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_ESP8266WIFI
+  #define _C1MOORE_TEST_CORE_ESP8266WIFI
+
+  #include "Arduino.h"
+  #include "IPAddress.h"
+  #include "WiFiClient.h"
+
+  enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+  };
+
+  enum WiFiMode_t {
+    WIFI_OFF,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA
+  };
+
+  enum WiFiSleepType_t {
+    WIFI_NONE_SLEEP,
+    WIFI_LIGHT_SLEEP,
+    WIFI_MODEM_SLEEP
+  };
+
+  /**
+   * ESP8266WiFiClass stands in for the station interface.  The host is always on the network: `begin()` connects immediately
+   * and `disconnect()` leaves the network until the next `begin()`.  Hostnames are resolved by the host's resolver.
+   */
+  class ESP8266WiFiClass {
+    public:
+      ESP8266WiFiClass();
+
+      wl_status_t begin(const char *ssid, const char *password = NULL, int32_t channel = 0, const uint8_t *bssid = NULL,
+          bool connect = true);
+      bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress());
+      bool disconnect(bool wifiOff = false);
+      wl_status_t status();
+
+      bool mode(WiFiMode_t mode);
+      bool persistent(bool persistent);
+      bool setAutoReconnect(bool autoReconnect);
+      bool setSleepMode(WiFiSleepType_t type);
+      WiFiSleepType_t getSleepMode();
+      bool forceSleepBegin(uint32_t sleepUs = 0);
+      bool forceSleepWake();
+
+      int hostByName(const char *host, IPAddress &address);
+
+      IPAddress localIP();
+      IPAddress gatewayIP();
+      IPAddress subnetMask();
+      IPAddress dnsIP(uint8_t index = 0);
+      uint8_t *BSSID();
+      int32_t channel();
+      int32_t RSSI();
+
+    private:
+      wl_status_t state;
+      WiFiSleepType_t sleepMode;
+      uint8_t bssid[6];
+  };
+
+  extern ESP8266WiFiClass WiFi;
+
+#endif /* _C1MOORE_TEST_CORE_ESP8266WIFI */
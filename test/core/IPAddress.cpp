@@ -0,0 +1,40 @@
+/*
+ * IPAddress.cpp
+ *
+ *      Author: c1moore
+ */
+#include <arpa/inet.h>
+#include <string.h>
+
+#include "IPAddress.h"
+
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth) {
+  const uint8_t octets[] = { first, second, third, fourth };
+
+  memcpy(&address, octets, sizeof(address));
+}
+
+uint8_t IPAddress::operator[](int index) const {
+  return ((const uint8_t *) &address)[index & 3];
+}
+
+bool IPAddress::fromString(const char *address) {
+  struct in_addr parsed;
+
+  if(inet_pton(AF_INET, address, &parsed) != 1) {
+    return false;
+  }
+
+  this->address = parsed.s_addr;
+
+  return true;
+}
+
+String IPAddress::toString() const {
+  char buffer[INET_ADDRSTRLEN];
+  struct in_addr value;
+
+  value.s_addr = address;
+
+  return String(inet_ntop(AF_INET, &value, buffer, sizeof(buffer)));
+}
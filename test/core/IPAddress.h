@@ -0,0 +1,41 @@
+/*
+ * IPAddress.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_IPADDRESS
+  #define _C1MOORE_TEST_CORE_IPADDRESS
+
+  #include <stdint.h>
+
+  #include "WString.h"
+
+  /**
+   * IPAddress mirrors the IPv4 address of the ESP8266 core.  Like there, the address converts to a uint32_t holding the octets
+   * in network order, which is also how POSIX sockets store it.
+   */
+  class IPAddress {
+    public:
+      IPAddress(): address(0) {}
+      IPAddress(uint32_t address): address(address) {}
+      IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth);
+
+      operator uint32_t() const {
+        return address;
+      }
+
+      bool isSet() const {
+        return address != 0;
+      }
+
+      uint8_t operator[](int index) const;
+
+      bool fromString(const char *address);
+      String toString() const;
+
+    private:
+      uint32_t address;
+  };
+
+#endif /* _C1MOORE_TEST_CORE_IPADDRESS */
@@ -0,0 +1,37 @@
+/*
+ * Stream.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_STREAM
+  #define _C1MOORE_TEST_CORE_STREAM
+
+  #include <stddef.h>
+  #include <stdint.h>
+
+  /**
+   * Stream mirrors the byte stream interface of the Arduino core that WiFiClient and WiFiUDP implement.
+   */
+  class Stream {
+    public:
+      Stream(): timeout(1000) {}
+      virtual ~Stream() {}
+
+      virtual size_t write(uint8_t byte) = 0;
+      virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+
+      virtual int available() = 0;
+      virtual int read() = 0;
+      virtual int peek() = 0;
+      virtual void flush() {}
+
+      void setTimeout(unsigned long timeout) {
+        this->timeout = timeout;
+      }
+
+    protected:
+      unsigned long timeout;  // The time, in milliseconds, blocking operations wait.
+  };
+
+#endif /* _C1MOORE_TEST_CORE_STREAM */
@@ -0,0 +1,341 @@
+/*
+ * WString.cpp
+ *
+ *      Author: c1moore
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WString.h"
+
+/**
+ * Formats an integer in the given base, the way the Arduino core does: negative values are only signed in base 10.
+ *
+ * @param value (unsigned long) - the magnitude of the value
+ * @param negative (bool) - whether the value is negative
+ * @param base (unsigned char) - the base, from 2 to 36
+ *
+ * @return (std::string) the formatted value
+ */
+static std::string format(unsigned long value, bool negative, unsigned char base) {
+  if(base < 2 || base > 36) {
+    base = DEC;
+  }
+
+  char digits[sizeof(unsigned long) * 8 + 2];
+  int next = sizeof(digits) - 1;
+
+  digits[next] = '\0';
+
+  do {
+    const int digit = value % base;
+
+    digits[--next] = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+    value /= base;
+  } while(value > 0);
+
+  if(negative) {
+    digits[--next] = '-';
+  }
+
+  return std::string(digits + next);
+}
+
+static std::string formatSigned(long value, unsigned char base) {
+  if(base == DEC && value < 0) {
+    return format(-(unsigned long) value, true, base);
+  }
+
+  return format((unsigned long) value, false, base);
+}
+
+static std::string formatFloat(double value, unsigned char decimals) {
+  char buffer[64];
+
+  snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+
+  return std::string(buffer);
+}
+
+String::String(const char *value): value(value != NULL ? value : "") { }
+String::String(const String &value): value(value.value) { }
+String::String(const std::string &value): value(value) { }
+String::String(char value): value(1, value) { }
+String::String(unsigned char value, unsigned char base): value(format(value, false, base)) { }
+String::String(int value, unsigned char base): value(formatSigned(value, base)) { }
+String::String(long value, unsigned char base): value(formatSigned(value, base)) { }
+String::String(float value, unsigned char decimals): value(formatFloat(value, decimals)) { }
+String::String(double value, unsigned char decimals): value(formatFloat(value, decimals)) { }
+String::String(unsigned int value, unsigned char base): value(format(value, false, base)) { }
+String::String(unsigned long value, unsigned char base): value(format(value, false, base)) { }
+
+String &String::operator=(const String &value) {
+  this->value = value.value;
+
+  return *this;
+}
+
+String &String::operator=(const char *value) {
+  this->value = (value != NULL) ? value : "";
+
+  return *this;
+}
+
+unsigned int String::length() const {
+  return value.length();
+}
+
+const char *String::c_str() const {
+  return value.c_str();
+}
+
+bool String::reserve(unsigned int size) {
+  value.reserve(size);
+
+  return true;
+}
+
+bool String::concat(const String &value) {
+  this->value += value.value;
+
+  return true;
+}
+
+bool String::concat(const char *value) {
+  if(value == NULL) {
+    return false;
+  }
+
+  this->value += value;
+
+  return true;
+}
+
+bool String::concat(const char *value, unsigned int length) {
+  if(value == NULL) {
+    return false;
+  }
+
+  this->value.append(value, length);
+
+  return true;
+}
+
+bool String::concat(char value) {
+  this->value += value;
+
+  return true;
+}
+
+bool String::concat(int value) {
+  return concat(String(value));
+}
+
+bool String::concat(unsigned int value) {
+  return concat(String(value));
+}
+
+bool String::concat(long value) {
+  return concat(String(value));
+}
+
+bool String::concat(unsigned long value) {
+  return concat(String(value));
+}
+
+String &String::operator+=(const String &value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(const char *value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(char value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(int value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(unsigned int value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(long value) {
+  concat(value);
+
+  return *this;
+}
+
+String &String::operator+=(unsigned long value) {
+  concat(value);
+
+  return *this;
+}
+
+bool String::equals(const String &value) const {
+  return this->value == value.value;
+}
+
+bool String::equalsIgnoreCase(const String &value) const {
+  return strcasecmp(this->value.c_str(), value.value.c_str()) == 0 && this->value.length() == value.value.length();
+}
+
+bool String::operator==(const String &value) const {
+  return equals(value);
+}
+
+bool String::operator==(const char *value) const {
+  return this->value == (value != NULL ? value : "");
+}
+
+bool String::operator!=(const String &value) const {
+  return !equals(value);
+}
+
+bool String::operator!=(const char *value) const {
+  return !(*this == value);
+}
+
+bool String::startsWith(const String &prefix) const {
+  return value.compare(0, prefix.value.length(), prefix.value) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return value.length() >= suffix.value.length() &&
+      value.compare(value.length() - suffix.value.length(), suffix.value.length(), suffix.value) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return (index < value.length()) ? value[index] : '\0';
+}
+
+char String::operator[](unsigned int index) const {
+  return charAt(index);
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy;
+
+  if(index >= value.length()) {
+    dummy = '\0';
+
+    return dummy;
+  }
+
+  return value[index];
+}
+
+int String::indexOf(char value, unsigned int from) const {
+  const size_t found = this->value.find(value, from);
+
+  return (found == std::string::npos) ? -1 : (int) found;
+}
+
+int String::indexOf(const String &value, unsigned int from) const {
+  const size_t found = this->value.find(value.value, from);
+
+  return (found == std::string::npos) ? -1 : (int) found;
+}
+
+int String::lastIndexOf(char value) const {
+  const size_t found = this->value.rfind(value);
+
+  return (found == std::string::npos) ? -1 : (int) found;
+}
+
+String String::substring(unsigned int from) const {
+  return substring(from, value.length());
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if(from > to) {
+    std::swap(from, to);
+  }
+
+  if(from >= value.length()) {
+    return String();
+  }
+
+  if(to > value.length()) {
+    to = value.length();
+  }
+
+  return String(value.substr(from, to - from));
+}
+
+void String::remove(unsigned int index) {
+  if(index < value.length()) {
+    value.erase(index);
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if(index < value.length()) {
+    value.erase(index, count);
+  }
+}
+
+void String::trim() {
+  size_t first = 0;
+  size_t last = value.length();
+
+  while(first < last && isspace((unsigned char) value[first])) {
+    first++;
+  }
+
+  while(last > first && isspace((unsigned char) value[last - 1])) {
+    last--;
+  }
+
+  value = value.substr(first, last - first);
+}
+
+long String::toInt() const {
+  return atol(value.c_str());
+}
+
+float String::toFloat() const {
+  return atof(value.c_str());
+}
+
+void String::toCharArray(char *buffer, unsigned int size) const {
+  if(size == 0) {
+    return;
+  }
+
+  const unsigned int length = (value.length() < size - 1) ? value.length() : size - 1;
+
+  memcpy(buffer, value.c_str(), length);
+  buffer[length] = '\0';
+}
+
+String operator+(const String &left, const String &right) {
+  return String(left.value + right.value);
+}
+
+String operator+(const String &left, const char *right) {
+  return left + String(right);
+}
+
+String operator+(const char *left, const String &right) {
+  return String(left) + right;
+}
+
+String operator+(const String &left, char right) {
+  return left + String(right);
+}
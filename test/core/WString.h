@@ -0,0 +1,97 @@
+/*
+ * WString.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_WSTRING
+  #define _C1MOORE_TEST_CORE_WSTRING
+
+  #include <string>
+
+  #define DEC 10
+  #define HEX 16
+  #define OCT 8
+  #define BIN 2
+
+  /**
+   * String mirrors the Arduino String the libraries use, backed by a std::string.
+   */
+  class String {
+    public:
+      String(const char *value = "");
+      String(const String &value);
+      explicit String(char value);
+      explicit String(unsigned char value, unsigned char base = DEC);
+      explicit String(int value, unsigned char base = DEC);
+      explicit String(unsigned int value, unsigned char base = DEC);
+      explicit String(long value, unsigned char base = DEC);
+      explicit String(unsigned long value, unsigned char base = DEC);
+      explicit String(float value, unsigned char decimals = 2);
+      explicit String(double value, unsigned char decimals = 2);
+
+      String &operator=(const String &value);
+      String &operator=(const char *value);
+
+      unsigned int length() const;
+      const char *c_str() const;
+      bool reserve(unsigned int size);
+
+      bool concat(const String &value);
+      bool concat(const char *value);
+      bool concat(const char *value, unsigned int length);
+      bool concat(char value);
+      bool concat(int value);
+      bool concat(unsigned int value);
+      bool concat(long value);
+      bool concat(unsigned long value);
+
+      String &operator+=(const String &value);
+      String &operator+=(const char *value);
+      String &operator+=(char value);
+      String &operator+=(int value);
+      String &operator+=(unsigned int value);
+      String &operator+=(long value);
+      String &operator+=(unsigned long value);
+
+      bool equals(const String &value) const;
+      bool equalsIgnoreCase(const String &value) const;
+      bool operator==(const String &value) const;
+      bool operator==(const char *value) const;
+      bool operator!=(const String &value) const;
+      bool operator!=(const char *value) const;
+      bool startsWith(const String &prefix) const;
+      bool endsWith(const String &suffix) const;
+
+      char charAt(unsigned int index) const;
+      char operator[](unsigned int index) const;
+      char &operator[](unsigned int index);
+
+      int indexOf(char value, unsigned int from = 0) const;
+      int indexOf(const String &value, unsigned int from = 0) const;
+      int lastIndexOf(char value) const;
+      String substring(unsigned int from) const;
+      String substring(unsigned int from, unsigned int to) const;
+
+      void remove(unsigned int index);
+      void remove(unsigned int index, unsigned int count);
+      void trim();
+
+      long toInt() const;
+      float toFloat() const;
+      void toCharArray(char *buffer, unsigned int size) const;
+
+    private:
+      std::string value;
+
+      String(const std::string &value);
+
+      friend String operator+(const String &left, const String &right);
+  };
+
+  String operator+(const String &left, const String &right);
+  String operator+(const String &left, const char *right);
+  String operator+(const char *left, const String &right);
+  String operator+(const String &left, char right);
+
+#endif /* _C1MOORE_TEST_CORE_WSTRING */
@@ -0,0 +1,181 @@
+/*
+ * WiFiClient.cpp
+ *
+ *      Author: c1moore
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ESP8266WiFi.h"
+#include "WiFiClient.h"
+
+WiFiClient::WiFiClient(): fd(-1) { }
+
+WiFiClient::~WiFiClient() {
+  stop();
+}
+
+int WiFiClient::connect(IPAddress address, uint16_t port) {
+  stop();
+
+  fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+  if(fd < 0) {
+    return 0;
+  }
+
+  struct sockaddr_in peer = {};
+
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons(port);
+  peer.sin_addr.s_addr = (uint32_t) address;
+
+  // Connect without blocking so the attempt can be bounded by the timeout.
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  if(::connect(fd, (struct sockaddr *) &peer, sizeof(peer)) < 0) {
+    struct pollfd writable = { fd, POLLOUT, 0 };
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    if(errno != EINPROGRESS || ::poll(&writable, 1, timeout) != 1 ||
+        ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+      stop();
+
+      return 0;
+    }
+  }
+
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+  // Writes block for at most the timeout, like on the device.
+  struct timeval limit = { (time_t) (timeout / 1000), (suseconds_t) ((timeout % 1000) * 1000) };
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+
+  return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  IPAddress address;
+
+  if(!WiFi.hostByName(host, address)) {
+    return 0;
+  }
+
+  return connect(address, port);
+}
+
+uint8_t WiFiClient::connected() {
+  if(fd < 0) {
+    return 0;
+  }
+
+  uint8_t byte;
+  const ssize_t result = ::recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+
+  if(result > 0 || (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+    return 1;
+  }
+
+  return 0;
+}
+
+void WiFiClient::stop() {
+  if(fd >= 0) {
+    ::close(fd);
+  }
+
+  fd = -1;
+}
+
+size_t WiFiClient::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+
+  while(fd >= 0 && written < size) {
+    const ssize_t result = ::send(fd, buffer + written, size - written, MSG_NOSIGNAL);
+
+    if(result <= 0) {
+      break;
+    }
+
+    written += result;
+  }
+
+  return written;
+}
+
+size_t WiFiClient::availableForWrite() {
+  if(fd < 0) {
+    return 0;
+  }
+
+  struct pollfd writable = { fd, POLLOUT, 0 };
+
+  // The device reports the free space in its send buffer; the size of a TCP segment is close enough.
+  return (::poll(&writable, 1, 0) == 1 && (writable.revents & POLLOUT)) ? 1460 : 0;
+}
+
+int WiFiClient::available() {
+  int bytes = 0;
+
+  if(fd < 0 || ::ioctl(fd, FIONREAD, &bytes) < 0) {
+    return 0;
+  }
+
+  return bytes;
+}
+
+int WiFiClient::read() {
+  uint8_t byte;
+
+  return (read(&byte, 1) == 1) ? byte : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size) {
+  if(fd < 0) {
+    return -1;
+  }
+
+  const ssize_t result = ::recv(fd, buffer, size, MSG_DONTWAIT);
+
+  return (result > 0) ? (int) result : -1;
+}
+
+int WiFiClient::peek() {
+  uint8_t byte;
+
+  if(fd < 0 || ::recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+    return -1;
+  }
+
+  return byte;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+  const int value = noDelay ? 1 : 0;
+
+  if(fd >= 0) {
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+  }
+}
+
+IPAddress WiFiClient::remoteIP() const {
+  struct sockaddr_in peer = {};
+  socklen_t length = sizeof(peer);
+
+  if(fd < 0 || ::getpeername(fd, (struct sockaddr *) &peer, &length) < 0) {
+    return IPAddress();
+  }
+
+  return IPAddress((uint32_t) peer.sin_addr.s_addr);
+}
@@ -0,0 +1,52 @@
+/*
+ * WiFiClient.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_WIFICLIENT
+  #define _C1MOORE_TEST_CORE_WIFICLIENT
+
+  #include "IPAddress.h"
+  #include "Stream.h"
+
+  /**
+   * WiFiClient is a TCP connection backed by a POSIX socket.  Like the ESP8266 core, `connect()` and `write()` block for at most
+   * the Stream timeout, reads never block, and the client still reports itself connected while received bytes are left to read
+   * after the peer closed the connection.  A client cannot be copied; the libraries only ever keep one per connection.
+   */
+  class WiFiClient: public Stream {
+    public:
+      WiFiClient();
+      ~WiFiClient();
+
+      WiFiClient(const WiFiClient &) = delete;
+      WiFiClient &operator=(const WiFiClient &) = delete;
+
+      int connect(IPAddress address, uint16_t port);
+      int connect(const char *host, uint16_t port);
+      uint8_t connected();
+      void stop();
+
+      size_t write(uint8_t byte);
+      size_t write(const uint8_t *buffer, size_t size);
+      size_t availableForWrite();
+
+      int available();
+      int read();
+      int read(uint8_t *buffer, size_t size);
+      int peek();
+
+      void setNoDelay(bool noDelay);
+
+      IPAddress remoteIP() const;
+
+      operator bool() {
+        return connected();
+      }
+
+    private:
+      int fd;
+  };
+
+#endif /* _C1MOORE_TEST_CORE_WIFICLIENT */
@@ -0,0 +1,157 @@
+/*
+ * WiFiUdp.cpp
+ *
+ *      Author: c1moore
+ */
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "WiFiUdp.h"
+
+WiFiUDP::WiFiUDP(): fd(-1), destinationPort(0), receivedLength(0), receivedRead(0), sourcePort(0) { }
+
+WiFiUDP::~WiFiUDP() {
+  stop();
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  stop();
+
+  fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+  if(fd < 0) {
+    return 0;
+  }
+
+  struct sockaddr_in local = {};
+
+  local.sin_family = AF_INET;
+  local.sin_port = htons(port);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if(::bind(fd, (struct sockaddr *) &local, sizeof(local)) < 0) {
+    stop();
+
+    return 0;
+  }
+
+  return 1;
+}
+
+void WiFiUDP::stop() {
+  if(fd >= 0) {
+    ::close(fd);
+  }
+
+  fd = -1;
+  receivedLength = 0;
+  receivedRead = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port) {
+  if(fd < 0) {
+    return 0;
+  }
+
+  destination = address;
+  destinationPort = port;
+  outgoing.clear();
+
+  return 1;
+}
+
+int WiFiUDP::endPacket() {
+  if(fd < 0) {
+    return 0;
+  }
+
+  struct sockaddr_in peer = {};
+
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons(destinationPort);
+  peer.sin_addr.s_addr = (uint32_t) destination;
+
+  const ssize_t result = ::sendto(fd, outgoing.data(), outgoing.size(), 0, (struct sockaddr *) &peer, sizeof(peer));
+
+  return (result == (ssize_t) outgoing.size()) ? 1 : 0;
+}
+
+size_t WiFiUDP::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  outgoing.append((const char *) buffer, size);
+
+  return size;
+}
+
+int WiFiUDP::parsePacket() {
+  receivedLength = 0;
+  receivedRead = 0;
+
+  if(fd < 0) {
+    return 0;
+  }
+
+  struct sockaddr_in peer = {};
+  socklen_t length = sizeof(peer);
+
+  const ssize_t result = ::recvfrom(fd, received, sizeof(received), MSG_DONTWAIT, (struct sockaddr *) &peer, &length);
+
+  if(result <= 0) {
+    return 0;
+  }
+
+  receivedLength = result;
+  source = IPAddress((uint32_t) peer.sin_addr.s_addr);
+  sourcePort = ntohs(peer.sin_port);
+
+  return result;
+}
+
+int WiFiUDP::available() {
+  return receivedLength - receivedRead;
+}
+
+int WiFiUDP::read() {
+  if(receivedRead >= receivedLength) {
+    return -1;
+  }
+
+  return received[receivedRead++];
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+  size_t count = 0;
+
+  while(count < size && receivedRead < receivedLength) {
+    buffer[count++] = received[receivedRead++];
+  }
+
+  return count;
+}
+
+int WiFiUDP::peek() {
+  return (receivedRead < receivedLength) ? received[receivedRead] : -1;
+}
+
+IPAddress WiFiUDP::remoteIP() const {
+  return source;
+}
+
+uint16_t WiFiUDP::remotePort() const {
+  return sourcePort;
+}
+
+uint16_t WiFiUDP::localPort() const {
+  struct sockaddr_in local = {};
+  socklen_t length = sizeof(local);
+
+  if(fd < 0 || ::getsockname(fd, (struct sockaddr *) &local, &length) < 0) {
+    return 0;
+  }
+
+  return ntohs(local.sin_port);
+}
@@ -0,0 +1,62 @@
+/*
+ * WiFiUdp.h
+ *
+ *      Author: c1moore
+ */
+
+#ifndef _C1MOORE_TEST_CORE_WIFIUDP
+  #define _C1MOORE_TEST_CORE_WIFIUDP
+
+  #include <string>
+
+  #include "IPAddress.h"
+  #include "Stream.h"
+
+  // The largest datagram that can be received.
+  #define UDP_RECEIVE_BUFFER 1472
+
+  /**
+   * WiFiUDP is a UDP socket backed by a POSIX socket.  Like the ESP8266 core, a datagram is written between `beginPacket()` and
+   * `endPacket()`, and `parsePacket()` receives the next datagram, without waiting, so it can be read like a Stream.
+   */
+  class WiFiUDP: public Stream {
+    public:
+      WiFiUDP();
+      ~WiFiUDP();
+
+      WiFiUDP(const WiFiUDP &) = delete;
+      WiFiUDP &operator=(const WiFiUDP &) = delete;
+
+      uint8_t begin(uint16_t port);
+      void stop();
+
+      int beginPacket(IPAddress address, uint16_t port);
+      int endPacket();
+      size_t write(uint8_t byte);
+      size_t write(const uint8_t *buffer, size_t size);
+
+      int parsePacket();
+      int available();
+      int read();
+      int read(uint8_t *buffer, size_t size);
+      int peek();
+
+      IPAddress remoteIP() const;
+      uint16_t remotePort() const;
+      uint16_t localPort() const;
+
+    private:
+      int fd;
+
+      IPAddress destination;
+      uint16_t destinationPort;
+      std::string outgoing;
+
+      uint8_t received[UDP_RECEIVE_BUFFER];
+      size_t receivedLength;
+      size_t receivedRead;
+      IPAddress source;
+      uint16_t sourcePort;
+  };
+
+#endif /* _C1MOORE_TEST_CORE_WIFIUDP */